@@ -0,0 +1,383 @@
+#include "curl_multi_engine.h"
+
+#include <curl/curl.h>
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 事件循环单次等待的最长时间（毫秒），也是取消请求的最大响应延迟
+static const int kPollTimeoutMs = 100;
+
+// ============================================================================
+// 引擎共享状态（事件循环线程与提交/取消线程共用）
+// ============================================================================
+
+struct HttpRequestHandle::Core {
+  using Finished = std::vector<std::pair<std::shared_ptr<CurlTransfer>, CURLcode>>;
+
+  CURLM* multi = nullptr;
+  CurlMultiEngine::Options options;
+
+  std::mutex mutex;
+  std::deque<std::shared_ptr<CurlTransfer>> queue;  // 受 mutex 保护
+  std::atomic<bool> stopping{false};
+
+  // 以下仅由驱动事件循环的线程访问
+  std::unordered_map<CURL*, std::shared_ptr<CurlTransfer>> active;
+  Finished finished;
+
+  // 外部事件循环模式
+  std::atomic<std::thread::id> loopThread{};
+  std::map<int, int> sockets;  // fd -> CURL_POLL_*，仅驱动线程访问
+  CurlMultiEngine::WatchCallback watchCallback;
+  CurlMultiEngine::TimerCallback timerCallback;
+  bool hasDeadline = false;  // 受 mutex 保护
+  std::chrono::steady_clock::time_point deadline;
+
+  ~Core() {
+    if (multi) {
+      curl_multi_cleanup(multi);
+    }
+  }
+
+  void wakeup() {
+    if (options.externalLoop) {
+      requestTimeout(0);
+    } else if (multi) {
+      curl_multi_wakeup(multi);
+    }
+  }
+
+  // 外部事件循环模式：记录定时器时限并通知使用方
+  void requestTimeout(long timeoutMs) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      hasDeadline = timeoutMs >= 0;
+      if (hasDeadline) {
+        deadline = std::chrono::steady_clock::now() +
+                   std::chrono::milliseconds(timeoutMs);
+      }
+    }
+    if (timerCallback) {
+      timerCallback(timeoutMs);
+    }
+  }
+
+  // 从等待队列取入传输，直到达到并发上限
+  // （加入 curl_multi 时不持有 mutex：外部事件循环模式下会同步触发定时器回调）
+  void admitQueued() {
+    std::vector<std::shared_ptr<CurlTransfer>> admitted;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      while (!queue.empty() &&
+             active.size() + admitted.size() < options.maxInFlight) {
+        std::shared_ptr<CurlTransfer> transfer = std::move(queue.front());
+        queue.pop_front();
+
+        if (transfer->cancelled.load()) {
+          finished.emplace_back(std::move(transfer), CURLE_ABORTED_BY_CALLBACK);
+          continue;
+        }
+        admitted.push_back(std::move(transfer));
+      }
+    }
+
+    for (auto& transfer : admitted) {
+      CURL* easy = transfer->easy;
+      curl_multi_add_handle(multi, easy);
+      active.emplace(easy, std::move(transfer));
+    }
+  }
+
+  // 移除已取消的传输
+  void removeCancelled() {
+    for (auto it = active.begin(); it != active.end();) {
+      if (it->second->cancelled.load()) {
+        curl_multi_remove_handle(multi, it->first);
+        finished.emplace_back(std::move(it->second), CURLE_ABORTED_BY_CALLBACK);
+        it = active.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  // 收集已结束的传输
+  void collectDone() {
+    int remaining = 0;
+    while (CURLMsg* msg = curl_multi_info_read(multi, &remaining)) {
+      if (msg->msg != CURLMSG_DONE) continue;
+
+      auto it = active.find(msg->easy_handle);
+      if (it == active.end()) continue;
+
+      curl_multi_remove_handle(multi, msg->easy_handle);
+      finished.emplace_back(std::move(it->second), msg->data.result);
+      active.erase(it);
+    }
+  }
+
+  // 停止：所有未完成的传输以取消结束
+  void abortAll() {
+    for (auto& item : active) {
+      curl_multi_remove_handle(multi, item.first);
+      finished.emplace_back(std::move(item.second), CURLE_ABORTED_BY_CALLBACK);
+    }
+    active.clear();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& transfer : queue) {
+      finished.emplace_back(std::move(transfer), CURLE_ABORTED_BY_CALLBACK);
+    }
+    queue.clear();
+  }
+
+  // curl_multi socket-action 回调（外部事件循环模式）
+  static int onCurlSocket(CURL* /*easy*/, curl_socket_t fd, int what,
+                            void* userp, void* /*socketp*/) {
+    auto* core = static_cast<Core*>(userp);
+    int sock = static_cast<int>(fd);
+
+    if (what == CURL_POLL_REMOVE) {
+      core->sockets.erase(sock);
+    } else {
+      core->sockets[sock] = what;
+    }
+
+    if (core->watchCallback) {
+      core->watchCallback(sock, what == CURL_POLL_IN || what == CURL_POLL_INOUT,
+                          what == CURL_POLL_OUT || what == CURL_POLL_INOUT);
+    }
+    return 0;
+  }
+
+  static int onCurlTimer(CURLM* /*multi*/, long timeoutMs, void* userp) {
+    static_cast<Core*>(userp)->requestTimeout(timeoutMs);
+    return 0;
+  }
+
+  // 通知完成（不持有任何锁；回调中可能提交新的传输）
+  void notifyFinished() {
+    Finished done;
+    done.swap(finished);
+    for (auto& item : done) {
+      item.first->done.store(true);
+      item.first->complete(item.second);
+    }
+  }
+};
+
+// ============================================================================
+// HttpRequestHandle 实现
+// ============================================================================
+
+void HttpRequestHandle::cancel() {
+  if (!m_transfer || m_transfer->done.load()) {
+    return;
+  }
+
+  m_transfer->cancelled.store(true);
+  m_transfer->cancelRequested();
+
+  // 唤醒事件循环，尽快移除该传输
+  if (std::shared_ptr<Core> core = m_core.lock()) {
+    core->wakeup();
+  }
+}
+
+bool HttpRequestHandle::isDone() const {
+  return m_transfer && m_transfer->done.load();
+}
+
+// ============================================================================
+// CurlMultiEngine 实现
+// ============================================================================
+
+CurlMultiEngine::CurlMultiEngine(const Options& options)
+    : m_core(std::make_shared<Core>()) {
+  m_core->options = options;
+  m_core->multi = curl_multi_init();
+
+  if (m_core->multi) {
+    // HTTP/2 多路复用：同一主机的并发请求共用一个连接
+    curl_multi_setopt(m_core->multi, CURLMOPT_PIPELINING,
+                      options.multiplex ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+    curl_multi_setopt(m_core->multi, CURLMOPT_MAX_CONCURRENT_STREAMS,
+                      options.maxConcurrentStreams);
+
+    if (options.externalLoop) {
+      curl_multi_setopt(m_core->multi, CURLMOPT_SOCKETFUNCTION,
+                        &Core::onCurlSocket);
+      curl_multi_setopt(m_core->multi, CURLMOPT_SOCKETDATA, m_core.get());
+      curl_multi_setopt(m_core->multi, CURLMOPT_TIMERFUNCTION,
+                        &Core::onCurlTimer);
+      curl_multi_setopt(m_core->multi, CURLMOPT_TIMERDATA, m_core.get());
+    } else {
+      m_thread = std::thread(&CurlMultiEngine::run, m_core);
+    }
+  }
+}
+
+// 共享引擎参数与实例
+static std::mutex s_sharedMutex;
+static CurlMultiEngine::Options s_sharedOptions;
+
+std::shared_ptr<CurlMultiEngine> CurlMultiEngine::shared() {
+  std::lock_guard<std::mutex> lock(s_sharedMutex);
+  static std::shared_ptr<CurlMultiEngine> engine =
+      std::make_shared<CurlMultiEngine>(s_sharedOptions);
+  return engine;
+}
+
+void CurlMultiEngine::setSharedOptions(const Options& options) {
+  std::lock_guard<std::mutex> lock(s_sharedMutex);
+  s_sharedOptions = options;
+  // 共享引擎总是自带事件循环线程
+  s_sharedOptions.externalLoop = false;
+}
+
+void CurlMultiEngine::wakeup() { m_core->wakeup(); }
+
+CurlMultiEngine::~CurlMultiEngine() {
+  m_core->stopping.store(true);
+
+  if (m_thread.joinable()) {
+    m_core->wakeup();
+    if (m_thread.get_id() == std::this_thread::get_id()) {
+      // 在完成回调中析构（例如回调中析构了持有私有引擎的客户端）：
+      // 线程持有 Core，当前回调返回后自行结束剩余传输并退出
+      m_thread.detach();
+    } else {
+      m_thread.join();
+    }
+  } else if (m_core->multi) {
+    // 外部事件循环模式：在析构线程结束剩余传输，此后不再通知使用方的事件循环
+    m_core->watchCallback = nullptr;
+    m_core->timerCallback = nullptr;
+    m_core->abortAll();
+    m_core->notifyFinished();
+  }
+}
+
+bool CurlMultiEngine::isLoopThread() const {
+  std::thread::id current = std::this_thread::get_id();
+  if (m_core->options.externalLoop) {
+    return current == m_core->loopThread.load();
+  }
+  return current == m_thread.get_id();
+}
+
+HttpRequestHandle CurlMultiEngine::submit(
+    std::shared_ptr<CurlTransfer> transfer) {
+  if (!transfer || !transfer->easy || !m_core->multi) {
+    return HttpRequestHandle();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_core->mutex);
+    if (m_core->stopping.load() ||
+        m_core->queue.size() >= m_core->options.maxQueued) {
+      return HttpRequestHandle();
+    }
+    m_core->queue.push_back(transfer);
+  }
+
+  m_core->wakeup();
+  return HttpRequestHandle(std::move(transfer), m_core);
+}
+
+void CurlMultiEngine::run(std::shared_ptr<Core> owner) {
+  Core& core = *owner;
+
+  while (!core.stopping.load()) {
+    core.admitQueued();
+    core.removeCancelled();
+
+    // 驱动所有传输
+    int running = 0;
+    curl_multi_perform(core.multi, &running);
+
+    core.collectDone();
+    core.notifyFinished();
+
+    // 等待网络事件、新提交或取消
+    curl_multi_poll(core.multi, nullptr, 0, kPollTimeoutMs, nullptr);
+  }
+
+  core.abortAll();
+  core.notifyFinished();
+}
+
+// ============================================================================
+// 外部事件循环模式
+// ============================================================================
+
+bool CurlMultiEngine::isExternalLoop() const {
+  return m_core->options.externalLoop;
+}
+
+void CurlMultiEngine::setEventLoopCallbacks(WatchCallback watch,
+                                            TimerCallback timer) {
+  m_core->watchCallback = std::move(watch);
+  m_core->timerCallback = std::move(timer);
+}
+
+std::vector<CurlMultiEngine::SocketWatch> CurlMultiEngine::watchedSockets()
+    const {
+  std::vector<SocketWatch> result;
+  result.reserve(m_core->sockets.size());
+  for (const auto& item : m_core->sockets) {
+    int what = item.second;
+    result.push_back({item.first, what == CURL_POLL_IN || what == CURL_POLL_INOUT,
+                      what == CURL_POLL_OUT || what == CURL_POLL_INOUT});
+  }
+  return result;
+}
+
+long CurlMultiEngine::timeoutMs() const {
+  std::lock_guard<std::mutex> lock(m_core->mutex);
+  if (!m_core->hasDeadline) {
+    return -1;
+  }
+
+  auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+      m_core->deadline - std::chrono::steady_clock::now());
+  return remaining.count() > 0 ? static_cast<long>(remaining.count()) : 0;
+}
+
+void CurlMultiEngine::onReadable(int fd) { onSocketAction(fd, CURL_CSELECT_IN); }
+
+void CurlMultiEngine::onWritable(int fd) { onSocketAction(fd, CURL_CSELECT_OUT); }
+
+void CurlMultiEngine::onTimeout() {
+  {
+    std::lock_guard<std::mutex> lock(m_core->mutex);
+    m_core->hasDeadline = false;
+  }
+  onSocketAction(static_cast<int>(CURL_SOCKET_TIMEOUT), 0);
+}
+
+void CurlMultiEngine::onSocketAction(int fd, int eventMask) {
+  // 完成回调中可能析构引擎本身，保持 Core 直到本次调用结束
+  std::shared_ptr<Core> owner = m_core;
+  Core& core = *owner;
+  if (!core.multi || !core.options.externalLoop) {
+    return;
+  }
+  core.loopThread.store(std::this_thread::get_id());
+
+  core.admitQueued();
+  core.removeCancelled();
+
+  int running = 0;
+  curl_multi_socket_action(core.multi, static_cast<curl_socket_t>(fd),
+                           eventMask, &running);
+
+  core.collectDone();
+  core.notifyFinished();
+}
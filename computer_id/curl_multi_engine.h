@@ -0,0 +1,192 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// curl_multi 事件循环中的一个传输
+/// 由使用方派生，在 easy 句柄上配置好请求后提交给 CurlMultiEngine
+/// </summary>
+struct CurlTransfer {
+  virtual ~CurlTransfer() = default;
+
+  /// <summary>
+  /// 传输结束（完成、失败或取消），在事件循环线程调用且只调用一次
+  /// </summary>
+  /// <param name="curlCode">CURLcode，取消时为 CURLE_ABORTED_BY_CALLBACK</param>
+  virtual void complete(int curlCode) = 0;
+
+  /// <summary>
+  /// HttpRequestHandle::cancel() 设置 cancelled 之后调用（任意线程）
+  /// 不由 CurlMultiEngine 驱动的传输在此唤醒自己的调度
+  /// </summary>
+  virtual void cancelRequested() {}
+
+  void* easy = nullptr;  // CURL*
+  std::atomic<bool> cancelled{false};
+  std::atomic<bool> done{false};
+};
+
+/// <summary>
+/// 异步请求句柄，用于查询状态或取消请求
+/// 句柄可以比引擎活得更久，此时 cancel() 不再有任何效果
+/// </summary>
+class HttpRequestHandle {
+ public:
+  HttpRequestHandle() = default;
+
+  /// <summary>
+  /// 不属于 CurlMultiEngine 的传输（如进程内传输）创建的句柄：
+  /// cancel() 设置取消标志后调用 transfer->cancelRequested()
+  /// </summary>
+  explicit HttpRequestHandle(std::shared_ptr<CurlTransfer> transfer)
+      : m_transfer(std::move(transfer)) {}
+
+  /// <summary>
+  /// 取消请求（已结束的请求不受影响）
+  /// 被取消的请求仍会回调一次，Response::error 为 "Request cancelled"
+  /// </summary>
+  void cancel();
+
+  /// <summary>
+  /// 请求是否已经结束
+  /// </summary>
+  bool isDone() const;
+
+  /// <summary>
+  /// 是否关联了一个已提交的请求
+  /// </summary>
+  bool isValid() const { return m_transfer != nullptr; }
+
+ private:
+  friend class CurlMultiEngine;
+  struct Core;
+
+  HttpRequestHandle(std::shared_ptr<CurlTransfer> transfer,
+                    std::weak_ptr<Core> core)
+      : m_transfer(std::move(transfer)), m_core(std::move(core)) {}
+
+  std::shared_ptr<CurlTransfer> m_transfer;
+  std::weak_ptr<Core> m_core;
+};
+
+/// <summary>
+/// 基于 curl_multi 的异步请求引擎
+/// 单个事件循环线程驱动所有传输，同时执行的传输数与等待队列长度均有上限
+///
+/// 外部事件循环模式（Options::externalLoop）下引擎不创建线程，改为 socket-action
+/// 方式由使用方的 epoll/kqueue/select 循环驱动：
+///   1. setEventLoopCallbacks 注册回调，得知需要监听的套接字及其读写兴趣、定时器时限
+///      （也可随时用 watchedSockets / timeoutMs 查询当前状态）
+///   2. 套接字可读/可写时调用 onReadable / onWritable，定时器到期时调用 onTimeout
+/// 入口函数、套接字回调与完成回调都在驱动循环的线程执行
+/// </summary>
+class CurlMultiEngine {
+ public:
+  struct Options {
+    size_t maxInFlight = 64;  // 同时在 curl_multi 中执行的传输数
+    size_t maxQueued = 4096;  // 等待队列上限，超出时拒绝提交
+    bool multiplex = true;    // 在同一 HTTP/2 连接上复用并发请求
+    long maxConcurrentStreams = 100;  // 每个 HTTP/2 连接的最大并发流数
+    bool externalLoop = false;  // 由使用方的事件循环驱动，不创建线程
+  };
+
+  /// <summary>
+  /// 需要监听的套接字（外部事件循环模式）
+  /// </summary>
+  struct SocketWatch {
+    int fd;
+    bool readable;  // 关注可读
+    bool writable;  // 关注可写
+  };
+
+  /// <summary>
+  /// 套接字兴趣变化：readable 与 writable 均为 false 表示停止监听该套接字
+  /// 在驱动循环的线程调用，回调中只应更新监听集合，不能调用引擎的入口函数
+  /// </summary>
+  using WatchCallback = std::function<void(int fd, bool readable, bool writable)>;
+
+  /// <summary>
+  /// 定时器变化：timeoutMs 毫秒后应调用 onTimeout，-1 表示取消定时器
+  /// 提交或取消请求时也会以 0 调用，且可能来自其他线程，
+  /// 因此回调需线程安全（例如写 eventfd 唤醒 epoll_wait）
+  /// </summary>
+  using TimerCallback = std::function<void(long timeoutMs)>;
+
+  explicit CurlMultiEngine(const Options& options);
+
+  /// <summary>
+  /// 停止事件循环，未完成的传输均以取消结束
+  /// </summary>
+  ~CurlMultiEngine();
+
+  CurlMultiEngine(const CurlMultiEngine&) = delete;
+  CurlMultiEngine& operator=(const CurlMultiEngine&) = delete;
+
+  /// <summary>
+  /// 进程级共享引擎（首次调用时创建，进程退出时停止）
+  /// 所有共享它的客户端使用同一个连接池，短生命周期的客户端也能复用连接
+  /// </summary>
+  static std::shared_ptr<CurlMultiEngine> shared();
+
+  /// <summary>
+  /// 设置共享引擎的参数（需在首次调用 shared() 之前设置）
+  /// </summary>
+  static void setSharedOptions(const Options& options);
+
+  /// <summary>
+  /// 提交传输（线程安全）
+  /// 等待队列已满或引擎已停止时返回无效句柄，此时 transfer 不会被 complete
+  /// </summary>
+  HttpRequestHandle submit(std::shared_ptr<CurlTransfer> transfer);
+
+  /// <summary>
+  /// 当前线程是否为事件循环线程（在回调中同步等待会造成死锁）
+  /// 外部事件循环模式下为最近一次调用事件入口的线程
+  /// </summary>
+  bool isLoopThread() const;
+
+  /// <summary>
+  /// 唤醒事件循环（例如在设置了若干传输的 cancelled 标志之后）
+  /// </summary>
+  void wakeup();
+
+  // ===== 外部事件循环模式 =====
+
+  bool isExternalLoop() const;
+
+  /// <summary>
+  /// 注册监听与定时器回调（须在提交第一个请求之前调用）
+  /// </summary>
+  void setEventLoopCallbacks(WatchCallback watch, TimerCallback timer);
+
+  /// <summary>
+  /// 当前需要监听的套接字
+  /// </summary>
+  std::vector<SocketWatch> watchedSockets() const;
+
+  /// <summary>
+  /// 距下次应调用 onTimeout 的毫秒数，-1 表示没有定时器
+  /// </summary>
+  long timeoutMs() const;
+
+  /// <summary>
+  /// 事件入口：驱动传输并在当前线程回调已结束的传输（不能在完成回调中调用）
+  /// </summary>
+  void onReadable(int fd);
+  void onWritable(int fd);
+  void onTimeout();
+
+ private:
+  using Core = HttpRequestHandle::Core;
+
+  std::shared_ptr<Core> m_core;
+  std::thread m_thread;
+
+  static void run(std::shared_ptr<Core> owner);
+  void onSocketAction(int fd, int eventMask);
+};
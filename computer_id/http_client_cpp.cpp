@@ -2,184 +2,2111 @@
 
 #include <curl/curl.h>
 
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <random>
 #include <sstream>
 #include <thread>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 由构建系统在找到并链接 zlib 时定义（只检测头文件可能链接失败）
+#ifdef HTTP_CLIENT_HAS_ZLIB
+#include <zlib.h>
+#endif
+
 #include "secure_transport_cpp.h"
 
-// libcurl 回调函数
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb,
-                            void* userp) {
-  ((std::string*)userp)->append((char*)contents, size * nmemb);
-  return size * nmemb;
+#if LIBCURL_VERSION_NUM < 0x080c00
+#include <openssl/ssl.h>
+#endif
+
+// libcurl 全局初始化：每个进程只执行一次，进程退出时清理
+static void ensureCurlGlobalInit() {
+  static struct CurlGlobal {
+    CurlGlobal() { curl_global_init(CURL_GLOBAL_DEFAULT); }
+    ~CurlGlobal() { curl_global_cleanup(); }
+  } global;
 }
 
-static size_t HeaderCallback(char* buffer, size_t size, size_t nitems,
-                             void* userdata) {
-  size_t numbytes = size * nitems;
-  std::string header(buffer, numbytes);
+// ============================================================================
+// 进程级共享缓存（curl share：DNS 缓存与 TLS 会话缓存）
+// ============================================================================
+
+// 连接缓存不放入 share 句柄（libcurl 不支持跨线程并发共享连接），
+// 而是由进程级的 CurlMultiEngine 统一持有
+class CurlSharedCache {
+ public:
+  static CURLSH* handle() {
+    static CurlSharedCache cache;
+    return cache.m_share;
+  }
+
+ private:
+  CURLSH* m_share;
+  std::mutex m_locks[CURL_LOCK_DATA_LAST];
 
-  auto* headers = static_cast<std::map<std::string, std::string>*>(userdata);
+  CurlSharedCache() : m_share(curl_share_init()) {
+    if (!m_share) return;
 
-  size_t separator = header.find(':');
-  if (separator != std::string::npos) {
-    std::string key = header.substr(0, separator);
-    std::string value = header.substr(separator + 1);
+    curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, lockCallback);
+    curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, unlockCallback);
+    curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  }
+
+  ~CurlSharedCache() {
+    if (m_share) {
+      curl_share_cleanup(m_share);
+    }
+  }
 
-    // 去除空格
-    value.erase(0, value.find_first_not_of(" \t\r\n"));
-    value.erase(value.find_last_not_of(" \t\r\n") + 1);
+  static void lockCallback(CURL*, curl_lock_data data, curl_lock_access,
+                           void* userptr) {
+    static_cast<CurlSharedCache*>(userptr)->m_locks[data].lock();
+  }
 
-    (*headers)[key] = value;
+  static void unlockCallback(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<CurlSharedCache*>(userptr)->m_locks[data].unlock();
   }
+};
+
+#if LIBCURL_VERSION_NUM < 0x080c00
+
+// ============================================================================
+// TLS 会话表（libcurl 8.12 以下没有会话导出接口，磁盘缓存经由此表读写）
+// ============================================================================
+
+// 主机 -> 最近一次握手得到的会话（DER 编码）
+class TlsSessionStore {
+ public:
+  struct Entry {
+    std::string der;
+    int64_t expires = 0;
+  };
+
+  static TlsSessionStore& instance() {
+    static TlsSessionStore store;
+    return store;
+  }
+
+  // libcurl 使用 OpenSSL 后端时才能挂接（SSL_CTX 指针的类型由后端决定）
+  static bool available() {
+    static const bool openssl = [] {
+      const curl_version_info_data* info = curl_version_info(CURLVERSION_NOW);
+      return info && info->ssl_version &&
+             std::strncmp(info->ssl_version, "OpenSSL", 7) == 0;
+    }();
+    return openssl;
+  }
+
+  void put(const std::string& host, Entry entry) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[host] = std::move(entry);
+  }
+
+  bool get(const std::string& host, Entry& entry) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(host);
+    if (it == m_entries.end()) return false;
+    entry = it->second;
+    return true;
+  }
+
+  std::map<std::string, Entry> entries() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries;
+  }
+
+  // CURLOPT_SSL_CTX_FUNCTION：libcurl 为新连接创建 SSL_CTX 之后调用
+  // userptr 为请求的 "主机:端口"（存活到请求结束）
+  static CURLcode onSslContext(CURL*, void* sslctx, void* userptr) {
+    SSL_CTX* ctx = static_cast<SSL_CTX*>(sslctx);
+    auto* data = new ContextData();
+    data->host = *static_cast<const std::string*>(userptr);
+    // libcurl 自己的新会话回调（写入内存会话缓存），由本回调转发
+    data->curlNewSession = SSL_CTX_sess_get_new_cb(ctx);
+    SSL_CTX_set_ex_data(ctx, contextIndex(), data);
+
+    SSL_CTX_set_session_cache_mode(
+        ctx, SSL_CTX_get_session_cache_mode(ctx) | SSL_SESS_CACHE_CLIENT |
+                 SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, onNewSession);
+    SSL_CTX_set_info_callback(ctx, onInfo);
+    return CURLE_OK;
+  }
+
+ private:
+  struct ContextData {
+    std::string host;
+    int (*curlNewSession)(SSL*, SSL_SESSION*) = nullptr;
+  };
+
+  mutable std::mutex m_mutex;
+  std::map<std::string, Entry> m_entries;
 
-  return numbytes;
+  static void freeContextData(void*, void* ptr, CRYPTO_EX_DATA*, int, long,
+                              void*) {
+    delete static_cast<ContextData*>(ptr);
+  }
+
+  static int contextIndex() {
+    static const int index =
+        SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, freeContextData);
+    return index;
+  }
+
+  static ContextData* contextData(SSL* ssl) {
+    return static_cast<ContextData*>(
+        SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), contextIndex()));
+  }
+
+  static int onNewSession(SSL* ssl, SSL_SESSION* session) {
+    ContextData* data = contextData(ssl);
+    if (!data) return 0;
+
+    int length = i2d_SSL_SESSION(session, nullptr);
+    if (length > 0) {
+      Entry entry;
+      entry.der.resize(static_cast<size_t>(length));
+      unsigned char* out = reinterpret_cast<unsigned char*>(&entry.der[0]);
+      i2d_SSL_SESSION(session, &out);
+      entry.expires = static_cast<int64_t>(SSL_SESSION_get_time(session)) +
+                      static_cast<int64_t>(SSL_SESSION_get_timeout(session));
+      instance().put(data->host, std::move(entry));
+    }
+    return data->curlNewSession ? data->curlNewSession(ssl, session) : 0;
+  }
+
+  // 首次握手开始时 libcurl 的内存缓存中没有该主机的会话：使用磁盘恢复的会话
+  static void onInfo(const SSL* constSsl, int where, int) {
+    if (!(where & SSL_CB_HANDSHAKE_START)) return;
+    SSL* ssl = const_cast<SSL*>(constSsl);
+    if (SSL_get_session(ssl) != nullptr) return;
+
+    ContextData* data = contextData(ssl);
+    Entry entry;
+    if (!data || !instance().get(data->host, entry)) return;
+    if (entry.expires < static_cast<int64_t>(std::time(nullptr))) return;
+
+    const unsigned char* in =
+        reinterpret_cast<const unsigned char*>(entry.der.data());
+    SSL_SESSION* session =
+        d2i_SSL_SESSION(nullptr, &in, static_cast<long>(entry.der.size()));
+    if (session) {
+      SSL_set_session(ssl, session);
+      SSL_SESSION_free(session);
+    }
+  }
+};
+
+// URL 中的 "主机:端口"（只处理 https，其他协议返回空）
+static std::string tlsSessionHost(const std::string& url) {
+  static const char kScheme[] = "https://";
+  if (url.size() < sizeof(kScheme) - 1 ||
+      !std::equal(kScheme, kScheme + sizeof(kScheme) - 1, url.begin(),
+                  [](char a, char b) {
+                    return a == std::tolower(static_cast<unsigned char>(b));
+                  })) {
+    return std::string();
+  }
+  size_t start = sizeof(kScheme) - 1;
+  size_t end = url.find_first_of("/?#", start);
+  std::string host = url.substr(start, end == std::string::npos
+                                           ? std::string::npos
+                                           : end - start);
+  size_t at = host.rfind('@');
+  if (at != std::string::npos) host.erase(0, at + 1);
+  size_t bracket = host.rfind(']');
+  size_t colon = host.rfind(':');
+  if (colon == std::string::npos ||
+      (bracket != std::string::npos && colon < bracket)) {
+    host += ":443";
+  }
+  for (char& c : host) {
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+  return host;
+}
+
+#endif
+
+// 每个句柄池分片最多保留的空闲句柄数量（每个句柄持有自己的连接缓存）
+static const size_t kMaxIdleHandlesPerShard = 2;
+
+// 按 Content-Length 预留响应体的上限（防止异常的长度值造成巨量分配）
+static const curl_off_t kMaxBodyReserve = 16 * 1024 * 1024;
+
+// 每个配置快照最多缓存的请求头链表数量（按请求自身的请求头组合区分）
+static const size_t kMaxCachedHeaderLists = 16;
+
+// 请求自身请求头的哈希（FNV-1a，逐字节计算，不分配内存）
+static uint64_t hashRequestHeaders(
+    const std::map<std::string, std::string>& headers, bool compressed) {
+  uint64_t hash = 14695981039346656037ULL;
+  auto mix = [&hash](const std::string& text) {
+    for (unsigned char c : text) {
+      hash ^= c;
+      hash *= 1099511628211ULL;
+    }
+    hash ^= 0xff;  // 分隔符：避免 "ab"+"c" 与 "a"+"bc" 相同
+    hash *= 1099511628211ULL;
+  };
+  for (const auto& header : headers) {
+    mix(header.first);
+    mix(header.second);
+  }
+  return compressed ? ~hash : hash;
+}
+
+// 配置快照：请求头链表在首次使用时构建，配置变化时随快照一起重建
+struct HttpClientCpp::Snapshot {
+  Options options;
+
+  // 已构建的链表只追加、不修改：查找时按哈希比较，不加锁、不分配内存；
+  // 互斥锁只在构建新链表时使用
+  struct HeaderListEntry {
+    uint64_t hash = 0;
+    bool compressed = false;
+    std::map<std::string, std::string> requestHeaders;  // 哈希碰撞时比较
+    std::shared_ptr<struct curl_slist> list;
+  };
+  mutable std::mutex headerMutex;
+  mutable HeaderListEntry headerLists[kMaxCachedHeaderLists];
+  mutable std::atomic<size_t> headerListCount{0};
+
+  // 默认请求头与本次请求的请求头合并后的链表（同名时以请求的为准）
+  std::shared_ptr<struct curl_slist> headerList(
+      const std::map<std::string, std::string>& requestHeaders,
+      bool compressed) const {
+    uint64_t hash = hashRequestHeaders(requestHeaders, compressed);
+    const HeaderListEntry* found = findHeaderList(
+        hash, compressed, requestHeaders,
+        headerListCount.load(std::memory_order_acquire));
+    if (found) return found->list;
+
+    struct curl_slist* list = nullptr;
+    for (const auto& header : options.headers) {
+      if (requestHeaders.count(header.first)) continue;
+      std::string line = header.first + ": " + header.second;
+      list = curl_slist_append(list, line.c_str());
+    }
+    for (const auto& header : requestHeaders) {
+      std::string line = header.first + ": " + header.second;
+      list = curl_slist_append(list, line.c_str());
+    }
+    if (compressed) {
+      list = curl_slist_append(list, "Content-Encoding: gzip");
+    }
+
+    std::shared_ptr<struct curl_slist> shared(list, curl_slist_free_all);
+
+    // 其他线程可能已构建了相同的链表；容量用尽后不再缓存
+    std::lock_guard<std::mutex> lock(headerMutex);
+    size_t count = headerListCount.load(std::memory_order_relaxed);
+    found = findHeaderList(hash, compressed, requestHeaders, count);
+    if (found) return found->list;
+    if (count < kMaxCachedHeaderLists) {
+      HeaderListEntry& entry = headerLists[count];
+      entry.hash = hash;
+      entry.compressed = compressed;
+      entry.requestHeaders = requestHeaders;
+      entry.list = shared;
+      headerListCount.store(count + 1, std::memory_order_release);
+    }
+    return shared;
+  }
+
+  const HeaderListEntry* findHeaderList(
+      uint64_t hash, bool compressed,
+      const std::map<std::string, std::string>& requestHeaders,
+      size_t count) const {
+    for (size_t i = 0; i < count; i++) {
+      const HeaderListEntry& entry = headerLists[i];
+      if (entry.hash == hash && entry.compressed == compressed &&
+          entry.requestHeaders == requestHeaders) {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+};
+
+// 当前线程正在执行的完成通知层数与回调所属的闸门
+// （用于识别在回调中析构客户端，此时等待会造成死锁）
+static thread_local int t_completionDepth = 0;
+static thread_local const void* t_activeGate = nullptr;
+
+struct HttpClientCpp::CallbackGate {
+  std::mutex mutex;
+  std::condition_variable idle;
+  size_t running = 0;
+  bool closed = false;
+
+  bool enter() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (closed) return false;
+    running++;
+    return true;
+  }
+
+  void leave() {
+    std::lock_guard<std::mutex> lock(mutex);
+    running--;
+    idle.notify_all();
+  }
+
+  // 在闸门内执行回调（闸门已关闭时丢弃）
+  void run(const ResponseCallback& callback, const Response& response) {
+    if (!enter()) return;
+    const void* previous = t_activeGate;
+    t_activeGate = this;
+    callback(response);
+    t_activeGate = previous;
+    leave();
+  }
+
+  // 关闭闸门并等待其他线程上的回调结束（不等待当前线程所在的回调）
+  void close() {
+    std::unique_lock<std::mutex> lock(mutex);
+    closed = true;
+    size_t self = t_activeGate == this ? 1 : 0;
+    idle.wait(lock, [this, self]() { return running <= self; });
+  }
+};
+
+// 一次 HTTP 传输的全部状态，异步时由事件循环持有直到完成
+struct HttpClientCpp::Transfer : CurlTransfer {
+  HttpClientCpp* client = nullptr;  // 客户端在回调中析构后为空
+  Transfer* prevInFlight = nullptr;  // 客户端进行中链表，受 m_inFlightMutex 保护
+  Transfer* nextInFlight = nullptr;
+  SnapshotPtr snapshot;  // 请求开始时的配置快照
+  size_t poolShard = 0;  // 句柄归还到的池分片
+  std::string requestBody;
+  std::shared_ptr<struct curl_slist> headerList;  // 与快照共享，不逐次重建
+  std::string responseBody;
+  std::string* body = nullptr;  // 响应体写入目标（responseBody 或调用方缓冲区）
+  bool bodyReserved = false;
+  std::string tlsSessionHost;  // TLS 会话表的键（仅低版本 libcurl 使用）
+  Response response;
+
+  // 仅异步请求使用
+  ResponseCallback callback;
+  Executor executor;
+  std::shared_ptr<std::promise<Response>> promise;
+
+  // 响应体写入：首次写入时按 Content-Length 一次性预留
+  static size_t onWrite(char* data, size_t size, size_t nmemb, void* userp) {
+    Transfer* transfer = static_cast<Transfer*>(userp);
+    size_t bytes = size * nmemb;
+
+    if (!transfer->bodyReserved) {
+      transfer->bodyReserved = true;
+      curl_off_t length = -1;
+      if (curl_easy_getinfo(transfer->easy, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,
+                            &length) == CURLE_OK &&
+          length > 0) {
+        transfer->body->reserve(
+            transfer->body->size() +
+            static_cast<size_t>(std::min(length, kMaxBodyReserve)));
+      }
+    }
+
+    transfer->body->append(data, bytes);
+    return bytes;
+  }
+
+  // 响应头只追加到原始头部块，查询时再解析
+  static size_t onHeader(char* data, size_t size, size_t nitems, void* userp) {
+    Transfer* transfer = static_cast<Transfer*>(userp);
+    size_t bytes = size * nitems;
+
+    // 新的状态行（100 Continue 等中间响应之后）：只保留最终响应的头部
+    if (bytes >= 5 && std::memcmp(data, "HTTP/", 5) == 0) {
+      transfer->response.rawHeaders.clear();
+    }
+    transfer->response.rawHeaders.append(data, bytes);
+    return bytes;
+  }
+
+  // 交付结果：同步请求移入 promise，异步请求经闸门交给回调
+  // （entered 为真表示调用方已进入闸门，内联回调不再重复进入）
+  void deliver(const std::shared_ptr<CallbackGate>& gate, bool entered) {
+    if (promise) {
+      promise->set_value(std::move(response));
+      return;
+    }
+    if (!callback) return;
+
+    if (executor) {
+      executor([gate, cb = std::move(callback), r = std::move(response)]() {
+        gate->run(cb, r);
+      });
+    } else if (entered) {
+      const void* previous = t_activeGate;
+      t_activeGate = gate.get();
+      callback(response);
+      t_activeGate = previous;
+    } else {
+      gate->run(callback, response);
+    }
+  }
+
+  void complete(int curlCode) override {
+    t_completionDepth++;
+    if (!client) {
+      // 客户端已析构：只释放句柄，同步等待方以取消结束，不再执行回调
+      curl_easy_cleanup(easy);
+      easy = nullptr;
+      headerList.reset();
+      if (promise) {
+        response.error = "Request cancelled";
+        promise->set_value(std::move(response));
+      }
+    } else {
+      client->finishTransfer(*this, curlCode);
+
+      // 内联回调先进入闸门再移出链表：其他线程上的析构会等待回调结束；
+      // 移出链表之后不能再访问 client（回调中可能析构客户端）
+      std::shared_ptr<CallbackGate> gate = client->m_callbackGate;
+      bool entered = callback && !executor && !promise && gate->enter();
+      client->transferDone(this);
+      client = nullptr;
+      deliver(gate, entered);
+      if (entered) gate->leave();
+    }
+    t_completionDepth--;
+  }
+};
+
+// ============================================================================
+// Response 响应头解析
+// ============================================================================
+
+static bool equalsIgnoreCase(const char* a, size_t length, const std::string& b) {
+  if (length != b.length()) return false;
+  for (size_t i = 0; i < length; i++) {
+    if (std::tolower(static_cast<unsigned char>(a[i])) !=
+        std::tolower(static_cast<unsigned char>(b[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 遍历原始头部块中的每个 "名称: 值" 行（跳过状态行），visit 返回 false 时停止
+template <typename Visitor>
+static void forEachHeader(const std::string& raw, Visitor visit) {
+  size_t pos = 0;
+  while (pos < raw.size()) {
+    size_t end = raw.find('\n', pos);
+    if (end == std::string::npos) end = raw.size();
+
+    size_t separator = raw.find(':', pos);
+    if (separator != std::string::npos && separator < end) {
+      size_t valueStart = separator + 1;
+      size_t valueEnd = end;
+      while (valueStart < valueEnd &&
+             (raw[valueStart] == ' ' || raw[valueStart] == '\t')) {
+        valueStart++;
+      }
+      while (valueEnd > valueStart &&
+             std::isspace(static_cast<unsigned char>(raw[valueEnd - 1]))) {
+        valueEnd--;
+      }
+      if (!visit(raw.data() + pos, separator - pos, raw.data() + valueStart,
+                 valueEnd - valueStart)) {
+        return;
+      }
+    }
+    pos = end + 1;
+  }
+}
+
+std::string HttpClientCpp::Response::header(const std::string& name) const {
+  std::string value;
+  forEachHeader(rawHeaders, [&](const char* key, size_t keyLength,
+                                const char* data, size_t dataLength) {
+    if (!equalsIgnoreCase(key, keyLength, name)) return true;
+    value.assign(data, dataLength);
+    return false;
+  });
+  return value;
+}
+
+std::map<std::string, std::string> HttpClientCpp::Response::headers() const {
+  std::map<std::string, std::string> result;
+  forEachHeader(rawHeaders, [&](const char* key, size_t keyLength,
+                                const char* data, size_t dataLength) {
+    result[std::string(key, keyLength)] = std::string(data, dataLength);
+    return true;
+  });
+  return result;
 }
 
 // ============================================================================
 // HttpClientCpp 实现
 // ============================================================================
 
-HttpClientCpp::HttpClientCpp() : m_timeout(30), m_verifySSL(true) {
-  curl_global_init(CURL_GLOBAL_DEFAULT);
-}
+HttpClientCpp::HttpClientCpp() : HttpClientCpp(Options()) {}
+
+HttpClientCpp::HttpClientCpp(const Options& options)
+    : m_callbackGate(std::make_shared<CallbackGate>()) {
+  ensureCurlGlobalInit();
+
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->options = options;
+  m_snapshot = std::move(snapshot);
+
+  if (options.sharedCache && !options.tlsSessionCacheFile.empty()) {
+    loadTlsSessions(options.tlsSessionCacheFile);
+  }
+}
+
+HttpClientCpp::~HttpClientCpp() {
+  // 先结束本客户端所有未完成的请求（它们在此回调），之后才释放句柄池
+  // 在事件循环的完成回调中析构时无法等待，改为解除关联
+  std::shared_ptr<CurlMultiEngine> engine = currentEngine();
+  if (engine && engine->isLoopThread() && t_completionDepth > 0) {
+    detachInFlight();
+  } else {
+    cancelAll();
+  }
+  engine.reset();
+
+  // 已投递到执行器、尚未开始的回调不再执行
+  m_callbackGate->close();
+  m_engine.reset();
+
+  // 写回 TLS 会话，供下次启动恢复
+  const Options& options = snapshot()->options;
+  if (options.sharedCache && !options.tlsSessionCacheFile.empty()) {
+    saveTlsSessions(options.tlsSessionCacheFile);
+  }
+
+  for (HandlePool& pool : m_handlePools) {
+    for (void* handle : pool.idle) {
+      curl_easy_cleanup(handle);
+    }
+  }
+}
+
+void HttpClientCpp::cancelAll() {
+  std::shared_ptr<CurlMultiEngine> engine = currentEngine();
+  bool external = engine && engine->isExternalLoop();
+
+  // 在完成回调中：这些传输只能在回调返回之后由同一线程结束
+  bool inCompletion =
+      engine && engine->isLoopThread() && t_completionDepth > 0;
+
+  {
+    std::lock_guard<std::mutex> lock(m_inFlightMutex);
+    for (Transfer* t = m_inFlight; t; t = t->nextInFlight) {
+      t->cancelled.store(true);
+    }
+    if (m_inFlight && engine && (!external || inCompletion)) {
+      engine->wakeup();
+    }
+  }
+  if (inCompletion) {
+    return;
+  }
+
+  // 外部事件循环：没有其他线程会驱动引擎，在当前线程结束被取消的传输
+  if (external) {
+    engine->onTimeout();
+  }
+
+  std::unique_lock<std::mutex> lock(m_inFlightMutex);
+  m_inFlightDone.wait(lock, [this]() { return m_inFlight == nullptr; });
+}
+
+void HttpClientCpp::detachInFlight() {
+  std::shared_ptr<CurlMultiEngine> engine = currentEngine();
+  std::lock_guard<std::mutex> lock(m_inFlightMutex);
+  for (Transfer* t = m_inFlight; t;) {
+    Transfer* next = t->nextInFlight;
+    t->cancelled.store(true);
+    t->client = nullptr;
+    t->prevInFlight = t->nextInFlight = nullptr;
+    t = next;
+  }
+  if (m_inFlight && engine) {
+    engine->wakeup();
+  }
+  m_inFlight = nullptr;
+}
+
+std::shared_ptr<CurlMultiEngine> HttpClientCpp::engine() {
+  std::lock_guard<std::mutex> lock(m_engineMutex);
+  if (!m_engine) {
+    const Options& options = snapshot()->options;
+    m_engine = options.sharedCache && !options.engine.externalLoop
+                   ? CurlMultiEngine::shared()
+                   : std::make_shared<CurlMultiEngine>(options.engine);
+  }
+  return m_engine;
+}
+
+std::shared_ptr<CurlMultiEngine> HttpClientCpp::currentEngine() const {
+  std::lock_guard<std::mutex> lock(m_engineMutex);
+  return m_engine;
+}
+
+HttpClientCpp::SnapshotPtr HttpClientCpp::snapshot() const {
+  std::lock_guard<std::mutex> lock(m_optionsMutex);
+  return m_snapshot;
+}
+
+HttpClientCpp::Options HttpClientCpp::options() const {
+  return snapshot()->options;
+}
+
+void HttpClientCpp::updateOptions(
+    const std::function<void(Options&)>& update) {
+  std::lock_guard<std::mutex> lock(m_optionsMutex);
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->options = m_snapshot->options;
+  update(snapshot->options);
+  m_snapshot = std::move(snapshot);
+}
+
+void* HttpClientCpp::acquireHandle(size_t& shard) {
+  shard = std::hash<std::thread::id>()(std::this_thread::get_id()) %
+          kHandlePoolShards;
+
+  HandlePool& pool = m_handlePools[shard];
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    if (!pool.idle.empty()) {
+      void* handle = pool.idle.back();
+      pool.idle.pop_back();
+      return handle;
+    }
+  }
+  return curl_easy_init();
+}
+
+void HttpClientCpp::releaseHandle(void* handle, size_t shard) {
+  HandlePool& pool = m_handlePools[shard];
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    if (pool.idle.size() < kMaxIdleHandlesPerShard) {
+      pool.idle.push_back(handle);
+      return;
+    }
+  }
+  curl_easy_cleanup(handle);
+}
+
+void HttpClientCpp::setTimeout(int seconds) {
+  updateOptions([seconds](Options& o) { o.timeoutMs = seconds * 1000L; });
+}
+
+void HttpClientCpp::setTimeoutMs(long milliseconds) {
+  updateOptions([milliseconds](Options& o) { o.timeoutMs = milliseconds; });
+}
+
+void HttpClientCpp::setConnectTimeoutMs(long milliseconds) {
+  updateOptions(
+      [milliseconds](Options& o) { o.connectTimeoutMs = milliseconds; });
+}
+
+void HttpClientCpp::addHeader(const std::string& key,
+                              const std::string& value) {
+  updateOptions([&](Options& o) { o.headers[key] = value; });
+}
+
+void HttpClientCpp::clearHeaders() {
+  updateOptions([](Options& o) { o.headers.clear(); });
+}
+
+void HttpClientCpp::setVerifySSL(bool verify) {
+  updateOptions([verify](Options& o) { o.verifySSL = verify; });
+}
+
+HttpClientCpp::Response HttpClientCpp::get(const std::string& url) {
+  Request request;
+  request.url = url;
+  return send(request);
+}
+
+HttpClientCpp::Response HttpClientCpp::post(const std::string& url,
+                                            const std::string& data,
+                                            const std::string& contentType) {
+  Request request;
+  request.method = "POST";
+  request.url = url;
+  request.body = data;
+  request.headers["Content-Type"] = contentType;
+  return send(request);
+}
+
+void HttpClientCpp::setHttp2(bool enabled) {
+  updateOptions([enabled](Options& o) {
+    o.http2 = enabled;
+    o.engine.multiplex = enabled;
+  });
+}
+
+void HttpClientCpp::setMaxConcurrentStreams(long streams) {
+  updateOptions(
+      [streams](Options& o) { o.engine.maxConcurrentStreams = streams; });
+}
+
+void HttpClientCpp::setSharedCache(bool enabled) {
+  updateOptions([enabled](Options& o) { o.sharedCache = enabled; });
+}
+
+void HttpClientCpp::setAcceptCompressed(bool enabled) {
+  updateOptions([enabled](Options& o) { o.acceptCompressed = enabled; });
+}
+
+void HttpClientCpp::setRequestCompressionThreshold(size_t bytes) {
+  updateOptions([bytes](Options& o) { o.compressThreshold = bytes; });
+}
+
+void HttpClientCpp::setTlsSessionCacheFile(const std::string& filePath) {
+  if (!snapshot()->options.sharedCache) return;
+
+  updateOptions([&](Options& o) { o.tlsSessionCacheFile = filePath; });
+  if (!filePath.empty()) {
+    loadTlsSessions(filePath);
+  }
+}
+
+void HttpClientCpp::setCallbackExecutor(Executor executor) {
+  updateOptions([&](Options& o) { o.executor = std::move(executor); });
+}
+
+void HttpClientCpp::setAsyncLimits(size_t maxInFlight, size_t maxQueued) {
+  updateOptions([=](Options& o) {
+    o.engine.maxInFlight = maxInFlight;
+    o.engine.maxQueued = maxQueued;
+  });
+}
+
+bool HttpClientCpp::setEventLoopCallbacks(
+    CurlMultiEngine::WatchCallback watch, CurlMultiEngine::TimerCallback timer) {
+  std::shared_ptr<CurlMultiEngine> engine;
+  {
+    std::lock_guard<std::mutex> lock(m_engineMutex);
+    if (!m_engine) {
+      CurlMultiEngine::Options engineOptions = snapshot()->options.engine;
+      engineOptions.externalLoop = true;
+      m_engine = std::make_shared<CurlMultiEngine>(engineOptions);
+    }
+    engine = m_engine;
+  }
+
+  // 已经在使用内置事件循环：配置保持不变，同步请求仍按原方式执行
+  if (!engine->isExternalLoop()) {
+    return false;
+  }
+  engine->setEventLoopCallbacks(std::move(watch), std::move(timer));
+
+  // 引擎接受回调之后才标记配置
+  updateOptions([](Options& o) { o.engine.externalLoop = true; });
+  return true;
+}
+
+std::vector<CurlMultiEngine::SocketWatch> HttpClientCpp::watchedSockets()
+    const {
+  std::shared_ptr<CurlMultiEngine> engine = currentEngine();
+  return engine ? engine->watchedSockets()
+                : std::vector<CurlMultiEngine::SocketWatch>();
+}
+
+long HttpClientCpp::eventLoopTimeoutMs() const {
+  std::shared_ptr<CurlMultiEngine> engine = currentEngine();
+  return engine ? engine->timeoutMs() : -1;
+}
+
+void HttpClientCpp::onReadable(int fd) {
+  if (std::shared_ptr<CurlMultiEngine> engine = currentEngine()) {
+    engine->onReadable(fd);
+  }
+}
+
+void HttpClientCpp::onWritable(int fd) {
+  if (std::shared_ptr<CurlMultiEngine> engine = currentEngine()) {
+    engine->onWritable(fd);
+  }
+}
+
+void HttpClientCpp::onTimeout() {
+  if (std::shared_ptr<CurlMultiEngine> engine = currentEngine()) {
+    engine->onTimeout();
+  }
+}
+
+HttpRequestHandle HttpClientCpp::sendAsync(const Request& request,
+                                           ResponseCallback callback) {
+  return submitAsync(request, std::move(callback),
+                     snapshot()->options.executor);
+}
+
+HttpRequestHandle HttpClientCpp::getAsync(const std::string& url,
+                                          ResponseCallback callback) {
+  Request request;
+  request.url = url;
+  return sendAsync(request, std::move(callback));
+}
+
+HttpRequestHandle HttpClientCpp::postAsync(const std::string& url,
+                                           const std::string& data,
+                                           ResponseCallback callback,
+                                           const std::string& contentType) {
+  Request request;
+  request.method = "POST";
+  request.url = url;
+  request.body = data;
+  request.headers["Content-Type"] = contentType;
+  return sendAsync(request, std::move(callback));
+}
+
+// ============================================================================
+// 请求执行（同步与异步共用同一套句柄配置）
+// ============================================================================
+
+// gzip 压缩请求体，失败时返回 false（调用方发送原始数据）
+static bool gzipCompress(const std::string& input, std::string& output) {
+#ifdef HTTP_CLIENT_HAS_ZLIB
+  z_stream stream = {};
+  // windowBits 15 + 16：输出 gzip 封装而非裸 zlib
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+
+  output.resize(deflateBound(&stream, static_cast<uLong>(input.size())));
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  stream.avail_in = static_cast<uInt>(input.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  stream.avail_out = static_cast<uInt>(output.size());
+
+  int res = deflate(&stream, Z_FINISH);
+  output.resize(stream.total_out);
+  deflateEnd(&stream);
+  return res == Z_STREAM_END;
+#else
+  (void)input;
+  (void)output;
+  return false;
+#endif
+}
+
+bool HttpClientCpp::prepareTransfer(Transfer& transfer,
+                                    const Request& request) {
+  const Options& options = transfer.snapshot->options;
+  transfer.client = this;
+  transfer.response.success = false;
+  transfer.response.statusCode = 0;
+
+  CURL* curl = acquireHandle(transfer.poolShard);
+  if (!curl) {
+    transfer.response.error = "Failed to initialize CURL";
+    return false;
+  }
+  transfer.easy = curl;
+
+  // 清除上次请求的选项（保留连接缓存、DNS 缓存和 TLS 会话）
+  curl_easy_reset(curl);
+
+  // 设置 URL
+  curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+
+  // 设置超时（连接阶段单独限时）
+  curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS,
+                   request.timeoutMs > 0 ? request.timeoutMs : options.timeoutMs);
+  curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, options.connectTimeoutMs);
+
+  // 多线程环境下禁止 libcurl 使用信号
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
+  // HTTPS 上通过 ALPN 协商 HTTP/2；新请求等待已有连接确认可复用，
+  // 而不是为每个并发请求各开一个连接
+  if (options.http2) {
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION,
+                     static_cast<long>(CURL_HTTP_VERSION_2TLS));
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+  } else {
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION,
+                     static_cast<long>(CURL_HTTP_VERSION_1_1));
+  }
+
+  // 保持连接（TCP keep-alive，避免空闲连接被中间设备断开）
+  curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 60L);
+  curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 30L);
+
+  // 接入进程级共享缓存（DNS 与 TLS 会话，短生命周期的客户端也能恢复会话）
+  if (options.sharedCache) {
+    curl_easy_setopt(curl, CURLOPT_SHARE, CurlSharedCache::handle());
+  }
+
+#if LIBCURL_VERSION_NUM < 0x080c00
+  // 配置了会话磁盘缓存：由 SSL_CTX 回调记录新会话、在首次握手前恢复会话
+  // （句柄会被复用，不需要时显式清除回调）
+  transfer.tlsSessionHost.clear();
+  if (options.sharedCache && !options.tlsSessionCacheFile.empty() &&
+      TlsSessionStore::available()) {
+    transfer.tlsSessionHost = tlsSessionHost(request.url);
+  }
+  if (!transfer.tlsSessionHost.empty()) {
+    curl_easy_setopt(curl, CURLOPT_SSL_CTX_FUNCTION,
+                     TlsSessionStore::onSslContext);
+    curl_easy_setopt(curl, CURLOPT_SSL_CTX_DATA, &transfer.tlsSessionHost);
+  } else {
+    curl_easy_setopt(curl, CURLOPT_SSL_CTX_FUNCTION, nullptr);
+    curl_easy_setopt(curl, CURLOPT_SSL_CTX_DATA, nullptr);
+  }
+#endif
+
+  // 设置 SSL 验证
+  curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, options.verifySSL ? 1L : 0L);
+  curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, options.verifySSL ? 2L : 0L);
+
+  // 设置响应回调（写入调用方缓冲区时保留其容量）
+  if (request.responseBuffer) {
+    request.responseBuffer->clear();
+    transfer.body = request.responseBuffer;
+  } else {
+    transfer.body = &transfer.responseBody;
+  }
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, Transfer::onWrite);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+
+  // 设置响应头回调
+  transfer.response.rawHeaders.reserve(512);
+  curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, Transfer::onHeader);
+  curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer);
+
+  // 协商压缩响应（空字符串表示 libcurl 支持的全部编码），解压在写入回调前完成
+  if (options.acceptCompressed) {
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+  }
+
+  // 较大的请求体压缩后发送
+  const bool isPost = request.method == "POST";
+  bool compressed = isPost && options.compressThreshold > 0 &&
+                    request.body.size() >= options.compressThreshold &&
+                    gzipCompress(request.body, transfer.requestBody) &&
+                    transfer.requestBody.size() < request.body.size();
+
+  // 设置请求头（链表按请求头组合缓存在配置快照中）
+  transfer.headerList =
+      transfer.snapshot->headerList(request.headers, compressed);
+  if (transfer.headerList) {
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer.headerList.get());
+  }
+
+  // 设置请求方法（请求体保存在 transfer 中，异步完成前一直有效）
+  if (isPost) {
+    if (!compressed) {
+      transfer.requestBody = request.body;
+    }
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, transfer.requestBody.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE,
+                     static_cast<long>(transfer.requestBody.length()));
+  } else if (request.method == "GET") {
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+  } else {
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+  }
+
+  return true;
+}
+
+void HttpClientCpp::finishTransfer(Transfer& transfer, int curlCode) {
+  CURLcode res = static_cast<CURLcode>(curlCode);
+  Response& response = transfer.response;
+
+  if (transfer.cancelled.load() && res == CURLE_ABORTED_BY_CALLBACK) {
+    response.error = "Request cancelled";
+    response.success = false;
+  } else if (res != CURLE_OK) {
+    response.error = curl_easy_strerror(res);
+    response.success = false;
+  } else {
+    // 获取状态码
+    long statusCode;
+    curl_easy_getinfo(transfer.easy, CURLINFO_RESPONSE_CODE, &statusCode);
+    response.statusCode = static_cast<int>(statusCode);
+    if (transfer.body == &transfer.responseBody) {
+      response.body = std::move(transfer.responseBody);
+    }
+    response.success = (statusCode >= 200 && statusCode < 300);
+  }
+
+  // 清理
+  transfer.headerList.reset();
+  releaseHandle(transfer.easy, transfer.poolShard);
+  transfer.easy = nullptr;
+}
+
+HttpRequestHandle HttpClientCpp::submitAsync(
+    const Request& request, ResponseCallback callback, Executor executor,
+    std::shared_ptr<std::promise<Response>> promise) {
+  auto transfer = std::make_shared<Transfer>();
+  transfer->snapshot = snapshot();
+  transfer->callback = std::move(callback);
+  transfer->executor = std::move(executor);
+  transfer->promise = std::move(promise);
+
+  HttpRequestHandle handle;
+  if (prepareTransfer(*transfer, request)) {
+    std::shared_ptr<CurlMultiEngine> engine = this->engine();
+
+    {
+      std::lock_guard<std::mutex> lock(m_inFlightMutex);
+      transfer->nextInFlight = m_inFlight;
+      if (m_inFlight) m_inFlight->prevInFlight = transfer.get();
+      m_inFlight = transfer.get();
+    }
+
+    handle = engine->submit(transfer);
+    if (handle.isValid()) {
+      return handle;
+    }
+
+    transferDone(transfer.get());
+    transfer->client = nullptr;
+
+    // 队列已满：归还句柄并以错误回调
+    releaseHandle(transfer->easy, transfer->poolShard);
+    transfer->easy = nullptr;
+    transfer->response.error = "Too many pending requests";
+  }
+
+  transfer->done.store(true);
+  transfer->deliver(m_callbackGate, false);
+  return handle;
+}
+
+void HttpClientCpp::transferDone(Transfer* transfer) {
+  std::lock_guard<std::mutex> lock(m_inFlightMutex);
+  if (transfer->prevInFlight) {
+    transfer->prevInFlight->nextInFlight = transfer->nextInFlight;
+  } else if (m_inFlight == transfer) {
+    m_inFlight = transfer->nextInFlight;
+  }
+  if (transfer->nextInFlight) {
+    transfer->nextInFlight->prevInFlight = transfer->prevInFlight;
+  }
+  transfer->prevInFlight = transfer->nextInFlight = nullptr;
+  m_inFlightDone.notify_all();
+}
+
+HttpClientCpp::Response HttpClientCpp::send(const Request& request) {
+  SnapshotPtr current = snapshot();
+
+  // HTTP/2：交给事件循环执行并等待结果，与其他线程的请求共用连接
+  // （在事件循环线程的回调中发起的同步请求、以及由外部事件循环驱动的客户端
+  // 直接执行，避免自我等待）
+  std::shared_ptr<CurlMultiEngine> engine = currentEngine();
+  bool onLoopThread = engine && engine->isLoopThread();
+  bool externalLoop = current->options.engine.externalLoop ||
+                      (engine && engine->isExternalLoop());
+
+  if (current->options.http2 && !onLoopThread && !externalLoop) {
+    // 结果直接移入 promise，响应体不复制
+    auto promise = std::make_shared<std::promise<Response>>();
+    std::future<Response> future = promise->get_future();
+    submitAsync(request, nullptr, nullptr, promise);
+    return future.get();
+  }
+
+  Transfer transfer;
+  transfer.snapshot = std::move(current);
+  if (!prepareTransfer(transfer, request)) {
+    return transfer.response;
+  }
+
+  // 执行请求
+  CURLcode res = curl_easy_perform(transfer.easy);
+  finishTransfer(transfer, res);
+
+  return transfer.response;
+}
+
+// ============================================================================
+// 本地加密文件（TLS 会话缓存与离线宽限缓存共用）
+// 文件格式: 4 字节魔数 | 64 字符 HMAC（十六进制）| AES-256-CBC 密文
+// 明文由若干 [u32 长度 + 数据] 字段组成
+// ============================================================================
+
+static void appendField(std::string& out, const void* data, size_t size) {
+  uint32_t length = static_cast<uint32_t>(size);
+  for (int i = 0; i < 4; i++) {
+    out.push_back(static_cast<char>((length >> (8 * i)) & 0xFF));
+  }
+  out.append(static_cast<const char*>(data), size);
+}
+
+static bool readField(const std::string& in, size_t& pos, std::string& out) {
+  if (pos + 4 > in.size()) return false;
+  uint32_t length = 0;
+  for (int i = 0; i < 4; i++) {
+    length |= static_cast<uint32_t>(static_cast<unsigned char>(in[pos + i]))
+              << (8 * i);
+  }
+  pos += 4;
+  if (pos + length > in.size()) return false;
+  out.assign(in, pos, length);
+  pos += length;
+  return true;
+}
+
+// 加密密钥与 MAC 都由应用密钥派生，label 区分不同用途的文件
+static std::string sealedFileKey(const char* label) {
+  return SecureTransportCpp::generateSignature(label, 0);
+}
+
+// 读取并校验加密文件，先校验 MAC 再解密
+static bool readSealedFile(const std::string& filePath, const char* magic,
+                           const char* label, std::string& plain) {
+  std::ifstream file(filePath, std::ios::binary);
+  if (!file.is_open()) return false;
+
+  std::string content((std::istreambuf_iterator<char>(file)),
+                      std::istreambuf_iterator<char>());
+  const size_t headerSize = 4 + 64;
+  if (content.size() <= headerSize || content.compare(0, 4, magic) != 0) {
+    return false;
+  }
+
+  std::string key = sealedFileKey(label);
+  std::string mac = content.substr(4, 64);
+  std::string cipher = content.substr(headerSize);
+  if (!SecureTransportCpp::verifySignature(cipher + key, 0, mac)) {
+    return false;
+  }
+
+  std::vector<unsigned char> plainBytes = SecureTransportCpp::aesDecrypt(
+      std::vector<unsigned char>(cipher.begin(), cipher.end()), key);
+  plain.assign(plainBytes.begin(), plainBytes.end());
+  return true;
+}
+
+// 加密并签名后写入文件（POSIX 下权限为 0600）
+static bool writeSealedFile(const std::string& filePath, const char* magic,
+                            const char* label, const std::string& plain) {
+  std::string key = sealedFileKey(label);
+  std::vector<unsigned char> cipherBytes = SecureTransportCpp::aesEncrypt(
+      std::vector<unsigned char>(plain.begin(), plain.end()), key);
+  if (cipherBytes.empty()) return false;
+  std::string cipher(cipherBytes.begin(), cipherBytes.end());
+
+  std::string content = magic;
+  content += SecureTransportCpp::generateSignature(cipher + key, 0);
+  content += cipher;
+
+  // 先写临时文件再原子替换，避免并发进程读到半个文件
+  std::string tempPath = filePath + ".tmp";
+#ifdef _WIN32
+  {
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    file << content;
+    if (!file.good()) return false;
+  }
+  return MoveFileExA(tempPath.c_str(), filePath.c_str(),
+                     MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  // 创建时即为 0600，不存在可被其他用户读取的时间窗口
+  // （先删除残留的临时文件：O_TRUNC 会保留它原来的权限）
+  ::unlink(tempPath.c_str());
+  int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                  S_IRUSR | S_IWUSR);
+  if (fd < 0) return false;
+
+  const char* data = content.data();
+  size_t remaining = content.size();
+  while (remaining > 0) {
+    ssize_t written = ::write(fd, data, remaining);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    data += written;
+    remaining -= static_cast<size_t>(written);
+  }
+  bool ok = remaining == 0 && ::close(fd) == 0;
+  if (remaining != 0) ::close(fd);
+  if (!ok) {
+    ::unlink(tempPath.c_str());
+    return false;
+  }
+  return std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+#endif
+}
+
+// ============================================================================
+// TLS 会话磁盘缓存
+// libcurl 8.12 及以上: 通过 curl_easy_ssls_export/import 读写共享缓存，
+//   明文为若干条记录: [会话键][shmac][会话数据][i64 过期时间]
+// 更早的版本（OpenSSL 后端）: 通过 CURLOPT_SSL_CTX_FUNCTION 挂接新会话回调，
+//   会话以 DER 编码保存在进程级表中，新连接握手前按主机恢复，
+//   明文为若干条记录: [主机:端口][DER 会话][i64 过期时间]
+// ============================================================================
+
+static const char kSessionFileKeyLabel[] = "tls-session-cache";
+
+#if LIBCURL_VERSION_NUM >= 0x080c00
+
+static const char kSessionFileMagic[] = "TLSC";
+
+static CURLcode exportSessionCallback(CURL*, void* userptr,
+                                     const char* sessionKey,
+                                     const unsigned char* shmac,
+                                     size_t shmacLength,
+                                     const unsigned char* sdata,
+                                     size_t sdataLength, curl_off_t validUntil,
+                                     int, const char*, size_t) {
+  std::string& out = *static_cast<std::string*>(userptr);
+  appendField(out, sessionKey, sessionKey ? std::strlen(sessionKey) : 0);
+  appendField(out, shmac, shmacLength);
+  appendField(out, sdata, sdataLength);
+
+  int64_t expires = static_cast<int64_t>(validUntil);
+  appendField(out, &expires, sizeof(expires));
+  return CURLE_OK;
+}
+
+#else
+
+static const char kSessionFileMagic[] = "TLSO";
+
+#endif
+
+int HttpClientCpp::loadTlsSessions(const std::string& filePath) {
+  std::string records;
+  if (!readSealedFile(filePath, kSessionFileMagic, kSessionFileKeyLabel,
+                      records)) {
+    return -1;
+  }
+
+  int64_t now = static_cast<int64_t>(std::time(nullptr));
+  int imported = 0;
+  size_t pos = 0;
+
+#if LIBCURL_VERSION_NUM >= 0x080c00
+  ensureCurlGlobalInit();
+  CURL* curl = curl_easy_init();
+  if (!curl) return -1;
+  curl_easy_setopt(curl, CURLOPT_SHARE, CurlSharedCache::handle());
+
+  std::string sessionKey, shmac, sdata, expires;
+  while (readField(records, pos, sessionKey) &&
+         readField(records, pos, shmac) && readField(records, pos, sdata) &&
+         readField(records, pos, expires)) {
+    int64_t validUntil = 0;
+    if (expires.size() == sizeof(validUntil)) {
+      std::memcpy(&validUntil, expires.data(), sizeof(validUntil));
+    }
+    if (validUntil != 0 && validUntil < now) continue;  // 已过期
+
+    CURLcode res = curl_easy_ssls_import(
+        curl, sessionKey.empty() ? nullptr : sessionKey.c_str(),
+        reinterpret_cast<const unsigned char*>(shmac.data()), shmac.size(),
+        reinterpret_cast<const unsigned char*>(sdata.data()), sdata.size());
+    if (res == CURLE_OK) imported++;
+  }
+
+  curl_easy_cleanup(curl);
+#else
+  if (!TlsSessionStore::available()) return -1;
+
+  std::string host, der, expires;
+  while (readField(records, pos, host) && readField(records, pos, der) &&
+         readField(records, pos, expires)) {
+    TlsSessionStore::Entry entry;
+    if (expires.size() == sizeof(entry.expires)) {
+      std::memcpy(&entry.expires, expires.data(), sizeof(entry.expires));
+    }
+    if (entry.expires < now || der.empty()) continue;  // 已过期
+
+    entry.der = std::move(der);
+    TlsSessionStore::instance().put(host, std::move(entry));
+    imported++;
+  }
+#endif
+  return imported;
+}
+
+bool HttpClientCpp::saveTlsSessions(const std::string& filePath) {
+  std::string records;
+
+#if LIBCURL_VERSION_NUM >= 0x080c00
+  ensureCurlGlobalInit();
+  CURL* curl = curl_easy_init();
+  if (!curl) return false;
+  curl_easy_setopt(curl, CURLOPT_SHARE, CurlSharedCache::handle());
+
+  CURLcode res = curl_easy_ssls_export(curl, exportSessionCallback, &records);
+  curl_easy_cleanup(curl);
+  if (res != CURLE_OK) return false;
+#else
+  int64_t now = static_cast<int64_t>(std::time(nullptr));
+  for (const auto& item : TlsSessionStore::instance().entries()) {
+    if (item.second.expires < now) continue;
+    appendField(records, item.first.data(), item.first.size());
+    appendField(records, item.second.der.data(), item.second.der.size());
+    appendField(records, &item.second.expires, sizeof(item.second.expires));
+  }
+#endif
+
+  if (records.empty()) return false;
+  return writeSealedFile(filePath, kSessionFileMagic, kSessionFileKeyLabel,
+                         records);
+}
+
+// ============================================================================
+// CircuitBreaker 实现
+// ============================================================================
+
+CircuitBreaker::CircuitBreaker() : CircuitBreaker(Options()) {}
+
+CircuitBreaker::CircuitBreaker(const Options& options)
+    : m_options(options),
+      m_state(Closed),
+      m_failures(0),
+      m_opens(0),
+      m_halfOpenInFlight(0) {}
+
+void CircuitBreaker::setOptions(const Options& options) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_options = options;
+}
+
+bool CircuitBreaker::allowRequest() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_state == Open) {
+    if (std::chrono::steady_clock::now() < m_openUntil) {
+      return false;
+    }
+    // 冷却期结束：半开，放行试探请求
+    m_state = HalfOpen;
+    m_halfOpenInFlight = 0;
+  }
+
+  if (m_state == HalfOpen) {
+    if (m_halfOpenInFlight >= m_options.halfOpenRequests) {
+      return false;
+    }
+    m_halfOpenInFlight++;
+  }
+
+  return true;
+}
+
+void CircuitBreaker::onSuccess() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_state = Closed;
+  m_failures = 0;
+  m_opens = 0;
+  m_halfOpenInFlight = 0;
+}
+
+void CircuitBreaker::onFailure() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_failures++;
+
+  // 半开状态下的试探失败立即重新打开
+  if (m_state == HalfOpen || m_failures >= m_options.failureThreshold) {
+    long duration = m_options.openMs;
+    for (int i = 0; i < m_opens && duration < m_options.maxOpenMs; i++) {
+      duration *= 2;
+    }
+    duration = std::min(duration, m_options.maxOpenMs);
+
+    m_state = Open;
+    m_opens++;
+    m_halfOpenInFlight = 0;
+    m_openUntil =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(duration);
+  }
+}
+
+void CircuitBreaker::onCancelled() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_state == HalfOpen && m_halfOpenInFlight > 0) {
+    m_halfOpenInFlight--;
+  }
+}
+
+CircuitBreaker::State CircuitBreaker::state() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_state;
+}
+
+// ============================================================================
+// LicenseClientCpp 实现
+// ============================================================================
+
+LicenseClientCpp::LicenseClientCpp(const std::string& serverUrl)
+    : LicenseClientCpp(std::vector<std::string>{serverUrl}) {}
+
+LicenseClientCpp::LicenseClientCpp(const std::vector<std::string>& serverUrls)
+    : LicenseClientCpp(serverUrls, nullptr) {}
+
+LicenseClientCpp::LicenseClientCpp(const std::vector<std::string>& serverUrls,
+                                   std::shared_ptr<HttpTransport> transport)
+    : m_transport(std::move(transport)),
+      m_nextAsyncId(0),
+      m_binaryWireEnabled(false),
+      m_wireState(WireUnknown),
+      m_latencyNext(0),
+      m_cacheEnabled(false),
+      m_cacheLoaded(false),
+      m_workerStop(false),
+      m_graceSeconds(0) {
+  if (!m_transport) {
+    m_ownsTransport = true;
+
+    // 添加默认请求头
+    HttpClientCpp::Options options;
+    options.headers["Content-Type"] = "application/json";
+    options.headers["User-Agent"] = "LicenseClientCpp/1.0";
+    m_transport = std::make_shared<CurlHttpTransport>(options);
+  }
+
+  // 单次尝试的超时由重试策略决定
+  setRetryPolicy(m_retryPolicy);
+
+  for (const std::string& url : serverUrls) {
+    Endpoint endpoint;
+    endpoint.url = url;
+    endpoint.nextProbe =
+        std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(m_endpointPolicy.probeIntervalMs);
+    m_endpoints.push_back(endpoint);
+  }
+
+  // 未提供地址时保留一个空地址，请求以 URL 错误失败
+  if (m_endpoints.empty()) {
+    m_endpoints.push_back(Endpoint());
+  }
+}
+
+LicenseClientCpp::~LicenseClientCpp() {
+  // 先结束进行中的异步请求：它们的回调会访问下面即将析构的成员
+  cancelAsyncRequests();
+
+  // 停止后台工作线程（正在执行的任务会先完成，其余任务被放弃）
+  {
+    std::lock_guard<std::mutex> lock(m_workerMutex);
+    m_workerStop = true;
+  }
+  m_workerCv.notify_all();
+  for (std::thread& worker : m_workerThreads) {
+    worker.join();
+  }
+
+  for (WorkerTask& task : m_workerTasks) {
+    task(false);
+  }
+
+  // 工作线程退出前可能又发出了请求
+  cancelAsyncRequests();
+}
+
+HttpRequestHandle LicenseClientCpp::sendAsyncTracked(
+    const HttpClientCpp::Request& request,
+    HttpClientCpp::ResponseCallback callback) {
+  uint64_t id;
+  {
+    std::lock_guard<std::mutex> lock(m_asyncMutex);
+    id = m_nextAsyncId++;
+    m_asyncRequests.emplace(id, HttpRequestHandle());
+  }
+
+  HttpRequestHandle handle = m_transport->sendAsync(
+      request, [this, id, callback](const HttpClientCpp::Response& response) {
+        if (callback) callback(response);
+
+        std::lock_guard<std::mutex> lock(m_asyncMutex);
+        m_asyncRequests.erase(id);
+        m_asyncDone.notify_all();
+      });
+
+  // 回调可能已经执行（例如队列已满时立即失败）
+  std::lock_guard<std::mutex> lock(m_asyncMutex);
+  auto it = m_asyncRequests.find(id);
+  if (it != m_asyncRequests.end()) {
+    it->second = handle;
+  }
+  return handle;
+}
+
+void LicenseClientCpp::cancelAsyncRequests() {
+  // 自己创建的传输层由它结束所有请求（接入外部事件循环时只有它能在当前线程
+  // 驱动取消）；调用方传入的传输层可能被共享，只取消本客户端的请求
+  if (m_ownsTransport) {
+    m_transport->cancelAll();
+  }
+
+  std::unique_lock<std::mutex> lock(m_asyncMutex);
+  for (auto& item : m_asyncRequests) {
+    item.second.cancel();
+  }
+  m_asyncDone.wait(lock, [this]() { return m_asyncRequests.empty(); });
+}
+
+void LicenseClientCpp::setAppSecret(const std::string& secret) {
+  SecureTransportCpp::setAppSecret(secret);
+}
+
+void LicenseClientCpp::setTlsSessionCacheFile(const std::string& filePath) {
+  if (HttpClientCpp* client = m_transport->httpClient()) {
+    client->setTlsSessionCacheFile(filePath);
+  }
+}
+
+void LicenseClientCpp::setBinaryWireFormat(bool enabled) {
+  m_binaryWireEnabled = enabled;
+}
+
+void LicenseClientCpp::setRetryPolicy(const RetryPolicy& policy) {
+  m_retryPolicy = policy;
+  m_transport->setTimeouts(policy.connectTimeoutMs, policy.attemptTimeoutMs);
+}
+
+void LicenseClientCpp::setHedgePolicy(const HedgePolicy& policy) {
+  m_hedgePolicy = policy;
+}
+
+void LicenseClientCpp::setCircuitBreaker(
+    const CircuitBreaker::Options& options) {
+  m_breaker.setOptions(options);
+}
+
+void LicenseClientCpp::setOfflineGrace(const std::string& filePath,
+                                       long graceSeconds) {
+  std::lock_guard<std::mutex> lock(m_graceMutex);
+  m_graceFile = filePath;
+  m_graceSeconds = graceSeconds;
+  m_graceLoaded = false;
+  m_graceRecord.clear();
+  m_graceRecordAt = 0;
+  m_graceWritten.clear();
+  m_graceWrittenAt = 0;
+  m_graceVersion++;
+}
+
+void LicenseClientCpp::setEndpointPolicy(const EndpointPolicy& policy) {
+  std::lock_guard<std::mutex> lock(m_endpointMutex);
+  m_endpointPolicy = policy;
+}
+
+std::vector<LicenseClientCpp::EndpointStatus>
+LicenseClientCpp::endpointStatus() const {
+  std::lock_guard<std::mutex> lock(m_endpointMutex);
+
+  std::vector<EndpointStatus> status;
+  status.reserve(m_endpoints.size());
+  for (const Endpoint& endpoint : m_endpoints) {
+    status.push_back({endpoint.url, endpoint.ewmaMs, !endpoint.ejected});
+  }
+  return status;
+}
+
+LicenseClientCpp::PreparedRequest LicenseClientCpp::prepareSecureRequest(
+    const std::string& path, const std::string& machineCode,
+    const std::string& action, const std::string& extraField,
+    const std::string& extraValue) {
+  PreparedRequest request;
+  request.path = path;
+
+  // 创建安全数据包（每次调用都有新的时间戳与 nonce）
+  SecurePacketCpp packet;
+  if (!SecurePacketCpp::create(machineCode, packet)) {
+    request.error = "Invalid machine code";
+    return request;
+  }
+
+  // 二进制线格式：定长数据包 + 附加字段原始字节
+  if (m_binaryWireEnabled && m_wireState.load() == WireBinary) {
+    request.body = packet.toBinary();
+    if (!request.body.empty()) {
+      request.body += extraValue;
+      request.contentType = SecurePacketCpp::kBinaryContentType;
+      request.binary = true;
+      return request;
+    }
+  }
+
+  // JSON 线格式：JSON -> Base64 -> 外层 JSON
+  std::string base64Packet = SecureTransportCpp::base64Encode(packet.toJson());
+
+  std::ostringstream oss;
+  oss << "{"
+      << "\"secure_packet\":\"" << base64Packet << "\",";
+  if (!extraField.empty()) {
+    oss << "\"" << extraField << "\":\"" << extraValue << "\",";
+  }
+  oss << "\"action\":\"" << action << "\""
+      << "}";
+
+  request.body = oss.str();
+  request.contentType = "application/json";
+  return request;
+}
+
+HttpClientCpp::Response LicenseClientCpp::postSecurePacket(
+    const std::string& path, const std::string& machineCode,
+    const std::string& action, const std::string& extraField,
+    const std::string& extraValue) {
+  // 申请许可证会在服务端创建记录且受严格限流，不重试也不对冲
+  bool idempotent = path != "/license/request";
+  return sendWithPolicy(
+      [&]() {
+        return prepareSecureRequest(path, machineCode, action, extraField,
+                                    extraValue);
+      },
+      idempotent);
+}
+
+bool LicenseClientCpp::updateWireState(
+    const PreparedRequest& request, const HttpClientCpp::Response& response) {
+  // 服务端不再支持二进制格式，回退到 JSON 并重发
+  if (request.binary && response.statusCode == 415) {
+    m_wireState.store(WireJson);
+    return true;
+  }
+
+  // 服务端声明支持二进制格式后，后续请求自动切换
+  if (m_binaryWireEnabled && m_wireState.load() == WireUnknown &&
+      response.header("Accept-Post")
+              .find(SecurePacketCpp::kBinaryContentType) != std::string::npos) {
+    m_wireState.store(WireBinary);
+  }
+  return false;
+}
+
+// 是否为主动取消（对冲落败、客户端析构等），不代表服务器状态
+static bool isCancelled(const HttpClientCpp::Response& response) {
+  return response.statusCode == 0 && response.error == "Request cancelled";
+}
+
+// 是否值得重试：网络错误（不含主动取消）、超时与网关错误
+// 429 不重试：服务端按小时窗口限流，几秒内的退避重试只会再次被拒绝
+static bool isRetriable(const HttpClientCpp::Response& response) {
+  if (response.statusCode == 0) {
+    return !isCancelled(response);
+  }
+  switch (response.statusCode) {
+    case 408:
+    case 502:
+    case 503:
+    case 504:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static long elapsedMs(std::chrono::steady_clock::time_point start) {
+  return static_cast<long>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+}
+
+HttpClientCpp::Response LicenseClientCpp::sendWithPolicy(
+    const RequestFactory& factory, bool idempotent) {
+  thread_local std::mt19937 rng(std::random_device{}());
+
+  HttpClientCpp::Response response;
+  response.statusCode = 0;
+  response.success = false;
+
+  // 熔断打开时直接失败，不等待超时
+  if (!m_breaker.allowRequest()) {
+    response.error = "Circuit open";
+    return response;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const int maxAttempts = idempotent ? std::max(1, m_retryPolicy.maxAttempts) : 1;
+  const bool hedged = m_hedgePolicy.enabled && idempotent;
+
+  for (int attempt = 0; attempt < maxAttempts;) {
+    // 单次尝试的总超时不超过剩余的总时限
+    long timeoutMs = std::min(m_retryPolicy.attemptTimeoutMs,
+                              m_retryPolicy.totalTimeoutMs - elapsedMs(start));
+    if (timeoutMs <= 0) {
+      if (attempt == 0) response.error = "Timeout was reached";
+      break;
+    }
+
+    PreparedRequest request;
+    auto attemptStart = std::chrono::steady_clock::now();
+    if (hedged) {
+      response = sendHedged(factory, request, timeoutMs);
+    } else {
+      // 每次尝试重新选择服务器，失败的服务器在重试时自然被避开
+      size_t endpoint = selectEndpoint();
+      request = factory();
+      if (request.error.empty()) {
+        HttpClientCpp::Request post;
+        post.method = "POST";
+        post.url = m_endpoints[endpoint].url + request.path;
+        post.body = request.body;
+        post.headers["Content-Type"] = request.contentType;
+        post.timeoutMs = timeoutMs;
+        response = m_transport->send(post);
+        reportEndpoint(endpoint, response, elapsedMs(attemptStart));
+      }
+    }
+
+    // 请求无法生成：不发送、不重试，也不计入熔断
+    if (!request.error.empty()) {
+      m_breaker.onCancelled();
+      response.statusCode = 0;
+      response.success = false;
+      response.error = request.error;
+      return response;
+    }
+
+    // 415 回退到 JSON 时立即重发，不计入尝试次数
+    if (updateWireState(request, response)) {
+      continue;
+    }
+
+    if (response.success && !hedged) {
+      recordLatency(elapsedMs(attemptStart));
+    }
 
-HttpClientCpp::~HttpClientCpp() { curl_global_cleanup(); }
+    attempt++;
+    if (!isRetriable(response) || attempt >= maxAttempts) {
+      break;
+    }
 
-void HttpClientCpp::setTimeout(int seconds) { m_timeout = seconds; }
+    // 带完全抖动的指数退避：在 [0, min(上限, 初始值 * 2^n)] 中随机取值
+    long ceiling = m_retryPolicy.initialBackoffMs;
+    for (int i = 1; i < attempt && ceiling < m_retryPolicy.maxBackoffMs; i++) {
+      ceiling *= 2;
+    }
+    ceiling = std::min(ceiling, m_retryPolicy.maxBackoffMs);
+    long backoff =
+        std::uniform_int_distribution<long>(0, std::max(0L, ceiling))(rng);
+
+    // 退避后剩余时间连一次连接超时都不够时放弃
+    // （否则下一次尝试以剩余时间为超时）
+    if (elapsedMs(start) + backoff + m_retryPolicy.connectTimeoutMs >
+        m_retryPolicy.totalTimeoutMs) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(backoff));
+  }
 
-void HttpClientCpp::addHeader(const std::string& key,
-                              const std::string& value) {
-  m_headers[key] = value;
+  // 重试用尽后仍不可用才计为一次熔断失败
+  if (isRetriable(response)) {
+    m_breaker.onFailure();
+  } else {
+    m_breaker.onSuccess();
+  }
+
+  return response;
 }
 
-void HttpClientCpp::clearHeaders() { m_headers.clear(); }
+HttpClientCpp::Response LicenseClientCpp::sendHedged(
+    const RequestFactory& factory, PreparedRequest& sent, long timeoutMs) {
+  const auto start = std::chrono::steady_clock::now();
+
+  // 两个副本共享的结果，回调在事件循环线程写入
+  struct HedgeState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int pending = 0;
+    bool done = false;
+    int winner = 0;
+    long latencyMs = 0;
+    HttpClientCpp::Response response;
+  };
+  auto state = std::make_shared<HedgeState>();
+
+  PreparedRequest requests[2];
+  HttpRequestHandle handles[2];
+
+  // 副本发往另一台服务器（只有一台时发往同一台）
+  size_t endpoints[2] = {selectEndpoint(), 0};
+
+  auto send = [&](int index) {
+    if (index > 0) {
+      endpoints[index] = selectEndpoint(endpoints[0]);
+    }
+    requests[index] = factory();
+    if (!requests[index].error.empty()) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (!state->done) {
+        state->done = true;
+        state->winner = index;
+        state->response.statusCode = 0;
+        state->response.success = false;
+        state->response.error = requests[index].error;
+      }
+      return;
+    }
+    auto sendTime = std::chrono::steady_clock::now();
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->pending++;
+    }
+    size_t endpoint = endpoints[index];
+    HttpClientCpp::Request post;
+    post.method = "POST";
+    post.url = m_endpoints[endpoint].url + requests[index].path;
+    post.body = requests[index].body;
+    post.headers["Content-Type"] = requests[index].contentType;
+    // 副本与首个请求共用同一截止时间
+    post.timeoutMs = std::max(1L, timeoutMs - elapsedMs(start));
+    handles[index] = sendAsyncTracked(
+        post,
+        [this, state, index, endpoint,
+         sendTime](const HttpClientCpp::Response& response) {
+          reportEndpoint(endpoint, response, elapsedMs(sendTime));
+
+          std::lock_guard<std::mutex> lock(state->mutex);
+          state->pending--;
+          // 先返回的有效结果胜出；两个都失败时取最后一个
+          if (!state->done && (!isRetriable(response) || state->pending == 0)) {
+            state->done = true;
+            state->winner = index;
+            state->latencyMs = elapsedMs(sendTime);
+            state->response = response;
+            state->cv.notify_all();
+          }
+        });
+  };
+
+  send(0);
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  if (!state->cv.wait_for(lock, std::chrono::milliseconds(hedgeDelayMs()),
+                          [&state]() { return state->done; })) {
+    lock.unlock();
+    send(1);
+    lock.lock();
+  }
+  state->cv.wait(lock, [&state]() { return state->done; });
 
-void HttpClientCpp::setVerifySSL(bool verify) { m_verifySSL = verify; }
+  HttpClientCpp::Response response = state->response;
+  int winner = state->winner;
+  long latencyMs = state->latencyMs;
+  lock.unlock();
 
-HttpClientCpp::Response HttpClientCpp::get(const std::string& url) {
-  return performRequest(url, "GET");
-}
+  // 取消落后的副本（未发出或已结束的副本不受影响）
+  handles[0].cancel();
+  handles[1].cancel();
 
-HttpClientCpp::Response HttpClientCpp::post(const std::string& url,
-                                            const std::string& data,
-                                            const std::string& contentType) {
-  m_headers["Content-Type"] = contentType;
-  return performRequest(url, "POST", data);
+  if (response.success) {
+    recordLatency(latencyMs);
+  }
+  sent = std::move(requests[winner]);
+  return response;
 }
 
-void HttpClientCpp::getAsync(const std::string& url,
-                             ResponseCallback callback) {
-  std::thread([this, url, callback]() {
-    Response response = get(url);
-    if (callback) {
-      callback(response);
+size_t LicenseClientCpp::selectEndpoint(size_t exclude) {
+  const auto now = std::chrono::steady_clock::now();
+  std::vector<size_t> probes;
+  size_t best = static_cast<size_t>(-1);
+  size_t fallback = 0;  // 全部被剔除时使用最近一次失败最少的服务器
+
+  {
+    std::lock_guard<std::mutex> lock(m_endpointMutex);
+    for (size_t i = 0; i < m_endpoints.size(); i++) {
+      Endpoint& endpoint = m_endpoints[i];
+
+      // 到期的探测：被剔除的服务器等待恢复，空闲的服务器刷新延迟估计
+      if (!endpoint.probing && now >= endpoint.nextProbe) {
+        endpoint.probing = true;
+        probes.push_back(i);
+      }
+
+      if (endpoint.consecutiveFailures <
+          m_endpoints[fallback].consecutiveFailures) {
+        fallback = i;
+      }
+
+      if (endpoint.ejected || i == exclude) continue;
+
+      // 尚无样本的服务器优先，以便尽快测得延迟
+      if (best == static_cast<size_t>(-1) ||
+          (endpoint.samples == 0 && m_endpoints[best].samples > 0) ||
+          (endpoint.samples > 0 && m_endpoints[best].samples > 0 &&
+           endpoint.ewmaMs < m_endpoints[best].ewmaMs)) {
+        best = i;
+      }
     }
-  }).detach();
-}
 
-void HttpClientCpp::postAsync(const std::string& url, const std::string& data,
-                              ResponseCallback callback,
-                              const std::string& contentType) {
-  std::thread([this, url, data, callback, contentType]() {
-    Response response = post(url, data, contentType);
-    if (callback) {
-      callback(response);
+    if (best == static_cast<size_t>(-1)) {
+      best = fallback;
     }
-  }).detach();
-}
 
-HttpClientCpp::Response HttpClientCpp::performRequest(const std::string& url,
-                                                      const std::string& method,
-                                                      const std::string& data) {
-  Response response;
-  response.success = false;
-  response.statusCode = 0;
+    // 被选中的服务器推迟下一次探测
+    if (!m_endpoints[best].ejected) {
+      m_endpoints[best].nextProbe =
+          now + std::chrono::milliseconds(m_endpointPolicy.probeIntervalMs);
+    }
+  }
 
-  CURL* curl = curl_easy_init();
-  if (!curl) {
-    response.error = "Failed to initialize CURL";
-    return response;
+  for (size_t index : probes) {
+    probeEndpoint(index);
   }
+  return best;
+}
 
-  // 设置 URL
-  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+void LicenseClientCpp::reportEndpoint(size_t index,
+                                      const HttpClientCpp::Response& response,
+                                      long latencyMs) {
+  // 主动取消（对冲落败）不代表服务器状态
+  if (isCancelled(response)) {
+    return;
+  }
 
-  // 设置超时
-  curl_easy_setopt(curl, CURLOPT_TIMEOUT, m_timeout);
+  std::lock_guard<std::mutex> lock(m_endpointMutex);
+  Endpoint& endpoint = m_endpoints[index];
+  const EndpointPolicy& policy = m_endpointPolicy;
 
-  // 设置 SSL 验证
-  curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, m_verifySSL ? 1L : 0L);
-  curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, m_verifySSL ? 2L : 0L);
+  // 失败按超时计入延迟：连接被拒绝虽然很快，但不能让该服务器显得更快
+  double sample = static_cast<double>(latencyMs);
+  bool failed = isRetriable(response);
+  if (failed) {
+    sample = std::max(sample, static_cast<double>(
+                                  m_retryPolicy.attemptTimeoutMs));
+  }
 
-  // 设置响应回调
-  std::string responseBody;
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responseBody);
+  endpoint.ewmaMs = endpoint.samples == 0
+                        ? sample
+                        : policy.ewmaAlpha * sample +
+                              (1.0 - policy.ewmaAlpha) * endpoint.ewmaMs;
+  endpoint.samples++;
+
+  if (!failed) {
+    endpoint.consecutiveFailures = 0;
+    endpoint.ejections = 0;
+    endpoint.ejected = false;
+    return;
+  }
 
-  // 设置响应头回调
-  curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
-  curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response.headers);
+  // 被剔除的服务器再次失败（探测或无可用服务器时的请求）则延长剔除
+  endpoint.consecutiveFailures++;
+  if (endpoint.ejected ||
+      endpoint.consecutiveFailures >= policy.failuresToEject) {
+    // 剔除时长随连续剔除次数翻倍
+    long duration = policy.ejectionMs;
+    for (int i = 0; i < endpoint.ejections && duration < policy.maxEjectionMs;
+         i++) {
+      duration *= 2;
+    }
+    duration = std::min(duration, policy.maxEjectionMs);
 
-  // 设置请求头
-  struct curl_slist* headers = nullptr;
-  for (const auto& header : m_headers) {
-    std::string headerStr = header.first + ": " + header.second;
-    headers = curl_slist_append(headers, headerStr.c_str());
+    endpoint.ejected = true;
+    endpoint.ejections++;
+    endpoint.nextProbe =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(duration);
   }
+}
 
-  if (headers) {
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+void LicenseClientCpp::prewarm() {
+  std::vector<size_t> probes;
+  {
+    std::lock_guard<std::mutex> lock(m_endpointMutex);
+    for (size_t i = 0; i < m_endpoints.size(); i++) {
+      if (!m_endpoints[i].probing) {
+        m_endpoints[i].probing = true;
+        probes.push_back(i);
+      }
+    }
   }
 
-  // 设置请求方法
-  if (method == "POST") {
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, data.length());
-  } else if (method == "GET") {
-    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+  // 探测请求与经由事件循环的请求共用连接池，完成后连接保持空闲等待复用
+  // （关闭 HTTP/2 时同步请求不经过事件循环，只复用 DNS 与 TLS 会话，见头文件）
+  for (size_t index : probes) {
+    probeEndpoint(index);
   }
+}
 
-  // 执行请求
-  CURLcode res = curl_easy_perform(curl);
+void LicenseClientCpp::probeEndpoint(size_t index) {
+  auto start = std::chrono::steady_clock::now();
+  HttpClientCpp::Request probe;
+  probe.url = m_endpoints[index].url + "/health";
+  sendAsyncTracked(
+      probe,
+      [this, index, start](const HttpClientCpp::Response& response) {
+        // 探测失败时等同一次请求失败（被剔除的服务器会延长剔除时间）；
+        // 被取消的探测（客户端析构等）不计入服务器状态
+        if (!isCancelled(response)) {
+          HttpClientCpp::Response result = response;
+          if (!response.success && !isRetriable(response)) {
+            result.statusCode = 503;
+          }
+          reportEndpoint(index, result, elapsedMs(start));
+        }
+
+        std::lock_guard<std::mutex> lock(m_endpointMutex);
+        Endpoint& endpoint = m_endpoints[index];
+        endpoint.probing = false;
+        if (!endpoint.ejected) {
+          endpoint.nextProbe =
+              std::chrono::steady_clock::now() +
+              std::chrono::milliseconds(m_endpointPolicy.probeIntervalMs);
+        }
+      });
+}
 
-  if (res != CURLE_OK) {
-    response.error = curl_easy_strerror(res);
-    response.success = false;
+void LicenseClientCpp::recordLatency(long milliseconds) {
+  std::lock_guard<std::mutex> lock(m_latencyMutex);
+  if (m_latencies.size() < kLatencySamples) {
+    m_latencies.push_back(milliseconds);
   } else {
-    // 获取状态码
-    long statusCode;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &statusCode);
-    response.statusCode = static_cast<int>(statusCode);
-    response.body = responseBody;
-    response.success = (statusCode >= 200 && statusCode < 300);
-  }
-
-  // 清理
-  if (headers) {
-    curl_slist_free_all(headers);
+    m_latencies[m_latencyNext] = milliseconds;
+    m_latencyNext = (m_latencyNext + 1) % kLatencySamples;
   }
-  curl_easy_cleanup(curl);
-
-  return response;
 }
 
-// ============================================================================
-// LicenseClientCpp 实现
-// ============================================================================
+long LicenseClientCpp::hedgeDelayMs() {
+  // 样本太少时分位数不可靠
+  static const size_t kMinSamples = 20;
 
-LicenseClientCpp::LicenseClientCpp(const std::string& serverUrl)
-    : m_serverUrl(serverUrl) {
-  // 添加默认请求头
-  m_httpClient.addHeader("Content-Type", "application/json");
-  m_httpClient.addHeader("User-Agent", "LicenseClientCpp/1.0");
-}
+  std::vector<long> samples;
+  {
+    std::lock_guard<std::mutex> lock(m_latencyMutex);
+    if (m_latencies.size() < kMinSamples) {
+      return m_hedgePolicy.initialDelayMs;
+    }
+    samples = m_latencies;
+  }
 
-LicenseClientCpp::~LicenseClientCpp() {}
+  size_t index = static_cast<size_t>(m_hedgePolicy.percentile *
+                                     static_cast<double>(samples.size() - 1));
+  index = std::min(index, samples.size() - 1);
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
 
-void LicenseClientCpp::setAppSecret(const std::string& secret) {
-  SecureTransportCpp::setAppSecret(secret);
+  return std::max(m_hedgePolicy.minDelayMs,
+                  std::min(samples[index], m_hedgePolicy.maxDelayMs));
 }
 
 // 简单的 JSON 解析辅助函数
@@ -198,6 +2125,62 @@ static std::string extractJsonValue(const std::string& json,
   return json.substr(valueStart + 1, valueEnd - valueStart - 1);
 }
 
+// 追加带引号的 JSON 字符串（转义引号、反斜杠与控制字符）
+static void appendJsonString(std::string& out, const std::string& value) {
+  out.push_back('"');
+  for (char c : value) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x",
+                        static_cast<unsigned char>(c));
+          out += escaped;
+        } else {
+          out.push_back(c);
+        }
+    }
+  }
+  out.push_back('"');
+}
+
+// 从 start 处的 '{' 找到与之匹配的 '}'（跳过字符串内容与嵌套对象/数组）
+static size_t findJsonObjectEnd(const std::string& json, size_t start) {
+  int depth = 0;
+  bool inString = false;
+  for (size_t i = start; i < json.size(); i++) {
+    char c = json[i];
+    if (inString) {
+      if (c == '\\') {
+        i++;
+      } else if (c == '"') {
+        inString = false;
+      }
+    } else if (c == '"') {
+      inString = true;
+    } else if (c == '{' || c == '[') {
+      depth++;
+    } else if (c == '}' || c == ']') {
+      if (--depth == 0) return c == '}' ? i : std::string::npos;
+    }
+  }
+  return std::string::npos;
+}
+
+// 去掉首尾空白（与服务端的 str.strip() 一致）
+static std::string trimWhitespace(const std::string& value) {
+  static const char kWhitespace[] = " \t\r\n\f\v";
+  size_t begin = value.find_first_not_of(kWhitespace);
+  if (begin == std::string::npos) return std::string();
+  size_t end = value.find_last_not_of(kWhitespace);
+  return value.substr(begin, end - begin + 1);
+}
+
 static bool extractJsonBool(const std::string& json, const std::string& key) {
   std::string searchKey = "\"" + key + "\":";
   size_t pos = json.find(searchKey);
@@ -216,26 +2199,17 @@ LicenseClientCpp::LicenseResponse LicenseClientCpp::requestLicense(
   LicenseResponse result;
   result.success = false;
 
-  // 创建安全数据包
-  SecurePacketCpp packet = SecurePacketCpp::create(machineCode);
-  std::string securePacket = packet.toJson();
-
-  // Base64 编码
-  std::string base64Packet = SecureTransportCpp::base64Encode(securePacket);
-
-  // 构建请求 JSON
-  std::ostringstream oss;
-  oss << "{"
-      << "\"secure_packet\":\"" << base64Packet << "\","
-      << "\"user_info\":\"" << userInfo << "\","
-      << "\"action\":\"request\""
-      << "}";
+  // 发送请求
+  HttpClientCpp::Response response = postSecurePacket(
+      "/license/request", machineCode, "request", "user_info", userInfo);
 
-  std::string requestBody = oss.str();
+  finishRequestLicense(response, result);
+  return result;
+}
 
-  // 发送请求
-  HttpClientCpp::Response response =
-      m_httpClient.post(m_serverUrl + "/license/request", requestBody);
+void LicenseClientCpp::finishRequestLicense(
+    const HttpClientCpp::Response& response, LicenseResponse& result) {
+  result.success = false;
 
   if (response.success) {
     result.success = extractJsonBool(response.body, "success");
@@ -244,44 +2218,508 @@ LicenseClientCpp::LicenseResponse LicenseClientCpp::requestLicense(
     result.expiresAt = extractJsonValue(response.body, "expires_at");
   } else {
     result.message = response.error;
+    result.error = response.error;
   }
-
-  return result;
 }
 
 LicenseClientCpp::VerifyResponse LicenseClientCpp::verifyLicense(
     const std::string& machineCode, const std::string& licenseKey) {
+  // 缓存命中时不访问网络（临近到期的条目由后台线程刷新）
   VerifyResponse result;
-  result.valid = false;
+  if (lookupVerifyCache(machineCode, licenseKey, result)) {
+    return result;
+  }
+  return verifyCoalesced(machineCode, licenseKey);
+}
 
-  // 创建安全数据包
-  SecurePacketCpp packet = SecurePacketCpp::create(machineCode);
-  std::string securePacket = packet.toJson();
-  std::string base64Packet = SecureTransportCpp::base64Encode(securePacket);
+static std::string verifyFlightKey(const std::string& machineCode,
+                                   const std::string& licenseKey) {
+  return "/license/verify\n" + machineCode + "\n" + licenseKey;
+}
 
-  // 构建请求 JSON
-  std::ostringstream oss;
-  oss << "{"
-      << "\"secure_packet\":\"" << base64Packet << "\","
-      << "\"license_key\":\"" << licenseKey << "\","
-      << "\"action\":\"verify\""
-      << "}";
+LicenseClientCpp::VerifyResponse LicenseClientCpp::verifyCoalesced(
+    const std::string& machineCode, const std::string& licenseKey) {
+  // promise 由共享指针持有：领头者回调时等待方可能已经返回
+  auto promise = std::make_shared<std::promise<VerifyResponse>>();
+  std::future<VerifyResponse> future = promise->get_future();
+
+  std::string key = verifyFlightKey(machineCode, licenseKey);
+  if (m_verifyFlight.join(key, [promise](const VerifyResponse& result) {
+        promise->set_value(result);
+      })) {
+    m_verifyFlight.complete(key, verifyLicenseRemote(machineCode, licenseKey));
+  }
+  return future.get();
+}
+
+void LicenseClientCpp::verifyLicenseAsync(const std::string& machineCode,
+                                          const std::string& licenseKey,
+                                          VerifyCallback callback) {
+  VerifyResponse cached;
+  if (lookupVerifyCache(machineCode, licenseKey, cached)) {
+    if (callback) callback(cached);
+    return;
+  }
+
+  // 已有相同的验证在进行：等待其结果
+  std::string key = verifyFlightKey(machineCode, licenseKey);
+  if (!m_verifyFlight.join(key, std::move(callback))) {
+    return;
+  }
+
+  postWorkerTask([this, key, machineCode, licenseKey](bool run) {
+    if (!run) {
+      VerifyResponse aborted;
+      aborted.valid = false;
+      aborted.message = "Client destroyed";
+      aborted.error = aborted.message;
+      m_verifyFlight.complete(key, aborted);
+      return;
+    }
+    m_verifyFlight.complete(key, verifyLicenseRemote(machineCode, licenseKey));
+  });
+}
+
+HttpRequestHandle LicenseClientCpp::startVerifyLicense(
+    const std::string& machineCode, const std::string& licenseKey,
+    VerifyCallback callback, long timeoutMs) {
+  VerifyResponse cached;
+  if (lookupVerifyCache(machineCode, licenseKey, cached)) {
+    if (callback) callback(cached);
+    return HttpRequestHandle();
+  }
+
+  // 离线宽限文件在调用线程读入内存，完成回调中不读文件
+  {
+    std::lock_guard<std::mutex> lock(m_graceMutex);
+    loadOfflineGraceLocked();
+  }
+
+  return startSecurePacket(
+      "/license/verify", machineCode, "verify", "license_key", licenseKey,
+      timeoutMs,
+      [this, machineCode, licenseKey,
+       callback](const HttpClientCpp::Response& response) {
+        VerifyResponse result;
+        finishVerify(machineCode, licenseKey, response, result, true);
+        if (callback) callback(result);
+      });
+}
+
+HttpRequestHandle LicenseClientCpp::startRequestLicense(
+    const std::string& machineCode, const std::string& userInfo,
+    LicenseCallback callback, long timeoutMs) {
+  return startSecurePacket(
+      "/license/request", machineCode, "request", "user_info", userInfo,
+      timeoutMs, [this, callback](const HttpClientCpp::Response& response) {
+        LicenseResponse result;
+        finishRequestLicense(response, result);
+        if (callback) callback(result);
+      });
+}
+
+HttpRequestHandle LicenseClientCpp::startSecurePacket(
+    const std::string& path, const std::string& machineCode,
+    const std::string& action, const std::string& extraField,
+    const std::string& extraValue, long timeoutMs,
+    HttpClientCpp::ResponseCallback onResponse) {
+  if (!m_breaker.allowRequest()) {
+    HttpClientCpp::Response response;
+    response.statusCode = 0;
+    response.success = false;
+    response.error = "Circuit open";
+    onResponse(response);
+    return HttpRequestHandle();
+  }
+
+  PreparedRequest prepared = prepareSecureRequest(
+      path, machineCode, action, extraField, extraValue);
+  if (!prepared.error.empty()) {
+    m_breaker.onCancelled();
+    HttpClientCpp::Response response;
+    response.statusCode = 0;
+    response.success = false;
+    response.error = prepared.error;
+    onResponse(response);
+    return HttpRequestHandle();
+  }
+  size_t endpoint = selectEndpoint();
+
+  HttpClientCpp::Request request;
+  request.method = "POST";
+  request.url = m_endpoints[endpoint].url + prepared.path;
+  request.body = std::move(prepared.body);
+  request.headers["Content-Type"] = prepared.contentType;
+  request.timeoutMs = timeoutMs;
+
+  auto start = std::chrono::steady_clock::now();
+  bool binary = prepared.binary;
+  return sendAsyncTracked(
+      request,
+      [this, endpoint, start, binary, path, machineCode, action, extraField,
+       extraValue, timeoutMs,
+       onResponse](const HttpClientCpp::Response& response) {
+        reportEndpoint(endpoint, response, elapsedMs(start));
+
+        if (isCancelled(response)) {
+          m_breaker.onCancelled();
+          onResponse(response);
+          return;
+        }
+
+        // 服务端不再支持二进制格式：以 JSON 重发（重发的请求不能再被取消）
+        PreparedRequest sent;
+        sent.binary = binary;
+        if (updateWireState(sent, response)) {
+          m_breaker.onCancelled();
+          startSecurePacket(path, machineCode, action, extraField, extraValue,
+                            timeoutMs, onResponse);
+          return;
+        }
+
+        if (isRetriable(response)) {
+          m_breaker.onFailure();
+        } else {
+          m_breaker.onSuccess();
+        }
+        onResponse(response);
+      });
+}
+
+void LicenseClientCpp::postWorkerTask(WorkerTask task) {
+  {
+    std::lock_guard<std::mutex> lock(m_workerMutex);
+    if (!m_workerStop) {
+      m_workerTasks.push_back(std::move(task));
+      // 空闲线程不足以处理排队的任务时增加线程
+      if (m_workerIdle < m_workerTasks.size() &&
+          m_workerThreads.size() < kMaxWorkerThreads) {
+        m_workerThreads.emplace_back(&LicenseClientCpp::workerLoop, this);
+      }
+      m_workerCv.notify_one();
+      return;
+    }
+  }
 
-  std::string requestBody = oss.str();
+  // 客户端正在析构：不再执行（在锁外通知，回调可能再次调用客户端）
+  task(false);
+}
+
+void LicenseClientCpp::workerLoop() {
+  std::unique_lock<std::mutex> lock(m_workerMutex);
+  while (true) {
+    m_workerIdle++;
+    m_workerCv.wait(
+        lock, [this]() { return m_workerStop || !m_workerTasks.empty(); });
+    m_workerIdle--;
+    if (m_workerStop) return;
+
+    WorkerTask task = std::move(m_workerTasks.front());
+    m_workerTasks.pop_front();
+
+    lock.unlock();
+    task(true);
+    lock.lock();
+  }
+}
 
+LicenseClientCpp::VerifyResponse LicenseClientCpp::verifyLicenseRemote(
+    const std::string& machineCode, const std::string& licenseKey) {
   // 发送请求
-  HttpClientCpp::Response response =
-      m_httpClient.post(m_serverUrl + "/license/verify", requestBody);
+  HttpClientCpp::Response response = postSecurePacket(
+      "/license/verify", machineCode, "verify", "license_key", licenseKey);
+
+  VerifyResponse result;
+  finishVerify(machineCode, licenseKey, response, result);
+  return result;
+}
+
+void LicenseClientCpp::finishVerify(const std::string& machineCode,
+                                    const std::string& licenseKey,
+                                    const HttpClientCpp::Response& response,
+                                    VerifyResponse& result, bool deferWrites) {
+  result.valid = false;
 
   if (response.success) {
     result.valid = extractJsonBool(response.body, "valid");
     result.message = extractJsonValue(response.body, "message");
     result.expiresAt = extractJsonValue(response.body, "expires_at");
+
+    if (result.valid) {
+      saveOfflineGrace(machineCode, licenseKey, result, deferWrites);
+    }
+    storeVerifyCache(machineCode, licenseKey, result, deferWrites);
+  } else if (isRetriable(response) &&
+             loadOfflineGrace(machineCode, licenseKey, result)) {
+    // 服务器不可用：使用最近一次成功验证的结果
+    result.offline = true;
   } else {
+    // 取消、超时等失败：与同步接口一致，message 与 error 都设置
     result.message = response.error;
+    result.error = response.error;
   }
 
-  return result;
+  // 请求失败：保留已有缓存条目，允许之后再次刷新
+  if (!response.success) {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    auto it = m_verifyCache.find(machineCode + ":" +
+                                 SecureTransportCpp::sha256(licenseKey));
+    if (it != m_verifyCache.end()) {
+      it->second.refreshing = false;
+    }
+  }
+}
+
+// ============================================================================
+// 离线宽限缓存
+// 明文字段: [机器码][SHA256(许可证密钥)][过期时间][消息][i64 验证时间]
+// ============================================================================
+
+static const char kGraceFileMagic[] = "LICG";
+static const char kGraceFileKeyLabel[] = "license-offline-grace";
+
+// 解析服务端的过期时间（本地时间 "YYYY-MM-DD HH:MM:SS"），失败返回 -1
+static int64_t parseExpiresAt(const std::string& expiresAt) {
+  std::tm tm = {};
+  if (std::sscanf(expiresAt.c_str(), "%d-%d-%d %d:%d:%d", &tm.tm_year,
+                  &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min,
+                  &tm.tm_sec) < 3) {
+    return -1;
+  }
+  tm.tm_year -= 1900;
+  tm.tm_mon -= 1;
+  tm.tm_isdst = -1;
+  return static_cast<int64_t>(std::mktime(&tm));
+}
+
+void LicenseClientCpp::saveOfflineGrace(const std::string& machineCode,
+                                        const std::string& licenseKey,
+                                        const VerifyResponse& result,
+                                        bool deferWrite) {
+  std::string filePath;
+  std::string record;
+  int64_t verifiedAt = static_cast<int64_t>(std::time(nullptr));
+  uint64_t version = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_graceMutex);
+    if (m_graceFile.empty()) return;
+
+    std::string keyDigest = SecureTransportCpp::sha256(licenseKey);
+    appendField(record, machineCode.data(), machineCode.size());
+    appendField(record, keyDigest.data(), keyDigest.size());
+    appendField(record, result.expiresAt.data(), result.expiresAt.size());
+    appendField(record, result.message.data(), result.message.size());
+
+    m_graceLoaded = true;  // 内存中的记录比文件新
+    m_graceRecord = record;
+    m_graceRecordAt = verifiedAt;
+
+    // 同一许可证、过期时间不变时，只在已写入的验证时间过了宽限期一半后
+    // 才刷新（文件仍足以覆盖剩余的一半宽限期），避免每次验证都加密重写
+    if (record == m_graceWritten &&
+        verifiedAt - m_graceWrittenAt < m_graceSeconds / 2 &&
+        verifiedAt >= m_graceWrittenAt) {
+      return;
+    }
+    filePath = m_graceFile;
+    version = ++m_graceVersion;
+  }
+
+  if (!deferWrite) {
+    writeOfflineGrace(filePath, record, verifiedAt, version);
+    return;
+  }
+  // 客户端析构时任务也会执行（run 为 false），不丢失最后一次记录
+  postWorkerTask([this, filePath, record, verifiedAt, version](bool) {
+    writeOfflineGrace(filePath, record, verifiedAt, version);
+  });
+}
+
+void LicenseClientCpp::writeOfflineGrace(const std::string& filePath,
+                                         const std::string& record,
+                                         int64_t verifiedAt,
+                                         uint64_t version) {
+  std::lock_guard<std::mutex> fileLock(m_graceFileMutex);
+  if (version <= m_graceWrittenVersion) return;  // 更新的记录已写入
+
+  std::string content = record;
+  appendField(content, &verifiedAt, sizeof(verifiedAt));
+  if (!writeSealedFile(filePath, kGraceFileMagic, kGraceFileKeyLabel,
+                       content)) {
+    return;
+  }
+  m_graceWrittenVersion = version;
+
+  std::lock_guard<std::mutex> lock(m_graceMutex);
+  if (filePath == m_graceFile) {
+    m_graceWritten = record;
+    m_graceWrittenAt = verifiedAt;
+  }
+}
+
+void LicenseClientCpp::loadOfflineGraceLocked() {
+  if (m_graceLoaded || m_graceFile.empty()) return;
+  m_graceLoaded = true;
+
+  std::string content;
+  if (!readSealedFile(m_graceFile, kGraceFileMagic, kGraceFileKeyLabel,
+                      content)) {
+    return;
+  }
+
+  // 记录 = 四个字段 + 验证时间字段
+  size_t pos = 0;
+  std::string field;
+  for (int i = 0; i < 4; i++) {
+    if (!readField(content, pos, field)) return;
+  }
+  size_t recordEnd = pos;
+  std::string verified;
+  if (!readField(content, pos, verified) ||
+      verified.size() != sizeof(int64_t)) {
+    return;
+  }
+
+  m_graceRecord = content.substr(0, recordEnd);
+  std::memcpy(&m_graceRecordAt, verified.data(), sizeof(int64_t));
+  // 文件内容即当前记录：重启后验证结果不变时也不重写
+  m_graceWritten = m_graceRecord;
+  m_graceWrittenAt = m_graceRecordAt;
+}
+
+bool LicenseClientCpp::loadOfflineGrace(const std::string& machineCode,
+                                        const std::string& licenseKey,
+                                        VerifyResponse& result) {
+  std::lock_guard<std::mutex> lock(m_graceMutex);
+  if (m_graceFile.empty()) return false;
+  loadOfflineGraceLocked();
+  if (m_graceRecord.empty()) return false;
+
+  size_t pos = 0;
+  std::string storedMachineCode, keyDigest, expiresAt, message;
+  if (!readField(m_graceRecord, pos, storedMachineCode) ||
+      !readField(m_graceRecord, pos, keyDigest) ||
+      !readField(m_graceRecord, pos, expiresAt) ||
+      !readField(m_graceRecord, pos, message)) {
+    return false;
+  }
+
+  // 记录必须属于同一台机器和同一个许可证
+  if (storedMachineCode != machineCode ||
+      keyDigest != SecureTransportCpp::sha256(licenseKey)) {
+    return false;
+  }
+
+  int64_t verifiedAt = m_graceRecordAt;
+  int64_t now = static_cast<int64_t>(std::time(nullptr));
+
+  // 超出宽限期（或系统时间被回拨到验证之前）
+  if (now < verifiedAt || now - verifiedAt > m_graceSeconds) {
+    return false;
+  }
+
+  // 许可证本身已过期
+  int64_t expires = parseExpiresAt(expiresAt);
+  if (expires >= 0 && now > expires) {
+    return false;
+  }
+
+  result.valid = true;
+  result.expiresAt = expiresAt;
+  result.message = message;
+  return true;
+}
+
+// 服务端单次批量验证的条目上限（secure_license_server.py 的 MAX_BATCH_SIZE）
+static const size_t kMaxVerifyBatchSize = 1000;
+
+std::vector<LicenseClientCpp::VerifyResponse> LicenseClientCpp::verifyLicenses(
+    const std::vector<std::pair<std::string, std::string>>& items) {
+  std::vector<VerifyResponse> results(items.size());
+  for (VerifyResponse& result : results) {
+    result.valid = false;
+  }
+
+  // 超过服务端上限时拆成多个请求，结果按原顺序合并
+  for (size_t begin = 0; begin < items.size(); begin += kMaxVerifyBatchSize) {
+    size_t end = std::min(items.size(), begin + kMaxVerifyBatchSize);
+    verifyLicenseBatch(items, begin, end, results);
+  }
+  return results;
+}
+
+void LicenseClientCpp::verifyLicenseBatch(
+    const std::vector<std::pair<std::string, std::string>>& items,
+    size_t begin, size_t end, std::vector<VerifyResponse>& results) {
+  // 条目摘要作为数据包的“机器码”，签名即覆盖整个批次
+  // 服务端先去掉首尾空白再计算摘要，这里也按去掉空白后的值计算
+  std::string canonical;
+  std::string itemsBody;
+  canonical.reserve((end - begin) * 130);
+  itemsBody.reserve((end - begin) * 160);
+  for (size_t i = begin; i < end; i++) {
+    std::string machineCode = trimWhitespace(items[i].first);
+    std::string licenseKey = trimWhitespace(items[i].second);
+    canonical += machineCode + ":" + licenseKey + "\n";
+
+    // 条目列表只构建一次，每次尝试只重新生成数据包
+    if (i > begin) itemsBody += ",";
+    itemsBody += "{\"machine_code\":";
+    appendJsonString(itemsBody, machineCode);
+    itemsBody += ",\"license_key\":";
+    appendJsonString(itemsBody, licenseKey);
+    itemsBody += "}";
+  }
+  const std::string digest = SecureTransportCpp::sha256(canonical);
+
+  // 发送请求
+  HttpClientCpp::Response response = sendWithPolicy([&]() {
+    PreparedRequest request;
+    SecurePacketCpp packet;
+    if (!SecurePacketCpp::create(digest, packet)) {
+      request.error = "Failed to create secure packet";
+      return request;
+    }
+    std::string base64Packet =
+        SecureTransportCpp::base64Encode(packet.toJson());
+
+    request.path = "/license/verify_batch";
+    request.contentType = "application/json";
+    request.body = "{\"secure_packet\":\"" + base64Packet +
+                   "\",\"items\":[" + itemsBody +
+                   "],\"action\":\"verify_batch\"}";
+    return request;
+  });
+
+  // 整批失败：传输错误，或服务端拒绝（4xx / 429，取响应中的 message）
+  if (!response.success) {
+    std::string error = response.error;
+    if (error.empty()) error = extractJsonValue(response.body, "message");
+    if (error.empty()) error = "HTTP " + std::to_string(response.statusCode);
+    for (size_t i = begin; i < end; i++) {
+      results[i].message = error;
+      results[i].error = error;
+    }
+    return;
+  }
+
+  // 逐个解析 results 数组中的对象（与请求条目顺序一致）
+  const std::string& body = response.body;
+  size_t pos = body.find("\"results\"");
+  pos = pos == std::string::npos ? pos : body.find('[', pos);
+  for (size_t i = begin; i < end && pos != std::string::npos; i++) {
+    size_t objectStart = body.find_first_of("{]", pos + 1);
+    if (objectStart == std::string::npos || body[objectStart] == ']') break;
+    size_t objectEnd = findJsonObjectEnd(body, objectStart);
+    if (objectEnd == std::string::npos) break;
+
+    std::string object = body.substr(objectStart, objectEnd - objectStart + 1);
+    results[i].valid = extractJsonBool(object, "valid");
+    results[i].message = extractJsonValue(object, "message");
+    results[i].expiresAt = extractJsonValue(object, "expires_at");
+
+    pos = objectEnd;
+  }
 }
 
 LicenseClientCpp::LicenseInfo LicenseClientCpp::getLicenseInfo(
@@ -289,23 +2727,9 @@ LicenseClientCpp::LicenseInfo LicenseClientCpp::getLicenseInfo(
   LicenseInfo result;
   result.success = false;
 
-  // 创建安全数据包
-  SecurePacketCpp packet = SecurePacketCpp::create(machineCode);
-  std::string securePacket = packet.toJson();
-  std::string base64Packet = SecureTransportCpp::base64Encode(securePacket);
-
-  // 构建请求 JSON
-  std::ostringstream oss;
-  oss << "{"
-      << "\"secure_packet\":\"" << base64Packet << "\","
-      << "\"action\":\"info\""
-      << "}";
-
-  std::string requestBody = oss.str();
-
   // 发送请求
   HttpClientCpp::Response response =
-      m_httpClient.post(m_serverUrl + "/license/info", requestBody);
+      postSecurePacket("/license/info", machineCode, "info", "", "");
 
   if (response.success) {
     result.success = extractJsonBool(response.body, "success");
@@ -325,3 +2749,204 @@ LicenseClientCpp::LicenseInfo LicenseClientCpp::getLicenseInfo(
 
   return result;
 }
+
+// ============================================================================
+// 验证结果缓存
+// 磁盘文件明文为若干条记录: [缓存键][过期时间][消息][i64 有效期截止]
+// ============================================================================
+
+static const char kVerifyCacheMagic[] = "LICV";
+static const char kVerifyCacheKeyLabel[] = "license-verify-cache";
+
+void LicenseClientCpp::setVerifyCache(const VerifyCacheOptions& options) {
+  std::lock_guard<std::mutex> lock(m_cacheMutex);
+  m_cacheOptions = options;
+  m_cacheEnabled = true;
+  m_cacheLoaded = false;
+  m_verifyCache.clear();
+}
+
+void LicenseClientCpp::clearVerifyCache() {
+  std::string filePath;
+  uint64_t version;
+  {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    m_verifyCache.clear();
+    filePath = m_cacheOptions.filePath;
+    version = ++m_cacheVersion;
+  }
+
+  // 与写入串行：之前的快照不会在删除之后重新写回
+  std::lock_guard<std::mutex> lock(m_cacheFileMutex);
+  m_cacheWrittenVersion = std::max(m_cacheWrittenVersion, version);
+  if (!filePath.empty()) {
+    std::remove(filePath.c_str());
+  }
+}
+
+bool LicenseClientCpp::lookupVerifyCache(const std::string& machineCode,
+                                         const std::string& licenseKey,
+                                         VerifyResponse& result) {
+  std::lock_guard<std::mutex> lock(m_cacheMutex);
+  if (!m_cacheEnabled) return false;
+
+  if (!m_cacheLoaded) {
+    loadVerifyCacheLocked();
+    m_cacheLoaded = true;
+  }
+
+  auto it = m_verifyCache.find(machineCode + ":" +
+                               SecureTransportCpp::sha256(licenseKey));
+  if (it == m_verifyCache.end()) return false;
+
+  // 已过期：由调用方同步验证
+  int64_t now = static_cast<int64_t>(std::time(nullptr));
+  CachedVerify& entry = it->second;
+  if (now >= entry.freshUntil) return false;
+
+  result = entry.result;
+  result.cached = true;
+
+  // 临近到期：交给后台线程刷新，本次仍返回缓存结果
+  // 工作线程不能阻塞等待其他领头者（领头者可能排在同一线程池的队列中）：
+  // 已有相同的验证在进行时直接结束，由领头者写回缓存
+  if (!entry.refreshing &&
+      now >= entry.freshUntil - m_cacheOptions.refreshAheadSeconds) {
+    entry.refreshing = true;
+    postWorkerTask([this, machineCode, licenseKey](bool run) {
+      if (!run) return;
+      std::string key = verifyFlightKey(machineCode, licenseKey);
+      if (m_verifyFlight.join(key, [](const VerifyResponse&) {})) {
+        m_verifyFlight.complete(key,
+                                verifyLicenseRemote(machineCode, licenseKey));
+      }
+    });
+  }
+  return true;
+}
+
+void LicenseClientCpp::storeVerifyCache(const std::string& machineCode,
+                                        const std::string& licenseKey,
+                                        const VerifyResponse& result,
+                                        bool deferWrite) {
+  std::string filePath;
+  std::string records;
+  uint64_t version = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    if (!updateVerifyCacheLocked(machineCode, licenseKey, result) ||
+        m_cacheOptions.filePath.empty()) {
+      return;
+    }
+    filePath = m_cacheOptions.filePath;
+    records = snapshotVerifyCacheLocked();
+    version = ++m_cacheVersion;
+  }
+
+  // 加密与写文件不持有 m_cacheMutex，不阻塞其他线程查找缓存
+  if (!deferWrite) {
+    writeVerifyCache(filePath, records, version);
+    return;
+  }
+  postWorkerTask([this, filePath, records, version](bool) {
+    writeVerifyCache(filePath, records, version);
+  });
+}
+
+bool LicenseClientCpp::updateVerifyCacheLocked(const std::string& machineCode,
+                                               const std::string& licenseKey,
+                                               const VerifyResponse& result) {
+  if (!m_cacheEnabled) return false;
+
+  std::string key =
+      machineCode + ":" + SecureTransportCpp::sha256(licenseKey);
+
+  // 有效期取 TTL 与许可证过期时间中较早者
+  int64_t now = static_cast<int64_t>(std::time(nullptr));
+  int64_t freshUntil = now + m_cacheOptions.ttlSeconds;
+  int64_t expires = parseExpiresAt(result.expiresAt);
+  if (expires >= 0) {
+    freshUntil = std::min(freshUntil, expires);
+  }
+
+  // 无效的结果不缓存，并移除旧条目
+  if (!result.valid || freshUntil <= now) {
+    return m_verifyCache.erase(key) > 0;
+  }
+
+  // 超出容量时淘汰最早到期的条目
+  if (m_verifyCache.size() >= m_cacheOptions.maxEntries &&
+      m_verifyCache.find(key) == m_verifyCache.end()) {
+    auto oldest = std::min_element(
+        m_verifyCache.begin(), m_verifyCache.end(),
+        [](const std::pair<const std::string, CachedVerify>& a,
+           const std::pair<const std::string, CachedVerify>& b) {
+          return a.second.freshUntil < b.second.freshUntil;
+        });
+    if (oldest != m_verifyCache.end()) {
+      m_verifyCache.erase(oldest);
+    }
+  }
+
+  CachedVerify& entry = m_verifyCache[key];
+  entry.result = result;
+  entry.result.cached = false;
+  entry.result.offline = false;
+  entry.freshUntil = freshUntil;
+  entry.refreshing = false;
+  return true;
+}
+
+std::string LicenseClientCpp::snapshotVerifyCacheLocked() const {
+  std::string records;
+  for (const auto& item : m_verifyCache) {
+    const VerifyResponse& result = item.second.result;
+    appendField(records, item.first.data(), item.first.size());
+    appendField(records, result.expiresAt.data(), result.expiresAt.size());
+    appendField(records, result.message.data(), result.message.size());
+    appendField(records, &item.second.freshUntil, sizeof(int64_t));
+  }
+  return records;
+}
+
+void LicenseClientCpp::writeVerifyCache(const std::string& filePath,
+                                        const std::string& records,
+                                        uint64_t version) {
+  std::lock_guard<std::mutex> lock(m_cacheFileMutex);
+  if (version <= m_cacheWrittenVersion) return;  // 更新的快照已写入
+
+  writeSealedFile(filePath, kVerifyCacheMagic, kVerifyCacheKeyLabel, records);
+  m_cacheWrittenVersion = version;
+}
+
+void LicenseClientCpp::loadVerifyCacheLocked() {
+  if (m_cacheOptions.filePath.empty()) return;
+
+  std::string records;
+  if (!readSealedFile(m_cacheOptions.filePath, kVerifyCacheMagic,
+                      kVerifyCacheKeyLabel, records)) {
+    return;
+  }
+
+  int64_t now = static_cast<int64_t>(std::time(nullptr));
+  size_t pos = 0;
+  std::string key, expiresAt, message, fresh;
+  while (m_verifyCache.size() < m_cacheOptions.maxEntries &&
+         readField(records, pos, key) && readField(records, pos, expiresAt) &&
+         readField(records, pos, message) && readField(records, pos, fresh)) {
+    int64_t freshUntil = 0;
+    if (fresh.size() != sizeof(freshUntil)) break;
+    std::memcpy(&freshUntil, fresh.data(), sizeof(freshUntil));
+
+    // 已过期，或有效期比当前设置更长（TTL 调小之后）
+    if (freshUntil <= now || freshUntil > now + m_cacheOptions.ttlSeconds) {
+      continue;
+    }
+
+    CachedVerify& entry = m_verifyCache[key];
+    entry.result.valid = true;
+    entry.result.expiresAt = expiresAt;
+    entry.result.message = message;
+    entry.freshUntil = freshUntil;
+  }
+}
@@ -1,24 +1,54 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <future>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "curl_multi_engine.h"
 
 /// <summary>
 /// 纯 C++ HTTP/HTTPS 客户端（使用 libcurl）
 /// 不依赖 Qt，可在任何 C++ 项目中使用
+/// 请求之间复用 curl 句柄（保持连接、DNS 缓存与 TLS 会话），
+/// libcurl 全局初始化在进程内只执行一次；
+/// 默认接入进程级共享缓存，新建的客户端也能复用 DNS、TLS 会话与连接
 /// </summary>
 class HttpClientCpp {
  public:
   /// <summary>
   /// HTTP 响应结构
+  /// 迁移说明：旧版本的公有成员 std::map headers 已移除，响应头保存为原始
+  /// 文本按需解析。response.headers["X"] 改为 response.header("X")（不区分
+  /// 大小写，不存在时返回空字符串）；需要全部响应头时调用 headers()
   /// </summary>
   struct Response {
-    int statusCode;                              // HTTP 状态码
-    std::string body;                            // 响应体
-    std::map<std::string, std::string> headers;  // 响应头
-    std::string error;                           // 错误信息
-    bool success;                                // 是否成功
+    int statusCode;          // HTTP 状态码
+    std::string body;        // 响应体（使用 Request::responseBuffer 时为空）
+    std::string rawHeaders;  // 原始响应头块（仅最终响应，按需解析）
+    std::string error;       // 错误信息
+    bool success;            // 是否成功
+
+    /// <summary>
+    /// 按名称查找响应头（不区分大小写），不存在时返回空字符串
+    /// </summary>
+    std::string header(const std::string& name) const;
+
+    /// <summary>
+    /// 解析全部响应头
+    /// </summary>
+    std::map<std::string, std::string> headers() const;
   };
 
   /// <summary>
@@ -26,14 +56,85 @@ class HttpClientCpp {
   /// </summary>
   using ResponseCallback = std::function<void(const Response&)>;
 
+  /// <summary>
+  /// 回调执行器：接收一个任务并在选定的线程上执行
+  /// 为空时回调直接在事件循环线程执行（回调中不要做阻塞操作）
+  /// </summary>
+  using Executor = std::function<void(std::function<void()>)>;
+
+  /// <summary>
+  /// 客户端配置
+  /// 每个请求开始时取得配置快照，之后的修改只影响新请求；
+  /// 标注"首个请求之前"的项在首个请求之后修改不再生效
+  /// </summary>
+  struct Options {
+    long timeoutMs = 30000;         // 单个请求的总超时（毫秒）
+    long connectTimeoutMs = 10000;  // 连接超时（毫秒，含 DNS、TCP 与 TLS）
+    bool verifySSL = true;          // SSL 证书验证
+    bool http2 = true;              // HTTP/2（首个请求之前）
+    bool sharedCache = true;        // 进程级共享缓存（首个请求之前）
+    bool acceptCompressed = true;   // 接受压缩响应
+    size_t compressThreshold = 0;   // 请求体压缩阈值（0 表示不压缩）
+    std::string tlsSessionCacheFile;            // TLS 会话磁盘缓存文件
+    std::map<std::string, std::string> headers;  // 每个请求都携带的请求头
+    Executor executor;                          // 异步回调执行器
+    CurlMultiEngine::Options engine;  // 私有事件循环参数（首个请求之前）
+  };
+
+  /// <summary>
+  /// 单个请求
+  /// 请求头与 Options::headers 合并，同名时以请求自身的为准
+  /// </summary>
+  struct Request {
+    std::string method = "GET";
+    std::string url;
+    std::string body;
+    std::map<std::string, std::string> headers;
+    long timeoutMs = 0;  // 本次请求的总超时（毫秒），0 使用客户端配置
+
+    // 响应体写入调用方的缓冲区（清空后写入，保留其容量以便反复使用），
+    // 为空时写入 Response::body；异步请求时缓冲区须存活到回调
+    std::string* responseBuffer = nullptr;
+  };
+
   HttpClientCpp();
+
+  /// <summary>
+  /// 使用给定配置创建客户端
+  /// 配置在构建时确定、之后不再修改的客户端可以安全地被多个线程共享
+  /// </summary>
+  explicit HttpClientCpp(const Options& options);
   ~HttpClientCpp();
 
+  /// <summary>
+  /// 当前配置的快照
+  /// </summary>
+  Options options() const;
+
+  /// <summary>
+  /// 取消本客户端所有进行中的异步请求，并等待它们的回调结束
+  /// （接入外部事件循环时须在事件循环线程调用）
+  /// 在完成回调中调用时只发出取消、不等待；设置了执行器时，
+  /// 已投递到执行器的回调可能在返回之后才执行
+  /// </summary>
+  void cancelAll();
+
   /// <summary>
   /// 设置超时时间（秒）
   /// </summary>
   void setTimeout(int seconds);
 
+  /// <summary>
+  /// 设置单个请求的总超时（毫秒，包含连接、发送与接收，默认 30000）
+  /// </summary>
+  void setTimeoutMs(long milliseconds);
+
+  /// <summary>
+  /// 设置连接超时（毫秒，包含 DNS、TCP 与 TLS 握手，默认 10000）
+  /// 服务器不可达时在连接阶段尽快失败，而不是等满总超时
+  /// </summary>
+  void setConnectTimeoutMs(long milliseconds);
+
   /// <summary>
   /// 添加自定义请求头
   /// </summary>
@@ -49,6 +150,19 @@ class HttpClientCpp {
   /// </summary>
   void setVerifySSL(bool verify);
 
+  /// <summary>
+  /// 发送请求（同步，线程安全）
+  /// </summary>
+  Response send(const Request& request);
+
+  /// <summary>
+  /// 发送请求（异步，线程安全）
+  /// 所有异步请求由同一个 curl_multi 事件循环线程执行；
+  /// 客户端析构时未完成的请求以取消结束，回调不会晚于析构
+  /// </summary>
+  HttpRequestHandle sendAsync(const Request& request,
+                              ResponseCallback callback);
+
   /// <summary>
   /// GET 请求（同步）
   /// </summary>
@@ -56,39 +170,364 @@ class HttpClientCpp {
 
   /// <summary>
   /// POST 请求（同步）
+  /// Content-Type 只作用于本次请求
   /// </summary>
   Response post(const std::string& url, const std::string& data,
                 const std::string& contentType = "application/json");
 
   /// <summary>
-  /// GET 请求（异步）- 需要自己实现线程管理
+  /// 启用/禁用 HTTP/2（默认启用，需在首个请求之前设置）
+  /// 启用时通过 TLS ALPN 协商 HTTP/2（服务端不支持时回退到 HTTP/1.1），
+  /// 同步请求也交给事件循环执行，使不同线程的并发请求在每个主机的
+  /// 同一连接上多路复用（libcurl 只在同一个 multi 句柄内复用 HTTP/2 连接）。
+  /// 代价是单个调用者每次请求多一次线程切换（本机回环约 70 µs）；
+  /// 收益是并发调用者超过空闲句柄数（16）后不再新建连接和 TLS 握手，
+  /// 尾延迟有界。并发很低且延迟敏感时可以禁用（测量见 server/native/README.md）
+  /// </summary>
+  void setHttp2(bool enabled);
+
+  /// <summary>
+  /// 设置每个 HTTP/2 连接的最大并发流数（默认 100，需在首个请求之前设置）
+  /// 仅对禁用共享缓存的客户端生效
+  /// </summary>
+  void setMaxConcurrentStreams(long streams);
+
+  /// <summary>
+  /// 是否接受压缩响应（默认启用）
+  /// 启用时发送 Accept-Encoding（libcurl 支持的 zstd/br/gzip/deflate），
+  /// 响应在写入回调中流式解压到响应体，不产生额外副本
+  /// </summary>
+  void setAcceptCompressed(bool enabled);
+
+  /// <summary>
+  /// 设置请求体压缩阈值（字节，0 表示不压缩，默认 0）
+  /// POST 请求体达到阈值时以 gzip 压缩并添加 Content-Encoding: gzip，
+  /// 仅在服务端支持解压时启用；未链接 zlib 时忽略
+  /// </summary>
+  void setRequestCompressionThreshold(size_t bytes);
+
+  /// <summary>
+  /// 是否使用进程级共享缓存（默认启用，需在首个请求之前设置）
+  /// 启用时 DNS 缓存与 TLS 会话缓存通过 curl share 句柄在所有实例间共享，
+  /// 事件循环使用 CurlMultiEngine::shared()（连接池也随之共享，
+  /// 并发上限与流数由 CurlMultiEngine::setSharedOptions 决定）；
+  /// 禁用时每个客户端使用自己的缓存和事件循环
   /// </summary>
-  void getAsync(const std::string& url, ResponseCallback callback);
+  void setSharedCache(bool enabled);
+
+  /// <summary>
+  /// 设置 TLS 会话票据的磁盘缓存文件（需启用共享缓存）
+  /// 设置时把文件中未过期的会话导入进程级共享缓存，客户端析构时写回，
+  /// 使短生命周期进程的首个请求也能恢复 TLS 会话
+  /// libcurl 8.12 及以上使用其会话导出接口；更早的版本在 OpenSSL 后端下
+  /// 通过 SSL_CTX 回调按主机记录和恢复会话（其他 TLS 后端下不做任何事）
+  /// </summary>
+  void setTlsSessionCacheFile(const std::string& filePath);
+
+  /// <summary>
+  /// 从文件导入 TLS 会话到共享缓存（文件经 AES 加密并带 HMAC 校验）
+  /// </summary>
+  /// <returns>导入的会话数量，失败返回 -1</returns>
+  static int loadTlsSessions(const std::string& filePath);
+
+  /// <summary>
+  /// 把共享缓存中的 TLS 会话加密写入文件（POSIX 下权限为 0600）
+  /// </summary>
+  static bool saveTlsSessions(const std::string& filePath);
+
+  /// <summary>
+  /// 设置异步回调的执行器（需在首个异步请求之前设置）
+  /// </summary>
+  void setCallbackExecutor(Executor executor);
+
+  /// <summary>
+  /// 设置异步请求的并发上限与等待队列长度（需在首个异步请求之前设置）
+  /// 仅对禁用共享缓存的客户端生效
+  /// </summary>
+  void setAsyncLimits(size_t maxInFlight, size_t maxQueued);
+
+  /// <summary>
+  /// GET 请求（异步）
+  /// </summary>
+  HttpRequestHandle getAsync(const std::string& url,
+                             ResponseCallback callback);
 
   /// <summary>
   /// POST 请求（异步）
   /// </summary>
-  void postAsync(const std::string& url, const std::string& data,
-                 ResponseCallback callback,
-                 const std::string& contentType = "application/json");
+  HttpRequestHandle postAsync(
+      const std::string& url, const std::string& data,
+      ResponseCallback callback,
+      const std::string& contentType = "application/json");
+
+  // ===== 外部事件循环 =====
+
+  /// <summary>
+  /// 接入使用方的事件循环（需在首个异步请求之前调用）
+  /// 客户端不再创建事件循环线程，异步请求由下面的事件入口驱动（见 CurlMultiEngine）；
+  /// 同步请求在调用线程直接执行，不经过事件循环
+  /// </summary>
+  /// <returns>已经在使用内置事件循环时返回 false</returns>
+  bool setEventLoopCallbacks(CurlMultiEngine::WatchCallback watch,
+                             CurlMultiEngine::TimerCallback timer);
+
+  /// <summary>
+  /// 当前需要监听的套接字及读写兴趣
+  /// </summary>
+  std::vector<CurlMultiEngine::SocketWatch> watchedSockets() const;
+
+  /// <summary>
+  /// 距下次应调用 onTimeout 的毫秒数，-1 表示没有定时器
+  /// </summary>
+  long eventLoopTimeoutMs() const;
+
+  /// <summary>
+  /// 事件入口（在事件循环线程调用，异步回调也在此线程执行）
+  /// </summary>
+  void onReadable(int fd);
+  void onWritable(int fd);
+  void onTimeout();
 
  private:
-  int m_timeout;
-  bool m_verifySSL;
-  std::map<std::string, std::string> m_headers;
+  struct Transfer;
+
+  // 配置快照及由它派生的请求头链表缓存
+  struct Snapshot;
+  using SnapshotPtr = std::shared_ptr<const Snapshot>;
 
-  // 内部执行请求的方法
-  Response performRequest(const std::string& url, const std::string& method,
-                          const std::string& data = "");
+  // 配置（写时复制：修改时替换整个快照，进行中的请求继续使用旧快照）
+  SnapshotPtr m_snapshot;
+  mutable std::mutex m_optionsMutex;
+
+  SnapshotPtr snapshot() const;
+  void updateOptions(const std::function<void(Options&)>& update);
+
+  // 空闲 curl 句柄池（CURL*），句柄内保存着可复用的连接
+  // 按线程分片，并发请求的线程之间不争用同一把锁
+  struct HandlePool {
+    std::vector<void*> idle;
+    std::mutex mutex;
+  };
+  static const size_t kHandlePoolShards = 8;
+  HandlePool m_handlePools[kHandlePoolShards];
+
+  void* acquireHandle(size_t& shard);
+  void releaseHandle(void* handle, size_t shard);
+
+  // 异步请求引擎（首个异步请求时获取：共享引擎或私有引擎）
+  std::shared_ptr<CurlMultiEngine> m_engine;
+  mutable std::mutex m_engineMutex;
+
+  std::shared_ptr<CurlMultiEngine> engine();
+  std::shared_ptr<CurlMultiEngine> currentEngine() const;
+
+  // 已提交到引擎、尚未结束的传输（侵入式双向链表）；析构时取消并等待它们结束
+  Transfer* m_inFlight = nullptr;
+  std::mutex m_inFlightMutex;
+  std::condition_variable m_inFlightDone;
+
+  void transferDone(Transfer* transfer);
+  // 在完成回调中析构：取消进行中的传输并与本客户端解除关联，由引擎稍后结束
+  void detachInFlight();
+
+  // 回调闸门：析构时关闭，尚未开始的回调不再执行，正在执行的回调结束后才返回
+  struct CallbackGate;
+  std::shared_ptr<CallbackGate> m_callbackGate;
+
+  // 在 transfer 的 easy 句柄上配置请求
+  bool prepareTransfer(Transfer& transfer, const Request& request);
+  // 根据 curl 结果填充响应并归还句柄
+  void finishTransfer(Transfer& transfer, int curlCode);
+
+  // 提交异步传输，队列已满时立即以错误回调
+  // executor 为空时回调在事件循环线程执行
+  // promise 不为空时结果移入 promise（同步请求，不复制响应体）
+  HttpRequestHandle submitAsync(
+      const Request& request, ResponseCallback callback, Executor executor,
+      std::shared_ptr<std::promise<Response>> promise = nullptr);
+};
+
+/// <summary>
+/// 授权客户端使用的传输层接口
+/// 默认实现 CurlHttpTransport 通过 libcurl 发送请求；测试与基准测试可替换为
+/// InProcessTransport（in_process_transport.h），直接调用进程内的服务端处理函数
+/// </summary>
+class HttpTransport {
+ public:
+  virtual ~HttpTransport() = default;
+
+  /// <summary>
+  /// 同步发送请求（线程安全）
+  /// </summary>
+  virtual HttpClientCpp::Response send(const HttpClientCpp::Request& request) = 0;
+
+  /// <summary>
+  /// 异步发送请求（线程安全），每个请求恰好回调一次
+  /// 不支持取消的实现返回无效句柄
+  /// </summary>
+  virtual HttpRequestHandle sendAsync(const HttpClientCpp::Request& request,
+                                      HttpClientCpp::ResponseCallback callback) = 0;
+
+  /// <summary>
+  /// 设置连接超时与单个请求的总超时（毫秒）
+  /// </summary>
+  virtual void setTimeouts(long connectTimeoutMs, long timeoutMs) = 0;
+
+  /// <summary>
+  /// 取消所有进行中的异步请求并等待其回调结束
+  /// </summary>
+  virtual void cancelAll() = 0;
+
+  /// <summary>
+  /// 底层 libcurl 客户端（其他实现返回 nullptr）
+  /// </summary>
+  virtual HttpClientCpp* httpClient() { return nullptr; }
+};
+
+/// <summary>
+/// 基于 HttpClientCpp 的传输层
+/// </summary>
+class CurlHttpTransport : public HttpTransport {
+ public:
+  CurlHttpTransport() = default;
+  explicit CurlHttpTransport(const HttpClientCpp::Options& options)
+      : m_client(options) {}
+
+  HttpClientCpp::Response send(const HttpClientCpp::Request& request) override {
+    return m_client.send(request);
+  }
+
+  HttpRequestHandle sendAsync(const HttpClientCpp::Request& request,
+                              HttpClientCpp::ResponseCallback callback) override {
+    return m_client.sendAsync(request, std::move(callback));
+  }
+
+  void setTimeouts(long connectTimeoutMs, long timeoutMs) override {
+    m_client.setConnectTimeoutMs(connectTimeoutMs);
+    m_client.setTimeoutMs(timeoutMs);
+  }
+
+  void cancelAll() override { m_client.cancelAll(); }
+
+  HttpClientCpp* httpClient() override { return &m_client; }
+
+ private:
+  HttpClientCpp m_client;
+};
+
+/// <summary>
+/// 熔断器（线程安全）
+/// 连续失败达到阈值后打开，打开期间直接拒绝请求；冷却期结束后半开，
+/// 放行少量试探请求，成功则关闭，失败则重新打开并延长冷却期
+/// </summary>
+class CircuitBreaker {
+ public:
+  struct Options {
+    int failureThreshold = 5;   // 连续失败多少次后打开
+    long openMs = 30000;        // 首次打开的冷却期
+    long maxOpenMs = 300000;    // 冷却期上限（连续打开时翻倍）
+    int halfOpenRequests = 1;   // 半开状态下同时放行的试探请求数
+  };
+
+  enum State { Closed, Open, HalfOpen };
+
+  CircuitBreaker();
+  explicit CircuitBreaker(const Options& options);
+
+  void setOptions(const Options& options);
+
+  /// <summary>
+  /// 是否放行请求；放行后必须调用 onSuccess 或 onFailure
+  /// </summary>
+  bool allowRequest();
+
+  void onSuccess();
+  void onFailure();
+
+  /// <summary>
+  /// 请求被取消：不计入成败，只归还半开状态下的试探名额
+  /// </summary>
+  void onCancelled();
+
+  State state() const;
+
+ private:
+  Options m_options;
+  State m_state;
+  int m_failures;        // 连续失败次数
+  int m_opens;           // 连续打开次数（决定冷却期）
+  int m_halfOpenInFlight;
+  std::chrono::steady_clock::time_point m_openUntil;
+  mutable std::mutex m_mutex;
+};
+
+/// <summary>
+/// 合并相同的并发调用（single-flight，线程安全）
+/// 同一个键同时只执行一次，执行期间加入的调用方都得到同一个结果
+/// </summary>
+template <typename T>
+class SingleFlight {
+ public:
+  using Callback = std::function<void(const T&)>;
+
+  /// <summary>
+  /// 加入对 key 的调用
+  /// 返回 true 表示调用方是领头者，必须执行调用并以结果调用 complete；
+  /// 返回 false 表示已有相同调用在执行，callback 将在其结束时被调用
+  /// </summary>
+  bool join(const std::string& key, Callback callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto result = m_calls.emplace(key, std::vector<Callback>());
+    result.first->second.push_back(std::move(callback));
+    return result.second;
+  }
+
+  /// <summary>
+  /// 结束对 key 的调用，把结果交给所有等待者（在当前线程回调）
+  /// </summary>
+  void complete(const std::string& key, const T& value) {
+    std::vector<Callback> callbacks;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto it = m_calls.find(key);
+      if (it == m_calls.end()) return;
+      callbacks = std::move(it->second);
+      m_calls.erase(it);
+    }
+
+    for (Callback& callback : callbacks) {
+      if (callback) callback(value);
+    }
+  }
+
+ private:
+  std::mutex m_mutex;
+  std::unordered_map<std::string, std::vector<Callback>> m_calls;
 };
 
 /// <summary>
 /// 授权客户端（纯 C++ 实现）
-/// 使用 HttpClientCpp + SecureTransportCpp
+/// 使用 HttpTransport（默认 HttpClientCpp）+ SecureTransportCpp
 /// </summary>
 class LicenseClientCpp {
  public:
   LicenseClientCpp(const std::string& serverUrl);
+
+  /// <summary>
+  /// 使用多个服务器地址（互为备份）
+  /// 每个请求发往测得延迟最低的健康服务器，连续失败的服务器被暂时剔除，
+  /// 定期探测其 /health 接口，恢复后重新参与选择
+  /// </summary>
+  LicenseClientCpp(const std::vector<std::string>& serverUrls);
+
+  /// <summary>
+  /// 使用指定的传输层（为空时使用 CurlHttpTransport）
+  /// 传输层可在多个客户端之间共享，析构客户端只取消它自己发出的请求，
+  /// 并等待这些请求回调：传入的传输层接入外部事件循环时，析构期间该循环
+  /// 须继续运行（或先调用传输层的 cancelAll）
+  /// </summary>
+  LicenseClientCpp(const std::vector<std::string>& serverUrls,
+                   std::shared_ptr<HttpTransport> transport);
   ~LicenseClientCpp();
 
   /// <summary>
@@ -96,6 +535,142 @@ class LicenseClientCpp {
   /// </summary>
   void setAppSecret(const std::string& secret);
 
+  /// <summary>
+  /// 启用/禁用二进制线格式（默认禁用）
+  /// 启用后首个请求仍使用 JSON，服务端通过 Accept-Post 响应头声明支持
+  /// application/x-license-packet 后才切换；收到 415 时自动回退到 JSON
+  /// </summary>
+  void setBinaryWireFormat(bool enabled);
+
+  /// <summary>
+  /// 设置 TLS 会话磁盘缓存文件（见 HttpClientCpp::setTlsSessionCacheFile）
+  /// </summary>
+  void setTlsSessionCacheFile(const std::string& filePath);
+
+  /// <summary>
+  /// 底层 HTTP 客户端，用于接入外部事件循环等传输层设置
+  /// （例如 httpClient()->setEventLoopCallbacks(...)，之后用 startVerifyLicense 等
+  /// 非阻塞接口，由使用方的事件循环驱动，不额外创建线程）
+  /// 传输层不基于 libcurl 时返回 nullptr
+  /// </summary>
+  HttpClientCpp* httpClient() { return m_transport->httpClient(); }
+
+  /// <summary>
+  /// 预热连接（立即返回）
+  /// 在后台向每个服务器发送 /health 请求，提前完成 DNS 解析、TCP 连接与
+  /// TLS 握手，连接空闲保留在连接池中，之后的首个请求只有请求本身的延迟；
+  /// 同时测得各服务器的初始延迟。正在探测的服务器不会重复发送
+  /// 探测经由共享的事件循环（CurlMultiEngine）发送，其连接只被同样经由事件循环
+  /// 的请求复用：启用 HTTP/2（默认）时的同步请求与所有异步请求。
+  /// 关闭 HTTP/2 时同步请求使用各自的 curl 句柄，只复用预热得到的 DNS 缓存与
+  /// TLS 会话（会话恢复，握手少一个往返），仍需新建 TCP 连接
+  /// </summary>
+  void prewarm();
+
+  /// <summary>
+  /// 超时与重试策略
+  /// 失败的请求（网络错误、408/502/503/504）按带抖动的指数退避重试，
+  /// 每次重试都生成新的数据包（新的时间戳与 nonce）；
+  /// 每次尝试的超时不超过总时限的剩余部分。429 与申请许可证不重试
+  /// </summary>
+  struct RetryPolicy {
+    long connectTimeoutMs = 3000;  // 单次尝试的连接超时
+    long attemptTimeoutMs = 5000;  // 单次尝试的总超时
+    int maxAttempts = 3;           // 最多尝试次数（含首次）
+    long initialBackoffMs = 100;   // 首次重试前的退避上限
+    long maxBackoffMs = 2000;      // 单次退避上限
+    long totalTimeoutMs = 15000;   // 全部尝试（含退避）的总时限
+  };
+
+  /// <summary>
+  /// 设置超时与重试策略（需在首个请求之前设置）
+  /// </summary>
+  void setRetryPolicy(const RetryPolicy& policy);
+
+  /// <summary>
+  /// 对冲请求策略（默认禁用）
+  /// 首个请求在最近请求耗时的 p95 之后仍未返回时，再发送一个副本，
+  /// 采用先返回的结果并取消另一个
+  /// </summary>
+  struct HedgePolicy {
+    bool enabled = false;
+    double percentile = 0.95;     // 对冲延迟取最近耗时的分位数
+    long initialDelayMs = 200;    // 样本不足时的对冲延迟
+    long minDelayMs = 20;         // 对冲延迟下限
+    long maxDelayMs = 2000;       // 对冲延迟上限
+  };
+
+  /// <summary>
+  /// 设置对冲请求策略（需在首个请求之前设置）
+  /// </summary>
+  void setHedgePolicy(const HedgePolicy& policy);
+
+  /// <summary>
+  /// 服务器选择与健康检查策略
+  /// </summary>
+  struct EndpointPolicy {
+    double ewmaAlpha = 0.3;        // 延迟 EWMA 的平滑系数（越大越看重最近样本）
+    int failuresToEject = 3;       // 连续失败多少次后剔除
+    long ejectionMs = 10000;       // 首次剔除时长，连续剔除时翻倍
+    long maxEjectionMs = 300000;   // 剔除时长上限
+    long probeIntervalMs = 10000;  // 空闲服务器的探测间隔（刷新延迟估计）
+  };
+
+  /// <summary>
+  /// 设置服务器选择策略（需在首个请求之前设置）
+  /// </summary>
+  void setEndpointPolicy(const EndpointPolicy& policy);
+
+  /// <summary>
+  /// 设置熔断器参数
+  /// 服务器连续失败后直接返回 "Circuit open" 错误，不再等待超时
+  /// </summary>
+  void setCircuitBreaker(const CircuitBreaker::Options& options);
+
+  /// <summary>
+  /// 启用离线宽限模式
+  /// 验证成功的结果经 AES 加密并带 HMAC 签名保存到 filePath；
+  /// 服务器不可用（网络错误或熔断）时，若最近一次成功验证距今不超过
+  /// graceSeconds 且许可证未过期，则返回该结果（offline 为 true）
+  /// </summary>
+  /// <param name="filePath">宽限缓存文件，为空时禁用</param>
+  /// <param name="graceSeconds">宽限时长（秒）</param>
+  void setOfflineGrace(const std::string& filePath, long graceSeconds);
+
+  /// <summary>
+  /// 验证结果缓存参数
+  /// </summary>
+  struct VerifyCacheOptions {
+    long ttlSeconds = 600;          // 缓存有效期（不超过许可证过期时间）
+    long refreshAheadSeconds = 120;  // 到期前多久开始后台刷新
+    size_t maxEntries = 1024;        // 最多缓存的条目数
+    std::string filePath;            // 磁盘缓存文件（为空时只缓存在内存）
+  };
+
+  /// <summary>
+  /// 启用验证结果缓存
+  /// 有效的验证结果按（机器码, 许可证密钥）缓存，命中时 verifyLicense
+  /// 不访问网络；临近到期时在后台线程刷新（stale-while-revalidate），
+  /// 缓存保持温热时调用方不会等待网络。磁盘文件经 AES 加密并带 HMAC 签名，
+  /// 只保存许可证密钥的摘要
+  /// </summary>
+  void setVerifyCache(const VerifyCacheOptions& options);
+
+  /// <summary>
+  /// 清空验证结果缓存（内存与磁盘）
+  /// </summary>
+  void clearVerifyCache();
+
+  /// <summary>
+  /// 服务器状态快照
+  /// </summary>
+  struct EndpointStatus {
+    std::string url;
+    double latencyMs;  // 延迟 EWMA（尚无样本时为 0）
+    bool healthy;      // 未被剔除
+  };
+  std::vector<EndpointStatus> endpointStatus() const;
+
   /// <summary>
   /// 请求授权（同步）
   /// </summary>
@@ -116,11 +691,60 @@ class LicenseClientCpp {
     bool valid;
     std::string message;
     std::string expiresAt;
-    std::string error;  // 错误信息
+    std::string error;     // 错误信息
+    bool offline = false;  // 服务器不可用，结果来自离线宽限缓存
+    bool cached = false;   // 结果来自本地验证缓存，未访问网络
   };
   VerifyResponse verifyLicense(const std::string& machineCode,
                                const std::string& licenseKey);
 
+  /// <summary>
+  /// 验证授权（异步）
+  /// 缓存命中时在当前线程立即回调；否则在后台工作线程池执行验证
+  /// （不同的验证并行执行，各自带重试与对冲），
+  /// 与同时进行的相同验证（同步或异步）合并为一个请求，
+  /// 回调在执行该请求的线程调用。客户端析构时未执行的验证以
+  /// "Client destroyed" 错误回调
+  /// </summary>
+  using VerifyCallback = std::function<void(const VerifyResponse&)>;
+  void verifyLicenseAsync(const std::string& machineCode,
+                          const std::string& licenseKey,
+                          VerifyCallback callback);
+
+  /// <summary>
+  /// 非阻塞验证：请求直接提交到事件循环，不占用任何线程等待
+  /// 缓存命中时在当前线程立即回调（返回无效句柄）；否则发送单次请求
+  /// （不重试、不对冲，仍经过熔断器与服务器选择），回调在事件循环线程
+  /// （或 setCallbackExecutor 指定的执行器）执行，回调中不要做阻塞操作。
+  /// 验证缓存与离线宽限文件的写入交给后台工作线程，不占用事件循环线程；
+  /// 被取消的请求以 error 为 "Request cancelled" 的结果回调。
+  /// C++20 协程接口见 license_client_coro.h
+  /// </summary>
+  /// <param name="timeoutMs">本次请求的时限（毫秒），0 使用重试策略中的单次超时</param>
+  HttpRequestHandle startVerifyLicense(const std::string& machineCode,
+                                       const std::string& licenseKey,
+                                       VerifyCallback callback,
+                                       long timeoutMs = 0);
+
+  /// <summary>
+  /// 非阻塞请求授权（见 startVerifyLicense）
+  /// </summary>
+  using LicenseCallback = std::function<void(const LicenseResponse&)>;
+  HttpRequestHandle startRequestLicense(const std::string& machineCode,
+                                        const std::string& userInfo,
+                                        LicenseCallback callback,
+                                        long timeoutMs = 0);
+
+  /// <summary>
+  /// 批量验证授权（同步，每 1000 条一次请求，与服务端单批上限一致）
+  /// 数据包签名覆盖全部条目：数据包机器码字段为
+  /// SHA256(机器码:许可证密钥\n ...) 的十六进制摘要（两者均去掉首尾空白）
+  /// </summary>
+  /// <param name="items">（机器码, 许可证密钥）列表</param>
+  /// <returns>与 items 一一对应的验证结果</returns>
+  std::vector<VerifyResponse> verifyLicenses(
+      const std::vector<std::pair<std::string, std::string>>& items);
+
   /// <summary>
   /// 获取许可证信息（同步）
   /// </summary>
@@ -135,6 +759,207 @@ class LicenseClientCpp {
   LicenseInfo getLicenseInfo(const std::string& machineCode);
 
  private:
-  std::string m_serverUrl;
-  HttpClientCpp m_httpClient;
+  // 二进制线格式协商状态
+  enum WireState { WireUnknown, WireBinary, WireJson };
+
+  // 一次待发送的请求（每次尝试重新生成，服务器地址在发送时选择）
+  struct PreparedRequest {
+    std::string path;
+    std::string body;
+    std::string contentType;
+    bool binary = false;
+    std::string error;  // 无法生成请求（如机器码超长）时的原因，不发送
+  };
+  using RequestFactory = std::function<PreparedRequest()>;
+
+  // 最近成功请求的耗时样本数（用于计算对冲延迟）
+  static const size_t kLatencySamples = 128;
+
+  // 服务器及其健康状态（受 m_endpointMutex 保护）
+  struct Endpoint {
+    std::string url;
+    double ewmaMs = 0.0;
+    int samples = 0;
+    int consecutiveFailures = 0;
+    int ejections = 0;  // 连续剔除次数（决定剔除时长）
+    bool ejected = false;
+    bool probing = false;
+    std::chrono::steady_clock::time_point nextProbe;
+  };
+
+  // 探测回调访问服务器状态，需在 m_transport 之前声明（析构晚于它）
+  std::vector<Endpoint> m_endpoints;
+  mutable std::mutex m_endpointMutex;
+  EndpointPolicy m_endpointPolicy;
+  RetryPolicy m_retryPolicy;
+  HedgePolicy m_hedgePolicy;
+
+  std::shared_ptr<HttpTransport> m_transport;
+  // 传输层由本客户端创建（未由调用方传入）：析构时可直接结束其全部请求
+  bool m_ownsTransport = false;
+
+  // 本客户端发出、尚未回调的异步请求（键存在即未完成）
+  // 传输层可能被共享，析构时只取消并等待这些请求
+  std::unordered_map<uint64_t, HttpRequestHandle> m_asyncRequests;
+  uint64_t m_nextAsyncId;
+  std::mutex m_asyncMutex;
+  std::condition_variable m_asyncDone;
+
+  HttpRequestHandle sendAsyncTracked(const HttpClientCpp::Request& request,
+                                     HttpClientCpp::ResponseCallback callback);
+  void cancelAsyncRequests();
+  CircuitBreaker m_breaker;
+  bool m_binaryWireEnabled;
+  std::atomic<int> m_wireState;
+
+  // 耗时样本环形缓冲区（毫秒）
+  std::vector<long> m_latencies;
+  size_t m_latencyNext;
+  std::mutex m_latencyMutex;
+
+  // 发送携带安全数据包的 POST 请求
+  // extraField/extraValue 为附加字段（二进制格式下作为包体后的尾部数据）
+  HttpClientCpp::Response postSecurePacket(const std::string& path,
+                                           const std::string& machineCode,
+                                           const std::string& action,
+                                           const std::string& extraField,
+                                           const std::string& extraValue);
+
+  // 生成携带新数据包的请求（按当前线格式）
+  PreparedRequest prepareSecureRequest(const std::string& path,
+                                       const std::string& machineCode,
+                                       const std::string& action,
+                                       const std::string& extraField,
+                                       const std::string& extraValue);
+
+  // 批量验证 items[begin, end)，结果写入 results 的对应位置
+  void verifyLicenseBatch(
+      const std::vector<std::pair<std::string, std::string>>& items,
+      size_t begin, size_t end, std::vector<VerifyResponse>& results);
+
+  // 按重试与对冲策略发送请求（非幂等请求只发送一次，不重试也不对冲）
+  HttpClientCpp::Response sendWithPolicy(const RequestFactory& factory,
+                                         bool idempotent = true);
+
+  // 发送一次请求，启用对冲时可能发出两个副本（均在 timeoutMs 内结束）
+  HttpClientCpp::Response sendHedged(const RequestFactory& factory,
+                                     PreparedRequest& sent, long timeoutMs);
+
+  // 根据响应更新线格式协商状态，需要以 JSON 重发时返回 true
+  bool updateWireState(const PreparedRequest& request,
+                       const HttpClientCpp::Response& response);
+
+  // 验证结果缓存（键为 机器码:SHA256(许可证密钥)）
+  struct CachedVerify {
+    VerifyResponse result;
+    int64_t freshUntil = 0;  // 有效期截止（Unix 时间）
+    bool refreshing = false;
+  };
+  bool m_cacheEnabled;
+  bool m_cacheLoaded;  // 磁盘缓存在首次查找时读取（此时已设置应用密钥）
+  VerifyCacheOptions m_cacheOptions;
+  std::unordered_map<std::string, CachedVerify> m_verifyCache;
+  std::mutex m_cacheMutex;
+  // 缓存文件在 m_cacheMutex 之外加密写入：每次修改递增版本号，
+  // 只写入比已写入版本更新的快照（受 m_cacheFileMutex 保护）
+  uint64_t m_cacheVersion = 0;
+  uint64_t m_cacheWrittenVersion = 0;
+  std::mutex m_cacheFileMutex;
+
+  // 后台工作线程池：缓存刷新与异步验证
+  // 排队任务多于空闲线程时按需创建线程（最多 kMaxWorkerThreads 个），
+  // 不同的验证并行执行，慢请求不阻塞后面的验证
+  // 任务参数为 false 表示客户端正在析构，任务需放弃执行并通知等待者
+  using WorkerTask = std::function<void(bool run)>;
+  static const size_t kMaxWorkerThreads = 8;
+  std::vector<std::thread> m_workerThreads;
+  std::deque<WorkerTask> m_workerTasks;
+  std::mutex m_workerMutex;
+  std::condition_variable m_workerCv;
+  size_t m_workerIdle = 0;  // 正在等待任务的线程数
+  bool m_workerStop;
+
+  // 进行中的验证（键为 路径 + 机器码 + 许可证密钥）
+  SingleFlight<VerifyResponse> m_verifyFlight;
+
+  // 访问服务器验证（不经过缓存），并更新缓存与离线宽限记录
+  VerifyResponse verifyLicenseRemote(const std::string& machineCode,
+                                     const std::string& licenseKey);
+  // 解析验证响应，并更新缓存与离线宽限记录
+  // deferWrites 为 true 时（事件循环线程）只更新内存，文件写入交给工作线程
+  void finishVerify(const std::string& machineCode,
+                    const std::string& licenseKey,
+                    const HttpClientCpp::Response& response,
+                    VerifyResponse& result, bool deferWrites = false);
+  static void finishRequestLicense(const HttpClientCpp::Response& response,
+                                   LicenseResponse& result);
+  // 非阻塞发送携带安全数据包的请求（单次，不重试）
+  HttpRequestHandle startSecurePacket(const std::string& path,
+                                      const std::string& machineCode,
+                                      const std::string& action,
+                                      const std::string& extraField,
+                                      const std::string& extraValue,
+                                      long timeoutMs,
+                                      HttpClientCpp::ResponseCallback onResponse);
+  // 合并相同的并发验证：已有进行中的验证时等待其结果，否则在本线程执行
+  VerifyResponse verifyCoalesced(const std::string& machineCode,
+                                 const std::string& licenseKey);
+  bool lookupVerifyCache(const std::string& machineCode,
+                         const std::string& licenseKey,
+                         VerifyResponse& result);
+  void storeVerifyCache(const std::string& machineCode,
+                        const std::string& licenseKey,
+                        const VerifyResponse& result, bool deferWrite = false);
+  // 持有 m_cacheMutex 时调用：更新条目，缓存内容有变化时返回 true
+  bool updateVerifyCacheLocked(const std::string& machineCode,
+                               const std::string& licenseKey,
+                               const VerifyResponse& result);
+  // 持有 m_cacheMutex 时调用：序列化当前缓存（不加密、不写文件）
+  std::string snapshotVerifyCacheLocked() const;
+  void loadVerifyCacheLocked();
+  // 不持有 m_cacheMutex 时调用：加密并写入快照
+  void writeVerifyCache(const std::string& filePath, const std::string& records,
+                        uint64_t version);
+  void postWorkerTask(WorkerTask task);
+  void workerLoop();
+
+  // 离线宽限缓存
+  std::string m_graceFile;
+  long m_graceSeconds;
+  std::mutex m_graceMutex;
+  // 当前记录（不含验证时间）及其验证时间：文件只在首次使用时读取，
+  // 之后离线回退直接使用内存中的记录
+  bool m_graceLoaded = false;
+  std::string m_graceRecord;
+  int64_t m_graceRecordAt = 0;
+  // 最近写入文件的记录及其验证时间，内容未变时不重写
+  std::string m_graceWritten;
+  int64_t m_graceWrittenAt = 0;
+  // 文件写入可能在工作线程进行：只写入比已写入版本更新的记录
+  uint64_t m_graceVersion = 0;
+  uint64_t m_graceWrittenVersion = 0;
+  std::mutex m_graceFileMutex;
+
+  void saveOfflineGrace(const std::string& machineCode,
+                        const std::string& licenseKey,
+                        const VerifyResponse& result, bool deferWrite = false);
+  bool loadOfflineGrace(const std::string& machineCode,
+                        const std::string& licenseKey, VerifyResponse& result);
+  // 持有 m_graceMutex 时调用：首次使用时把文件读入内存
+  void loadOfflineGraceLocked();
+  // 不持有 m_graceMutex 时调用：加密并写入记录
+  void writeOfflineGrace(const std::string& filePath, const std::string& record,
+                         int64_t verifiedAt, uint64_t version);
+
+  void recordLatency(long milliseconds);
+  long hedgeDelayMs();
+
+  // 选择延迟最低的健康服务器（exclude 为对冲时避开的服务器），
+  // 同时发起到期的探测
+  size_t selectEndpoint(size_t exclude = static_cast<size_t>(-1));
+  // 记录一次请求结果：成功更新延迟，失败累计并在达到阈值时剔除
+  void reportEndpoint(size_t index, const HttpClientCpp::Response& response,
+                      long latencyMs);
+  // 探测服务器的 /health 接口（异步）
+  void probeEndpoint(size_t index);
 };
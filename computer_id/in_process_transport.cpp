@@ -0,0 +1,253 @@
+#include "in_process_transport.h"
+
+#include <algorithm>
+#include <utility>
+
+// 与 libcurl 的错误信息保持一致，调用方的重试判断不需要区分传输层
+static const char* const kTimeoutError = "Timeout was reached";
+static const char* const kCancelledError = "Request cancelled";
+
+static HttpClientCpp::Response errorResponse(const char* error) {
+  HttpClientCpp::Response response;
+  response.statusCode = 0;
+  response.success = false;
+  response.error = error;
+  return response;
+}
+
+// ============================================================================
+// InProcessTransport 实现
+// ============================================================================
+
+InProcessTransport::InProcessTransport(Handler handler)
+    : InProcessTransport(std::move(handler), Options()) {}
+
+InProcessTransport::InProcessTransport(Handler handler, const Options& options)
+    : m_handler(std::move(handler)),
+      m_options(options),
+      m_timeoutMs(30000),
+      m_requestCount(0),
+      m_random(options.seed),
+      m_nextSequence(0),
+      m_running(0),
+      m_purgeCancelled(false),
+      m_stop(false),
+      m_wakeToken(std::make_shared<WakeToken>()) {
+  m_wakeToken->owner = this;
+
+  size_t threads = std::max<size_t>(1, options.asyncThreads);
+  for (size_t i = 0; i < threads; i++) {
+    m_workers.emplace_back(&InProcessTransport::workerLoop, this);
+  }
+}
+
+InProcessTransport::~InProcessTransport() {
+  // 此后句柄的 cancel() 不再访问本对象
+  {
+    std::lock_guard<std::mutex> lock(m_wakeToken->mutex);
+    m_wakeToken->owner = nullptr;
+  }
+  cancelAll();
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  for (std::thread& worker : m_workers) {
+    worker.join();
+  }
+}
+
+long InProcessTransport::nextLatencyUs() {
+  if (m_options.jitterUs <= 0) {
+    return m_options.latencyUs;
+  }
+
+  std::lock_guard<std::mutex> lock(m_randomMutex);
+  std::uniform_int_distribution<long> jitter(0, m_options.jitterUs);
+  return m_options.latencyUs + jitter(m_random);
+}
+
+long InProcessTransport::timeoutUs(const HttpClientCpp::Request& request) const {
+  long timeoutMs = request.timeoutMs > 0 ? request.timeoutMs : m_timeoutMs.load();
+  return timeoutMs * 1000;
+}
+
+HttpClientCpp::Response InProcessTransport::dispatch(
+    const HttpClientCpp::Request& request) {
+  m_requestCount++;
+
+  HttpClientCpp::Response response = m_handler(request);
+  response.success = response.error.empty() && response.statusCode >= 200 &&
+                     response.statusCode < 300;
+
+  // 与 HttpClientCpp 一致：指定了响应缓冲区时响应体写入缓冲区（保留其容量）
+  if (request.responseBuffer) {
+    request.responseBuffer->assign(response.body);
+    response.body.clear();
+  }
+  return response;
+}
+
+HttpClientCpp::Response InProcessTransport::send(
+    const HttpClientCpp::Request& request) {
+  auto start = Clock::now();
+  long latencyUs = nextLatencyUs();
+  long limitUs = timeoutUs(request);
+
+  if (latencyUs > limitUs) {
+    std::this_thread::sleep_until(start + std::chrono::microseconds(limitUs));
+    return errorResponse(kTimeoutError);
+  }
+
+  std::this_thread::sleep_until(start + std::chrono::microseconds(latencyUs));
+  return dispatch(request);
+}
+
+HttpRequestHandle InProcessTransport::sendAsync(
+    const HttpClientCpp::Request& request,
+    HttpClientCpp::ResponseCallback callback) {
+  Pending pending;
+  pending.latencyUs = nextLatencyUs();
+  pending.due = Clock::now() + std::chrono::microseconds(std::min(
+                                   pending.latencyUs, timeoutUs(request)));
+  pending.request = request;
+  pending.callback = std::move(callback);
+  pending.state = std::make_shared<AsyncRequest>();
+  pending.state->token = m_wakeToken;
+  HttpRequestHandle handle(pending.state);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_stop) {
+      pending.sequence = m_nextSequence++;
+      m_pending.push(std::move(pending));
+      m_cv.notify_one();
+      return handle;
+    }
+  }
+
+  finish(pending, errorResponse(kCancelledError));
+  return handle;
+}
+
+void InProcessTransport::AsyncRequest::cancelRequested() {
+  std::shared_ptr<WakeToken> wake = token.lock();
+  if (!wake) return;
+  std::lock_guard<std::mutex> lock(wake->mutex);
+  if (wake->owner) wake->owner->onCancelRequested();
+}
+
+void InProcessTransport::onCancelRequested() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_purgeCancelled = true;
+  m_cv.notify_one();
+}
+
+void InProcessTransport::finish(Pending& pending,
+                                const HttpClientCpp::Response& response) {
+  pending.state->done.store(true);
+  if (pending.callback) {
+    pending.callback(response);
+  }
+}
+
+std::vector<InProcessTransport::Pending>
+InProcessTransport::takeCancelledLocked() {
+  std::vector<Pending> cancelled;
+  std::vector<Pending> remaining;
+  while (!m_pending.empty()) {
+    Pending& top = const_cast<Pending&>(m_pending.top());
+    if (top.state->cancelled.load()) {
+      cancelled.push_back(std::move(top));
+    } else {
+      remaining.push_back(std::move(top));
+    }
+    m_pending.pop();
+  }
+  for (Pending& pending : remaining) {
+    m_pending.push(std::move(pending));
+  }
+  return cancelled;
+}
+
+void InProcessTransport::setTimeouts(long /*connectTimeoutMs*/, long timeoutMs) {
+  m_timeoutMs.store(timeoutMs);
+}
+
+void InProcessTransport::cancelAll() {
+  std::vector<Pending> cancelled;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while (!m_pending.empty()) {
+      cancelled.push_back(std::move(const_cast<Pending&>(m_pending.top())));
+      m_pending.pop();
+    }
+  }
+
+  for (Pending& pending : cancelled) {
+    finish(pending, errorResponse(kCancelledError));
+  }
+
+  // 等待正在处理的请求回调结束
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_idle.wait(lock, [this]() { return m_running == 0; });
+}
+
+void InProcessTransport::workerLoop() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while (true) {
+    if (m_stop) {
+      return;
+    }
+    if (m_purgeCancelled) {
+      m_purgeCancelled = false;
+      std::vector<Pending> cancelled = takeCancelledLocked();
+      if (cancelled.empty()) continue;
+
+      m_running++;
+      lock.unlock();
+      for (Pending& pending : cancelled) {
+        finish(pending, errorResponse(kCancelledError));
+      }
+      lock.lock();
+      m_running--;
+      if (m_running == 0) {
+        m_idle.notify_all();
+      }
+      continue;
+    }
+    if (m_pending.empty()) {
+      m_cv.wait(lock);
+      continue;
+    }
+
+    // 等到最早的请求到期（期间可能有更早到期的请求加入）
+    Clock::time_point due = m_pending.top().due;
+    if (Clock::now() < due) {
+      m_cv.wait_until(lock, due);
+      continue;
+    }
+
+    Pending pending = std::move(const_cast<Pending&>(m_pending.top()));
+    m_pending.pop();
+    m_running++;
+    lock.unlock();
+
+    HttpClientCpp::Response response =
+        pending.state->cancelled.load()
+            ? errorResponse(kCancelledError)
+            : pending.latencyUs > timeoutUs(pending.request)
+                  ? errorResponse(kTimeoutError)
+                  : dispatch(pending.request);
+    finish(pending, response);
+
+    lock.lock();
+    m_running--;
+    if (m_running == 0) {
+      m_idle.notify_all();
+    }
+  }
+}
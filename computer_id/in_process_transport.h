@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "http_client_cpp.h"
+
+/// <summary>
+/// 进程内传输：请求直接交给 C++ 服务端处理函数，不经过套接字与 libcurl
+/// 用于测试与基准测试授权客户端自身的序列化、签名与解析开销
+/// 可注入确定性的延迟：固定延迟加上由固定种子生成的抖动，
+/// 同一种子下按请求顺序得到的延迟序列每次运行都相同
+/// </summary>
+class InProcessTransport : public HttpTransport {
+ public:
+  /// <summary>
+  /// 服务端处理函数（可能被多个线程同时调用）
+  /// 返回的响应只需填写状态码、响应体与响应头，success 由状态码决定
+  /// </summary>
+  using Handler =
+      std::function<HttpClientCpp::Response(const HttpClientCpp::Request&)>;
+
+  struct Options {
+    long latencyUs = 0;       // 每个请求的固定延迟（微秒）
+    long jitterUs = 0;        // 附加抖动上限（微秒），在 [0, jitterUs] 中均匀取值
+    uint32_t seed = 1;        // 抖动的随机数种子
+    size_t asyncThreads = 1;  // 执行异步请求（及其回调）的线程数
+  };
+
+  explicit InProcessTransport(Handler handler);
+  InProcessTransport(Handler handler, const Options& options);
+
+  /// <summary>
+  /// 未到期的异步请求以取消结束
+  /// </summary>
+  ~InProcessTransport() override;
+
+  InProcessTransport(const InProcessTransport&) = delete;
+  InProcessTransport& operator=(const InProcessTransport&) = delete;
+
+  /// <summary>
+  /// 在调用线程等待注入的延迟后执行处理函数
+  /// 延迟超过请求时限时等待到时限并以超时失败，不执行处理函数
+  /// </summary>
+  HttpClientCpp::Response send(const HttpClientCpp::Request& request) override;
+
+  /// <summary>
+  /// 请求在延迟到期后由异步线程处理并回调
+  /// 返回的句柄可取消尚未到期的请求：请求立即以 "Request cancelled" 回调
+  /// （在异步线程），已交给处理函数的请求不受影响
+  /// </summary>
+  HttpRequestHandle sendAsync(const HttpClientCpp::Request& request,
+                              HttpClientCpp::ResponseCallback callback) override;
+
+  /// <summary>
+  /// 只使用总超时（没有连接阶段）
+  /// </summary>
+  void setTimeouts(long connectTimeoutMs, long timeoutMs) override;
+
+  void cancelAll() override;
+
+  /// <summary>
+  /// 已交给处理函数的请求数
+  /// </summary>
+  uint64_t requestCount() const { return m_requestCount.load(); }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  // 句柄取消请求时用来唤醒异步线程（句柄可能比传输层活得更久）
+  struct WakeToken {
+    std::mutex mutex;
+    InProcessTransport* owner;
+  };
+
+  // 句柄关联的传输状态（只使用取消与结束标志）
+  struct AsyncRequest : CurlTransfer {
+    std::weak_ptr<WakeToken> token;
+    void complete(int) override {}  // 由异步线程直接回调，不经过引擎
+    void cancelRequested() override;
+  };
+
+  // 等待中的异步请求，按到期时间（相同时按提交顺序）排序
+  struct Pending {
+    Clock::time_point due;
+    uint64_t sequence;
+    long latencyUs;
+    HttpClientCpp::Request request;
+    HttpClientCpp::ResponseCallback callback;
+    std::shared_ptr<AsyncRequest> state;
+
+    bool operator>(const Pending& other) const {
+      return due != other.due ? due > other.due : sequence > other.sequence;
+    }
+  };
+
+  Handler m_handler;
+  Options m_options;
+  std::atomic<long> m_timeoutMs;
+  std::atomic<uint64_t> m_requestCount;
+
+  std::mt19937 m_random;
+  std::mutex m_randomMutex;
+
+  std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>>
+      m_pending;
+  uint64_t m_nextSequence;
+  size_t m_running;  // 正在处理的异步请求数
+  bool m_purgeCancelled;  // 有句柄请求取消，异步线程需移出已取消的请求
+  bool m_stop;
+  std::shared_ptr<WakeToken> m_wakeToken;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::condition_variable m_idle;
+  std::vector<std::thread> m_workers;
+
+  long nextLatencyUs();
+  long timeoutUs(const HttpClientCpp::Request& request) const;
+  // 执行处理函数（延迟已经过去）
+  HttpClientCpp::Response dispatch(const HttpClientCpp::Request& request);
+  // 标记结束并回调
+  static void finish(Pending& pending, const HttpClientCpp::Response& response);
+  void onCancelRequested();
+  // 持有 m_mutex 时调用：从队列移出已取消的请求
+  std::vector<Pending> takeCancelledLocked();
+  void workerLoop();
+};
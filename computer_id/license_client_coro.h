@@ -0,0 +1,172 @@
+#pragma once
+
+#include "http_client_cpp.h"
+
+// C++20 协程接口：项目本身按 C++17 编译，只有以 C++20 编译并包含本头文件的
+// 代码才会用到；编译器不支持协程时本文件为空，可用 LICENSE_CLIENT_HAS_COROUTINES 判断
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>) && \
+    __has_include(<stop_token>)
+
+#define LICENSE_CLIENT_HAS_COROUTINES 1
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <utility>
+
+/// <summary>
+/// 恢复协程的调度器：请求完成后调用 schedule(handle)，由调度器决定在哪个线程恢复
+/// （例如投递到 UI 线程或线程池）
+/// </summary>
+template <class S>
+concept LicenseScheduler = requires(S& scheduler, std::coroutine_handle<> handle) {
+  scheduler.schedule(handle);
+};
+
+/// <summary>
+/// 在完成回调所在线程直接恢复协程（通常是事件循环线程，协程中不要做阻塞操作）
+/// </summary>
+struct InlineLicenseScheduler {
+  void schedule(std::coroutine_handle<> handle) const { handle.resume(); }
+};
+
+/// <summary>
+/// 单次等待的取消与时限
+/// </summary>
+struct LicenseAwaitOptions {
+  std::stop_token stopToken;           // 请求停止时取消请求，结果错误为 "Request cancelled"
+  std::chrono::milliseconds deadline{0};  // 请求时限，0 使用客户端的单次超时
+};
+
+/// <summary>
+/// 可等待的授权请求：co_await 时才发出请求，等待期间不占用线程
+/// 结果中的错误与同步接口一致（超时、熔断、取消均不抛出异常）
+/// </summary>
+template <class Result, LicenseScheduler Scheduler>
+class LicenseAwaitable {
+ public:
+  using Callback = std::function<void(const Result&)>;
+  using Starter = std::function<HttpRequestHandle(Callback, long timeoutMs)>;
+
+  LicenseAwaitable(Starter starter, LicenseAwaitOptions options,
+                   Scheduler scheduler)
+      : m_starter(std::move(starter)),
+        m_options(std::move(options)),
+        m_state(std::make_shared<State>(std::move(scheduler))) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    std::shared_ptr<State> state = m_state;
+    state->handle = handle;
+
+    if (m_options.stopToken.stop_requested()) {
+      state->result.error = "Request cancelled";
+      state->result.message = state->result.error;
+      return false;
+    }
+
+    state->request = m_starter(
+        [state](const Result& result) {
+          state->result = result;
+          // 回调先于挂起完成（如缓存命中）时由 await_suspend 负责继续执行
+          if (state->phase.exchange(kCompleted) == kSuspended) {
+            state->scheduler.schedule(state->handle);
+          }
+        },
+        static_cast<long>(m_options.deadline.count()));
+
+    if (m_options.stopToken.stop_possible()) {
+      state->stopCallback.emplace(m_options.stopToken,
+                                  CancelRequest{state->request});
+    }
+
+    int expected = kStarting;
+    return state->phase.compare_exchange_strong(expected, kSuspended);
+  }
+
+  Result await_resume() {
+    m_state->stopCallback.reset();
+    return std::move(m_state->result);
+  }
+
+ private:
+  enum Phase { kStarting, kSuspended, kCompleted };
+
+  struct CancelRequest {
+    HttpRequestHandle request;
+    void operator()() { request.cancel(); }
+  };
+
+  struct State {
+    explicit State(Scheduler scheduler) : scheduler(std::move(scheduler)) {}
+
+    Result result{};
+    Scheduler scheduler;
+    std::coroutine_handle<> handle;
+    std::atomic<int> phase{kStarting};
+    HttpRequestHandle request;
+    std::optional<std::stop_callback<CancelRequest>> stopCallback;
+  };
+
+  Starter m_starter;
+  LicenseAwaitOptions m_options;
+  std::shared_ptr<State> m_state;
+};
+
+/// <summary>
+/// LicenseClientCpp 的协程包装（不拥有客户端，客户端须比所有等待中的协程活得更久）
+/// 用法：
+///   LicenseClientCoro<> coro(client);
+///   auto result = co_await coro.verifyLicenseAsync(machineCode, licenseKey);
+/// 走 startVerifyLicense / startRequestLicense 的非阻塞路径：单次请求，不重试
+/// </summary>
+template <LicenseScheduler Scheduler = InlineLicenseScheduler>
+class LicenseClientCoro {
+ public:
+  using VerifyAwaitable =
+      LicenseAwaitable<LicenseClientCpp::VerifyResponse, Scheduler>;
+  using RequestAwaitable =
+      LicenseAwaitable<LicenseClientCpp::LicenseResponse, Scheduler>;
+
+  explicit LicenseClientCoro(LicenseClientCpp& client,
+                             Scheduler scheduler = Scheduler())
+      : m_client(client), m_scheduler(std::move(scheduler)) {}
+
+  VerifyAwaitable verifyLicenseAsync(const std::string& machineCode,
+                                     const std::string& licenseKey,
+                                     LicenseAwaitOptions options = {}) {
+    LicenseClientCpp* client = &m_client;
+    return VerifyAwaitable(
+        [client, machineCode, licenseKey](
+            typename VerifyAwaitable::Callback callback, long timeoutMs) {
+          return client->startVerifyLicense(machineCode, licenseKey,
+                                            std::move(callback), timeoutMs);
+        },
+        std::move(options), m_scheduler);
+  }
+
+  RequestAwaitable requestLicenseAsync(const std::string& machineCode,
+                                           const std::string& userInfo = "",
+                                           LicenseAwaitOptions options = {}) {
+    LicenseClientCpp* client = &m_client;
+    return RequestAwaitable(
+        [client, machineCode, userInfo](
+            typename RequestAwaitable::Callback callback, long timeoutMs) {
+          return client->startRequestLicense(machineCode, userInfo,
+                                             std::move(callback), timeoutMs);
+        },
+        std::move(options), m_scheduler);
+  }
+
+ private:
+  LicenseClientCpp& m_client;
+  Scheduler m_scheduler;
+};
+
+#endif
@@ -1,11 +1,14 @@
 #include "secure_transport_cpp.h"
 
 #include <openssl/aes.h>
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
 #include <openssl/evp.h>
 #include <openssl/hmac.h>
 #include <openssl/rand.h>
 #include <openssl/sha.h>
 
+#include <charconv>
 #include <cstring>
 #include <ctime>
 #include <iomanip>
@@ -19,6 +22,7 @@
 // 静态成员初始化
 std::string SecureTransportCpp::s_appSecret =
     "DEFAULT_APP_SECRET_2026_CHANGE_THIS";
+std::atomic<unsigned> SecureTransportCpp::s_appSecretGeneration{0};
 
 SecureTransportCpp::SecureTransportCpp() {}
 
@@ -26,6 +30,7 @@ SecureTransportCpp::~SecureTransportCpp() {}
 
 void SecureTransportCpp::setAppSecret(const std::string& secret) {
   s_appSecret = secret;
+  s_appSecretGeneration++;
 }
 
 // ============================================================================
@@ -126,6 +131,64 @@ std::string SecureTransportCpp::generateSignature(const std::string& data,
   return oss.str();
 }
 
+bool SecureTransportCpp::computePacketMac(std::string_view machineCode,
+                                          int64_t timestamp,
+                                          std::string_view nonce,
+                                          unsigned char mac[32]) {
+  // 每个线程持有一个已设置密钥的 HMAC 上下文，密钥变更后重新设置；
+  // 算法对象只获取一次（OpenSSL 3 的 EVP_MAC 接口）
+  static EVP_MAC* const hmac = EVP_MAC_fetch(nullptr, "HMAC", nullptr);
+  struct ThreadMacContext {
+    EVP_MAC_CTX* ctx = hmac ? EVP_MAC_CTX_new(hmac) : nullptr;
+    unsigned generation = ~0u;
+    ~ThreadMacContext() { EVP_MAC_CTX_free(ctx); }
+  };
+  thread_local ThreadMacContext local;
+  if (!local.ctx) return false;
+
+  unsigned generation = s_appSecretGeneration.load();
+  if (local.generation != generation) {
+    char digest[] = "SHA256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end()};
+    if (EVP_MAC_init(local.ctx,
+                     reinterpret_cast<const unsigned char*>(s_appSecret.data()),
+                     s_appSecret.length(), params) != 1) {
+      return false;
+    }
+    local.generation = generation;
+  } else if (EVP_MAC_init(local.ctx, nullptr, 0, nullptr) != 1) {
+    // 沿用已设置的密钥与摘要算法
+    return false;
+  }
+
+  char tsBuffer[24];
+  auto tsEnd = std::to_chars(tsBuffer, tsBuffer + sizeof(tsBuffer), timestamp);
+  const unsigned char* ts = reinterpret_cast<const unsigned char*>(tsBuffer);
+  size_t tsLength = static_cast<size_t>(tsEnd.ptr - tsBuffer);
+  const unsigned char separator = '|';
+
+  // message = machineCode|timestamp|nonce + timestamp + appSecret
+  EVP_MAC_update(local.ctx,
+                 reinterpret_cast<const unsigned char*>(machineCode.data()),
+                 machineCode.length());
+  EVP_MAC_update(local.ctx, &separator, 1);
+  EVP_MAC_update(local.ctx, ts, tsLength);
+  EVP_MAC_update(local.ctx, &separator, 1);
+  EVP_MAC_update(local.ctx,
+                 reinterpret_cast<const unsigned char*>(nonce.data()),
+                 nonce.length());
+  EVP_MAC_update(local.ctx, ts, tsLength);
+  EVP_MAC_update(local.ctx,
+                 reinterpret_cast<const unsigned char*>(s_appSecret.data()),
+                 s_appSecret.length());
+
+  size_t macLength = 0;
+  return EVP_MAC_final(local.ctx, mac, &macLength, SHA256_DIGEST_LENGTH) == 1 &&
+         macLength == SHA256_DIGEST_LENGTH;
+}
+
 bool SecureTransportCpp::verifySignature(const std::string& data,
                                          int64_t timestamp,
                                          const std::string& signature) {
@@ -374,46 +437,150 @@ std::string SecureTransportCpp::decryptMachineCode(
   }
 }
 
+// ============================================================================
+// 十六进制辅助函数（二进制线格式使用）
+// ============================================================================
+
+static int hexDigitValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;  // 仅接受小写，保证往返编码后签名数据不变
+}
+
+static bool hexToBytes(std::string_view hex, unsigned char* out,
+                       size_t size) {
+  if (hex.length() != size * 2) return false;
+  for (size_t i = 0; i < size; i++) {
+    int high = hexDigitValue(hex[2 * i]);
+    int low = hexDigitValue(hex[2 * i + 1]);
+    if (high < 0 || low < 0) return false;
+    out[i] = static_cast<unsigned char>((high << 4) | low);
+  }
+  return true;
+}
+
+// 写入 size * 2 个字符（不追加结尾 \0）
+static void bytesToHex(const unsigned char* data, size_t size, char* out) {
+  static const char digits[] = "0123456789abcdef";
+  for (size_t i = 0; i < size; i++) {
+    out[2 * i] = digits[data[i] >> 4];
+    out[2 * i + 1] = digits[data[i] & 0x0F];
+  }
+}
+
 // ============================================================================
 // SecurePacketCpp 实现
 // ============================================================================
 
-SecurePacketCpp SecurePacketCpp::create(const std::string& machineCode) {
-  SecurePacketCpp packet;
-  packet.machineCode = machineCode;
+const char* const SecurePacketCpp::kBinaryContentType =
+    "application/x-license-packet";
+
+bool SecurePacketCpp::create(const std::string& machineCode,
+                             SecurePacketCpp& packet) {
+  packet = SecurePacketCpp();
+  if (!packet.machineCode.assign(machineCode)) {
+    return false;
+  }
   packet.timestamp = static_cast<int64_t>(std::time(nullptr));
-  packet.nonce = SecureTransportCpp::generateSalt(16);
+  packet.nonce.assign(SecureTransportCpp::generateSalt(16));
 
   // 生成签名
-  std::string combinedData =
-      machineCode + "|" + std::to_string(packet.timestamp) + "|" + packet.nonce;
-  packet.signature =
-      SecureTransportCpp::generateSignature(combinedData, packet.timestamp);
-
-  return packet;
+  unsigned char mac[SHA256_DIGEST_LENGTH];
+  if (SecureTransportCpp::computePacketMac(packet.machineCode.view(),
+                                           packet.timestamp,
+                                           packet.nonce.view(), mac)) {
+    bytesToHex(mac, SHA256_DIGEST_LENGTH, packet.signature.chars);
+    packet.signature.length = 2 * SHA256_DIGEST_LENGTH;
+    return true;
+  }
+  return false;
 }
 
 std::string SecurePacketCpp::toJson() const {
   std::map<std::string, std::string> data;
-  data["machine_code"] = machineCode;
+  data["machine_code"] = machineCode.str();
   data["timestamp"] = std::to_string(timestamp);
-  data["nonce"] = nonce;
-  data["signature"] = signature;
+  data["nonce"] = nonce.str();
+  data["signature"] = signature.str();
 
   return buildJson(data);
 }
 
-SecurePacketCpp SecurePacketCpp::fromJson(const std::string& jsonStr) {
-  SecurePacketCpp packet;
+bool SecurePacketCpp::fromJson(const std::string& jsonStr,
+                               SecurePacketCpp& packet) {
+  packet = SecurePacketCpp();
 
   std::map<std::string, std::string> data = parseJson(jsonStr);
 
-  packet.machineCode = data["machine_code"];
-  packet.timestamp = std::stoll(data["timestamp"]);
-  packet.nonce = data["nonce"];
-  packet.signature = data["signature"];
+  const std::string& timestamp = data["timestamp"];
+  auto parsed = std::from_chars(timestamp.data(),
+                                timestamp.data() + timestamp.size(),
+                                packet.timestamp);
+  if (parsed.ec != std::errc() ||
+      parsed.ptr != timestamp.data() + timestamp.size()) {
+    return false;
+  }
+
+  // 超出容量的字段不截断也不忽略：整个数据包视为无效
+  return packet.machineCode.assign(data["machine_code"]) &&
+         packet.nonce.assign(data["nonce"]) &&
+         packet.signature.assign(data["signature"]);
+}
 
-  return packet;
+std::string SecurePacketCpp::toBinary() const {
+  if (nonce.size() != 16) return "";
+
+  std::string binary(kBinarySize, '\0');
+  unsigned char* out = reinterpret_cast<unsigned char*>(&binary[0]);
+
+  if (!hexToBytes(machineCode.view(), out, 32)) return "";
+
+  uint64_t ts = static_cast<uint64_t>(timestamp);
+  for (int i = 0; i < 8; i++) {
+    out[32 + i] = static_cast<unsigned char>(ts >> (56 - 8 * i));
+  }
+
+  std::memcpy(out + 40, nonce.chars, 16);
+
+  if (!hexToBytes(signature.view(), out + 56, 32)) return "";
+
+  return binary;
+}
+
+bool SecurePacketCpp::fromBinary(const std::string& data,
+                                 SecurePacketCpp& packet) {
+  if (data.length() < kBinarySize) return false;
+
+  const unsigned char* in = reinterpret_cast<const unsigned char*>(data.data());
+
+  uint64_t ts = 0;
+  for (int i = 0; i < 8; i++) {
+    ts = (ts << 8) | in[32 + i];
+  }
+
+  bytesToHex(in, 32, packet.machineCode.chars);
+  packet.machineCode.length = 64;
+  packet.timestamp = static_cast<int64_t>(ts);
+  packet.nonce.assign(
+      std::string_view(reinterpret_cast<const char*>(in + 40), 16));
+  bytesToHex(in + 56, 32, packet.signature.chars);
+  packet.signature.length = 64;
+
+  return true;
+}
+
+// 比较数据包签名与期望 MAC（常量时间）
+static bool packetMacMatches(std::string_view machineCode, int64_t timestamp,
+                             std::string_view nonce,
+                             std::string_view signature) {
+  unsigned char expected[SHA256_DIGEST_LENGTH];
+  unsigned char actual[SHA256_DIGEST_LENGTH];
+  if (!hexToBytes(signature, actual, SHA256_DIGEST_LENGTH)) return false;
+  if (!SecureTransportCpp::computePacketMac(machineCode, timestamp, nonce,
+                                            expected)) {
+    return false;
+  }
+  return CRYPTO_memcmp(expected, actual, SHA256_DIGEST_LENGTH) == 0;
 }
 
 bool SecurePacketCpp::verify(int maxAgeSeconds) const {
@@ -424,8 +591,66 @@ bool SecurePacketCpp::verify(int maxAgeSeconds) const {
   }
 
   // 2. 验证签名
-  std::string combinedData =
-      machineCode + "|" + std::to_string(timestamp) + "|" + nonce;
-  return SecureTransportCpp::verifySignature(combinedData, timestamp,
-                                             signature);
+  return packetMacMatches(machineCode.view(), timestamp, nonce.view(),
+                          signature.view());
+}
+
+// ============================================================================
+// SecurePacketBatchCpp 实现
+// ============================================================================
+
+void SecurePacketBatchCpp::reserve(size_t count) {
+  m_machineCodes.reserve(count);
+  m_timestamps.reserve(count);
+  m_nonces.reserve(count);
+  m_signatures.reserve(count);
+}
+
+void SecurePacketBatchCpp::clear() {
+  m_machineCodes.clear();
+  m_timestamps.clear();
+  m_nonces.clear();
+  m_signatures.clear();
+}
+
+void SecurePacketBatchCpp::add(const SecurePacketCpp& packet) {
+  m_machineCodes.push_back(packet.machineCode);
+  m_timestamps.push_back(packet.timestamp);
+  m_nonces.push_back(packet.nonce);
+  m_signatures.push_back(packet.signature);
+}
+
+SecurePacketCpp SecurePacketBatchCpp::at(size_t index) const {
+  SecurePacketCpp packet;
+  packet.machineCode = m_machineCodes[index];
+  packet.timestamp = m_timestamps[index];
+  packet.nonce = m_nonces[index];
+  packet.signature = m_signatures[index];
+  return packet;
+}
+
+size_t SecurePacketBatchCpp::verifyAll(std::vector<uint8_t>& results,
+                                       int maxAgeSeconds) const {
+  const size_t count = m_timestamps.size();
+  results.assign(count, 0);
+
+  // 1. 顺序扫描时间戳列
+  int64_t oldest = static_cast<int64_t>(std::time(nullptr)) - maxAgeSeconds;
+  for (size_t i = 0; i < count; i++) {
+    results[i] = m_timestamps[i] >= oldest ? 1 : 0;
+  }
+
+  // 2. 仅对未过期的数据包验证签名
+  size_t validCount = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!results[i]) continue;
+
+    results[i] = packetMacMatches(m_machineCodes[i].view(), m_timestamps[i],
+                                  m_nonces[i].view(), m_signatures[i].view())
+                     ? 1
+                     : 0;
+    validCount += results[i];
+  }
+
+  return validCount;
 }
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <ctime>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 /// <summary>
@@ -36,6 +42,14 @@ class SecureTransportCpp {
   static bool verifySignature(const std::string& data, int64_t timestamp,
                               const std::string& signature);
 
+  /// <summary>
+  /// 计算数据包 MAC（原始 32 字节）
+  /// 等价于 generateSignature(machineCode|timestamp|nonce, timestamp)，
+  /// 但分段送入 HMAC 并复用线程内上下文，不分配内存
+  /// </summary>
+  static bool computePacketMac(std::string_view machineCode, int64_t timestamp,
+                               std::string_view nonce, unsigned char mac[32]);
+
   /// <summary>
   /// 加密机器码（返回 Base64 编码的 JSON）
   /// </summary>
@@ -77,21 +91,52 @@ class SecureTransportCpp {
 
  private:
   static std::string s_appSecret;
+  // 密钥变更计数，用于失效其他线程内的 HMAC 上下文
+  static std::atomic<unsigned> s_appSecretGeneration;
+};
+
+/// <summary>
+/// 定长容量的内联字符串（可平凡复制，不使用堆内存）
+/// 超出容量的赋值会失败并保持原值
+/// </summary>
+template <size_t N>
+struct FixedStringCpp {
+  static_assert(N <= 255, "length is stored in one byte");
+
+  char chars[N];
+  uint8_t length = 0;
+
+  bool assign(std::string_view value) {
+    if (value.length() > N) return false;
+    std::memcpy(chars, value.data(), value.length());
+    length = static_cast<uint8_t>(value.length());
+    return true;
+  }
+
+  std::string_view view() const { return std::string_view(chars, length); }
+  std::string str() const { return std::string(chars, length); }
+  size_t size() const { return length; }
+  bool empty() const { return length == 0; }
+
+  bool operator==(std::string_view other) const { return view() == other; }
+  bool operator!=(std::string_view other) const { return view() != other; }
 };
 
 /// <summary>
 /// 安全数据包（纯 C++ 实现）
+/// 字段均为内联定长数组，可平凡复制，跨线程拷贝/移动不涉及堆分配
 /// </summary>
 struct SecurePacketCpp {
-  std::string machineCode;
-  int64_t timestamp;
-  std::string nonce;
-  std::string signature;
+  FixedStringCpp<64> machineCode;  // 64 位十六进制机器码
+  int64_t timestamp = 0;
+  FixedStringCpp<16> nonce;        // 16 字符随机数
+  FixedStringCpp<64> signature;    // 64 位十六进制 HMAC-SHA256
 
   /// <summary>
   /// 创建安全数据包
   /// </summary>
-  static SecurePacketCpp create(const std::string& machineCode);
+  /// <returns>机器码超过 64 字符时返回 false（packet 不可发送）</returns>
+  static bool create(const std::string& machineCode, SecurePacketCpp& packet);
 
   /// <summary>
   /// 转换为 JSON 字符串
@@ -101,10 +146,70 @@ struct SecurePacketCpp {
   /// <summary>
   /// 从 JSON 解析
   /// </summary>
-  static SecurePacketCpp fromJson(const std::string& jsonStr);
+  /// <returns>时间戳无效或字段超出容量时返回 false</returns>
+  static bool fromJson(const std::string& jsonStr, SecurePacketCpp& packet);
+
+  /// <summary>
+  /// 二进制线格式（定长 88 字节，所有整数为大端序）
+  /// [0,32) 机器码原始字节 | [32,40) 时间戳 | [40,56) nonce | [56,88) MAC
+  /// </summary>
+  static constexpr size_t kBinarySize = 88;
+
+  /// <summary>
+  /// 二进制线格式对应的 Content-Type
+  /// </summary>
+  static const char* const kBinaryContentType;
+
+  /// <summary>
+  /// 转换为二进制线格式
+  /// 机器码/签名必须是 64 位小写十六进制、nonce 必须是 16 字符，否则返回空字符串
+  /// </summary>
+  std::string toBinary() const;
+
+  /// <summary>
+  /// 从二进制线格式解析（只读取前 kBinarySize 字节，失败返回 false）
+  /// </summary>
+  static bool fromBinary(const std::string& data, SecurePacketCpp& packet);
 
   /// <summary>
   /// 验证数据包
   /// </summary>
   bool verify(int maxAgeSeconds = 300) const;
 };
+
+static_assert(std::is_trivially_copyable<SecurePacketCpp>::value,
+              "SecurePacketCpp must stay trivially copyable");
+
+/// <summary>
+/// 批量数据包（结构数组布局）
+/// 各字段分别连续存放，批量验证时先顺序扫描时间戳，再只对未过期的包计算 MAC
+/// </summary>
+class SecurePacketBatchCpp {
+ public:
+  void reserve(size_t count);
+  void clear();
+  size_t size() const { return m_timestamps.size(); }
+
+  /// <summary>
+  /// 追加一个数据包
+  /// </summary>
+  void add(const SecurePacketCpp& packet);
+
+  /// <summary>
+  /// 取出第 index 个数据包
+  /// </summary>
+  SecurePacketCpp at(size_t index) const;
+
+  /// <summary>
+  /// 批量验证，results[i] 为 1 表示第 i 个包有效
+  /// </summary>
+  /// <returns>有效数据包数量</returns>
+  size_t verifyAll(std::vector<uint8_t>& results,
+                   int maxAgeSeconds = 300) const;
+
+ private:
+  std::vector<FixedStringCpp<64>> m_machineCodes;
+  std::vector<int64_t> m_timestamps;
+  std::vector<FixedStringCpp<16>> m_nonces;
+  std::vector<FixedStringCpp<64>> m_signatures;
+};
@@ -1,10 +1,14 @@
 // 纯 C++ 授权客户端使用示例
 // 展示如何在 Qt UI 项目中使用纯 C++ 的网络和加密功能
 
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include "http_client_cpp.h"
+#include "license_client_coro.h"
 #include "secure_transport_cpp.h"
 #include "win_product.h"
 
@@ -98,6 +102,10 @@ void example3_AsyncRequest() {
         if (response.success) {
           std::cout << "[异步回调] 请求成功!\n";
           std::cout << "状态码: " << response.statusCode << "\n";
+          // 响应头按名称查找（旧版本的 response.headers["Content-Type"]
+          // 成员已改为 header() 方法，全部响应头用 headers() 取得）
+          std::cout << "Content-Type: " << response.header("Content-Type")
+                    << "\n";
           std::cout << "响应体: " << response.body.substr(0, 100) << "...\n";
         } else {
           std::cout << "[异步回调] 请求失败: " << response.error << "\n";
@@ -110,6 +118,106 @@ void example3_AsyncRequest() {
   std::this_thread::sleep_for(std::chrono::seconds(3));
 }
 
+// ============================================================================
+// 示例 5: 多线程共享一个客户端（连接与句柄在线程间复用）
+// 请求发往本机的授权服务替身（server/native 的 license_standin，
+// 默认监听 127.0.0.1:18080），不对公共服务造成压力。
+// 并发正确性由 server/native 的 license_stress_tsan（ctest）覆盖
+// ============================================================================
+
+void example5_SharedClient() {
+  std::cout << "\n=== 多线程共享客户端示例 ===\n\n";
+
+  // 配置在构建时确定，之后各线程只发送请求
+  HttpClientCpp::Options options;
+  options.timeoutMs = 5000;
+  options.connectTimeoutMs = 2000;
+  options.headers["User-Agent"] = "LicenseClientCpp/1.0";
+  HttpClientCpp httpClient(options);
+
+  const int kThreads = 8;
+  const int kRequestsPerThread = 20;
+  std::atomic<int> succeeded{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&httpClient, &succeeded, t]() {
+      for (int i = 0; i < kRequestsPerThread; i++) {
+        // 请求头只作用于本次请求，不修改客户端
+        HttpClientCpp::Request request;
+        request.method = "GET";
+        request.url = "http://127.0.0.1:18080/api/health";
+        request.headers["X-Example-Thread"] = std::to_string(t);
+
+        if (httpClient.send(request).success) {
+          succeeded++;
+        }
+      }
+    });
+  }
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  std::cout << "成功: " << succeeded.load() << " / "
+            << kThreads * kRequestsPerThread << "\n";
+}
+
+#ifdef LICENSE_CLIENT_HAS_COROUTINES
+// ============================================================================
+// 示例 6: C++20 协程（以 C++20 编译时可用）
+// ============================================================================
+
+// 最简单的即发即弃协程类型
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+DetachedTask verifyWithCoroutine(LicenseClientCoro<>& coro,
+                                 std::string machineCode,
+                                 std::string licenseKey,
+                                 std::stop_token stopToken,
+                                 std::promise<void>& finished) {
+  LicenseAwaitOptions options;
+  options.stopToken = stopToken;
+  options.deadline = std::chrono::milliseconds(3000);
+
+  // 等待期间不占用线程；完成后在事件循环线程继续执行
+  auto response =
+      co_await coro.verifyLicenseAsync(machineCode, licenseKey, options);
+
+  if (response.valid) {
+    std::cout << "[协程] 授权有效，过期时间: " << response.expiresAt << "\n";
+  } else {
+    std::cout << "[协程] 验证失败: " << response.message << "\n";
+  }
+  finished.set_value();
+}
+
+void example6_Coroutine() {
+  std::cout << "\n=== 协程示例 ===\n\n";
+
+  LicenseClientCpp client("https://yourserver.com/api");
+  client.setAppSecret("YOUR_STRONG_SECRET_2026");
+  LicenseClientCoro<> coro(client);
+
+  std::stop_source stopSource;  // stopSource.request_stop() 可随时取消
+  std::promise<void> finished;
+  verifyWithCoroutine(coro, GenerateMachineCode(), "YOUR_LICENSE_KEY",
+                      stopSource.get_token(), finished);
+
+  std::cout << "主线程继续执行...\n";
+  finished.get_future().wait();
+}
+#endif
+
 // ============================================================================
 // 示例 4: 集成到 Qt 项目（仅使用 Qt UI）
 // ============================================================================
@@ -262,6 +370,10 @@ int main(int argc, char* argv[]) {
   std::cout << "1. 基础使用（请求授权）\n";
   std::cout << "2. 验证授权\n";
   std::cout << "3. 异步请求\n";
+  std::cout << "5. 多线程共享客户端\n";
+#ifdef LICENSE_CLIENT_HAS_COROUTINES
+  std::cout << "6. C++20 协程\n";
+#endif
 #ifdef QT_VERSION
   std::cout << "4. Qt UI 集成\n";
 #endif
@@ -280,6 +392,14 @@ int main(int argc, char* argv[]) {
     case 3:
       example3_AsyncRequest();
       break;
+    case 5:
+      example5_SharedClient();
+      break;
+#ifdef LICENSE_CLIENT_HAS_COROUTINES
+    case 6:
+      example6_Coroutine();
+      break;
+#endif
 #ifdef QT_VERSION
     case 4:
       return example4_QtIntegration(argc, argv);
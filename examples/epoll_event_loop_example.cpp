@@ -0,0 +1,204 @@
+// 外部 epoll 事件循环接入示例（Linux）
+// 由使用方的单线程 epoll 循环驱动 HttpClientCpp / LicenseClientCpp，不创建额外线程
+//
+// 用法: epoll_event_loop_example [服务器地址] [请求数]
+//   默认 http://127.0.0.1:5000/api，对 /health 并发发送请求后再验证一次授权
+//   （先启动 server/secure_license_server.py）
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include "http_client_cpp.h"
+
+// ============================================================================
+// 最小 epoll 事件循环
+// ============================================================================
+
+class EpollLoop {
+ public:
+  EpollLoop()
+      : m_epoll(epoll_create1(EPOLL_CLOEXEC)),
+        m_wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = m_wakeFd;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &event);
+  }
+
+  ~EpollLoop() {
+    close(m_wakeFd);
+    close(m_epoll);
+  }
+
+  /// <summary>
+  /// 让客户端的异步请求由本循环驱动（需在首个异步请求之前调用）
+  /// </summary>
+  bool attach(HttpClientCpp& client) {
+    m_client = &client;
+    return client.setEventLoopCallbacks(
+        [this](int fd, bool readable, bool writable) {
+          watch(fd, readable, writable);
+        },
+        [this](long /*timeoutMs*/) {
+          // 定时器变化可能来自其他线程：唤醒 epoll_wait，重新读取时限
+          uint64_t one = 1;
+          ssize_t written = write(m_wakeFd, &one, sizeof(one));
+          (void)written;
+        });
+  }
+
+  /// <summary>
+  /// 运行循环直到 done() 返回 true
+  /// </summary>
+  void runUntil(const std::function<bool()>& done) {
+    const int kMaxEvents = 64;
+    epoll_event events[kMaxEvents];
+
+    while (!done()) {
+      int timeout = static_cast<int>(m_client->eventLoopTimeoutMs());
+      int count = epoll_wait(m_epoll, events, kMaxEvents, timeout);
+      if (count < 0 && errno != EINTR) {
+        std::cerr << "epoll_wait 失败: " << errno << "\n";
+        return;
+      }
+
+      for (int i = 0; i < count; i++) {
+        int fd = events[i].data.fd;
+        if (fd == m_wakeFd) {
+          uint64_t value = 0;
+          ssize_t drained = read(m_wakeFd, &value, sizeof(value));
+          (void)drained;
+          continue;
+        }
+
+        // 出错或挂断时按可读处理，由 libcurl 读取错误
+        if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+          m_client->onReadable(fd);
+        }
+        if (events[i].events & EPOLLOUT) {
+          m_client->onWritable(fd);
+        }
+      }
+
+      if (m_client->eventLoopTimeoutMs() == 0) {
+        m_client->onTimeout();
+      }
+    }
+  }
+
+ private:
+  void watch(int fd, bool readable, bool writable) {
+    if (!readable && !writable) {
+      // 套接字可能已被关闭，忽略错误
+      epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+      return;
+    }
+
+    epoll_event event{};
+    event.events = (readable ? EPOLLIN : 0u) | (writable ? EPOLLOUT : 0u);
+    event.data.fd = fd;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &event) != 0 && errno == ENOENT) {
+      epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event);
+    }
+  }
+
+  int m_epoll;
+  int m_wakeFd;
+  HttpClientCpp* m_client = nullptr;
+};
+
+// ============================================================================
+// 示例 1: 单线程并发发送 HTTP 请求
+// ============================================================================
+
+static void runHealthChecks(const std::string& serverUrl, int requests) {
+  std::cout << "=== 并发请求 " << serverUrl << "/health x " << requests
+            << " ===\n";
+
+  // 事件循环须比客户端活得更久：客户端析构时仍会通知它移除套接字
+  EpollLoop loop;
+
+  HttpClientCpp::Options options;
+  options.timeoutMs = 5000;
+  options.connectTimeoutMs = 2000;
+  HttpClientCpp client(options);
+
+  if (!loop.attach(client)) {
+    std::cerr << "[错误] 客户端已在使用内置事件循环\n";
+    return;
+  }
+
+  // 回调都在本线程（事件循环）执行，计数无需同步
+  int completed = 0;
+  int succeeded = 0;
+  std::string firstError;
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < requests; i++) {
+    client.getAsync(serverUrl + "/health",
+                    [&](const HttpClientCpp::Response& response) {
+                      completed++;
+                      if (response.success && response.statusCode == 200) {
+                        succeeded++;
+                      } else if (firstError.empty()) {
+                        firstError = response.error.empty()
+                                         ? std::to_string(response.statusCode)
+                                         : response.error;
+                      }
+                    });
+  }
+
+  loop.runUntil([&completed, requests]() { return completed == requests; });
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << "成功: " << succeeded << " / " << requests << "，耗时 "
+            << elapsed.count() << " ms\n";
+  if (!firstError.empty()) {
+    std::cout << "首个错误: " << firstError << "\n";
+  }
+  std::cout << "\n";
+}
+
+// ============================================================================
+// 示例 2: 授权客户端运行在同一事件循环中
+// ============================================================================
+
+static void runLicenseVerify(const std::string& serverUrl) {
+  std::cout << "=== 在事件循环中验证授权 ===\n";
+
+  EpollLoop loop;
+
+  LicenseClientCpp client(serverUrl);
+  client.setAppSecret("YOUR_STRONG_SECRET_2026");
+  loop.attach(*client.httpClient());
+
+  bool done = false;
+  client.startVerifyLicense(
+      "0123456789ABCDEF0123456789ABCDEF", "DEMO-LICENSE-KEY",
+      [&done](const LicenseClientCpp::VerifyResponse& response) {
+        std::cout << (response.valid ? "[有效] " : "[无效] ") << response.message
+                  << "\n";
+        done = true;
+      });
+
+  loop.runUntil([&done]() { return done; });
+}
+
+int main(int argc, char* argv[]) {
+  std::string serverUrl = argc > 1 ? argv[1] : "http://127.0.0.1:5000/api";
+  int requests = argc > 2 ? std::atoi(argv[2]) : 100;
+
+  runHealthChecks(serverUrl, requests);
+  runLicenseVerify(serverUrl);
+  return 0;
+}
@@ -6,6 +6,14 @@
 
 #include "../computer_id/win_product.h"
 
+// 离线宽限缓存：服务器不可用时，最近一次成功验证在该时长内继续有效
+static const char kOfflineGraceFile[] = "license_grace.dat";
+static const long kOfflineGraceSeconds = 3 * 24 * 3600;
+
+// 验证结果缓存：有效期内的重复验证不访问网络，临近到期时后台刷新
+static const char kVerifyCacheFile[] = "license_cache.dat";
+static const long kVerifyCacheTtlSeconds = 3600;
+
 LicenseBackend::LicenseBackend() : m_client(nullptr), m_serverUrl("") {}
 
 LicenseBackend::~LicenseBackend() {
@@ -15,16 +23,44 @@ LicenseBackend::~LicenseBackend() {
   }
 }
 
+void LicenseBackend::setDataDirectory(const std::string& directory) {
+  m_dataDirectory = directory;
+}
+
+std::string LicenseBackend::dataFilePath(const char* fileName) const {
+  if (m_dataDirectory.empty()) {
+    return fileName;
+  }
+  char last = m_dataDirectory.back();
+  if (last == '/' || last == '\\') {
+    return m_dataDirectory + fileName;
+  }
+  return m_dataDirectory + "/" + fileName;
+}
+
 void LicenseBackend::setServerUrl(const std::string& url) {
+  // 地址未变化时保留现有客户端（连接与缓存保持温热）
+  if (m_client && url == m_serverUrl) {
+    return;
+  }
+
   m_serverUrl = url;
 
-  // 重新创建客户端
+  // 重新创建客户端（DNS、TLS 会话与连接由进程级共享缓存保留）
   if (m_client) {
     delete m_client;
+    m_client = nullptr;
   }
 
   if (!url.empty()) {
     m_client = new LicenseClientCpp(url);
+    m_client->setOfflineGrace(dataFilePath(kOfflineGraceFile),
+                              kOfflineGraceSeconds);
+
+    LicenseClientCpp::VerifyCacheOptions cacheOptions;
+    cacheOptions.ttlSeconds = kVerifyCacheTtlSeconds;
+    cacheOptions.filePath = dataFilePath(kVerifyCacheFile);
+    m_client->setVerifyCache(cacheOptions);
   }
 }
 
@@ -34,6 +70,12 @@ void LicenseBackend::setAppSecret(const std::string& secret) {
   }
 }
 
+void LicenseBackend::prewarm() {
+  if (m_client) {
+    m_client->prewarm();
+  }
+}
+
 std::string LicenseBackend::getMachineCode() {
   try {
     return GenerateMachineCode();
@@ -13,6 +13,12 @@ class LicenseBackend {
   LicenseBackend();
   ~LicenseBackend();
 
+  /// <summary>
+  /// 设置离线宽限缓存与验证缓存文件所在的目录（需在 setServerUrl 之前调用）
+  /// 应为每个用户独立的应用数据目录，为空时使用当前工作目录
+  /// </summary>
+  void setDataDirectory(const std::string& directory);
+
   /// <summary>
   /// 设置服务器地址
   /// </summary>
@@ -23,6 +29,11 @@ class LicenseBackend {
   /// </summary>
   void setAppSecret(const std::string& secret);
 
+  /// <summary>
+  /// 在后台预热到服务器的连接（见 LicenseClientCpp::prewarm），立即返回
+  /// </summary>
+  void prewarm();
+
   /// <summary>
   /// 获取机器码（使用纯 C++ 实现）
   /// </summary>
@@ -65,4 +76,8 @@ class LicenseBackend {
  private:
   LicenseClientCpp* m_client;
   std::string m_serverUrl;
+  std::string m_dataDirectory;
+
+  // 数据目录下的文件路径
+  std::string dataFilePath(const char* fileName) const;
 };
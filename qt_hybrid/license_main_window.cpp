@@ -3,23 +3,48 @@
 #include <QApplication>
 #include <QClipboard>
 #include <QDateTime>
+#include <QDir>
 #include <QMessageBox>
+#include <QPointer>
+#include <QStandardPaths>
 #include <QStyle>
 #include <QThread>
 
 #include "license_backend.h"
 
-LicenseMainWindow::LicenseMainWindow(QWidget* parent) : QMainWindow(parent) {
+// 服务器地址与应用密钥（修改为实际配置）
+static const char kServerUrl[] = "https://yourserver.com/api";
+static const char kAppSecret[] = "YOUR_STRONG_SECRET_2026";
+
+LicenseMainWindow::LicenseMainWindow(QWidget* parent)
+    : QMainWindow(parent), m_backend(std::make_shared<LicenseBackend>()) {
   initUI();
 
+  // 缓存文件放在每个用户的应用数据目录，而不是（可能不可写的）工作目录
+  QString dataDirectory =
+      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+  if (!dataDirectory.isEmpty() && QDir().mkpath(dataDirectory)) {
+    m_backend->setDataDirectory(QDir::toNativeSeparators(dataDirectory)
+                                    .toLocal8Bit()
+                                    .toStdString());
+  }
+
+  // 地址一确定就在后台建立连接（DNS、TCP、TLS），与界面初始化和
+  // 机器码生成并行，首次验证时连接已就绪
+  m_backend->setServerUrl(kServerUrl);
+  m_backend->setAppSecret(kAppSecret);
+  m_backend->prewarm();
+
   // 启动时自动获取机器码
   QTimer::singleShot(100, this, &LicenseMainWindow::onGetMachineCode);
 
-  // 自动检查现有授权
-  QTimer::singleShot(500, this, &LicenseMainWindow::onVerifyLicense);
+  // 自动检查现有授权（事件循环启动、窗口显示后立即开始）
+  QTimer::singleShot(0, this, &LicenseMainWindow::onVerifyLicense);
 }
 
-LicenseMainWindow::~LicenseMainWindow() {}
+LicenseMainWindow::~LicenseMainWindow() {
+  // 不等待工作线程：它们各自持有后端，结果回到主线程时窗口已关闭则丢弃
+}
 
 void LicenseMainWindow::initUI() {
   setWindowTitle("软件授权系统 - Qt UI + 纯C++后端");
@@ -171,6 +196,8 @@ void LicenseMainWindow::createLogGroup() {
 
 // ============================================================================
 // 事件处理（在新线程中调用纯C++后端）
+// 工作线程只使用捕获的后端共享指针与参数副本，不访问窗口成员；
+// 界面更新投递到主线程（以 qApp 为上下文），执行时窗口已关闭则丢弃
 // ============================================================================
 
 void LicenseMainWindow::onGetMachineCode() {
@@ -179,14 +206,16 @@ void LicenseMainWindow::onGetMachineCode() {
   m_progressBar->setVisible(true);
 
   // 在新线程中执行（不阻塞UI）
-  QThread* thread = QThread::create([this]() {
-    LicenseBackend backend;
-    std::string machineCode = backend.getMachineCode();
+  std::shared_ptr<LicenseBackend> backend = m_backend;
+  QPointer<LicenseMainWindow> self(this);
+  QThread* thread = QThread::create([this, self, backend]() {
+    std::string machineCode = backend->getMachineCode();
 
     // 回到主线程更新UI
     QMetaObject::invokeMethod(
-        this,
-        [this, machineCode]() {
+        qApp,
+        [this, self, machineCode]() {
+          if (!self) return;
           m_currentMachineCode = QString::fromStdString(machineCode);
           m_machineCodeEdit->setText(m_currentMachineCode);
           m_copyMachineCodeBtn->setEnabled(true);
@@ -201,6 +230,7 @@ void LicenseMainWindow::onGetMachineCode() {
         Qt::QueuedConnection);
   });
 
+  connect(thread, &QThread::finished, thread, &QObject::deleteLater);
   thread->start();
 }
 
@@ -216,17 +246,17 @@ void LicenseMainWindow::onRequestLicense() {
   setButtonsEnabled(false);
   m_progressBar->setVisible(true);
 
-  QThread* thread = QThread::create([this, userInfo]() {
-    LicenseBackend backend;
-    backend.setServerUrl("https://yourserver.com/api");  // 修改为实际服务器地址
-    backend.setAppSecret("YOUR_STRONG_SECRET_2026");
-
-    auto result = backend.requestLicense(m_currentMachineCode.toStdString(),
-                                         userInfo.toStdString());
+  std::shared_ptr<LicenseBackend> backend = m_backend;
+  QPointer<LicenseMainWindow> self(this);
+  std::string machineCode = m_currentMachineCode.toStdString();
+  QThread* thread = QThread::create([this, self, backend, machineCode,
+                                     userInfo]() {
+    auto result = backend->requestLicense(machineCode, userInfo.toStdString());
 
     QMetaObject::invokeMethod(
-        this,
-        [this, result]() {
+        qApp,
+        [this, self, result]() {
+          if (!self) return;
           m_progressBar->setVisible(false);
           setButtonsEnabled(true);
 
@@ -259,6 +289,7 @@ void LicenseMainWindow::onRequestLicense() {
         Qt::QueuedConnection);
   });
 
+  connect(thread, &QThread::finished, thread, &QObject::deleteLater);
   thread->start();
 }
 
@@ -267,21 +298,20 @@ void LicenseMainWindow::onVerifyLicense() {
   setButtonsEnabled(false);
   m_progressBar->setVisible(true);
 
-  QThread* thread = QThread::create([this]() {
-    LicenseBackend backend;
-    backend.setServerUrl("https://yourserver.com/api");
-    backend.setAppSecret("YOUR_STRONG_SECRET_2026");
-
+  std::shared_ptr<LicenseBackend> backend = m_backend;
+  QPointer<LicenseMainWindow> self(this);
+  QThread* thread = QThread::create([this, self, backend]() {
     // 获取机器码
-    std::string machineCode = backend.getMachineCode();
+    std::string machineCode = backend->getMachineCode();
 
     // 从本地加载许可证
     std::string licenseKey = LicenseBackend::loadLicenseFromFile();
 
     if (licenseKey.empty()) {
       QMetaObject::invokeMethod(
-          this,
-          [this]() {
+          qApp,
+          [this, self]() {
+            if (!self) return;
             m_progressBar->setVisible(false);
             setButtonsEnabled(true);
             updateStatus("✗ 未授权", false);
@@ -292,18 +322,20 @@ void LicenseMainWindow::onVerifyLicense() {
     }
 
     // 验证授权
-    auto result = backend.verifyLicense(machineCode, licenseKey);
+    auto result = backend->verifyLicense(machineCode, licenseKey);
 
     QMetaObject::invokeMethod(
-        this,
-        [this, result, licenseKey]() {
+        qApp,
+        [this, self, result, licenseKey]() {
+          if (!self) return;
           m_progressBar->setVisible(false);
           setButtonsEnabled(true);
 
           if (result.valid) {
             updateStatus("✓ 已授权", true);
             m_licenseKeyEdit->setText(QString::fromStdString(licenseKey));
-            appendLog("授权验证成功");
+            appendLog(result.offline ? "授权验证成功（服务器不可用，离线宽限模式）"
+                                     : "授权验证成功");
             appendLog("过期时间: " + QString::fromStdString(result.expiresAt));
           } else {
             updateStatus("✗ 授权失败", false);
@@ -319,6 +351,7 @@ void LicenseMainWindow::onVerifyLicense() {
         Qt::QueuedConnection);
   });
 
+  connect(thread, &QThread::finished, thread, &QObject::deleteLater);
   thread->start();
 }
 
@@ -332,16 +365,16 @@ void LicenseMainWindow::onCheckLicenseInfo() {
   setButtonsEnabled(false);
   m_progressBar->setVisible(true);
 
-  QThread* thread = QThread::create([this]() {
-    LicenseBackend backend;
-    backend.setServerUrl("https://yourserver.com/api");
-    backend.setAppSecret("YOUR_STRONG_SECRET_2026");
-
-    auto result = backend.getLicenseInfo(m_currentMachineCode.toStdString());
+  std::shared_ptr<LicenseBackend> backend = m_backend;
+  QPointer<LicenseMainWindow> self(this);
+  std::string machineCode = m_currentMachineCode.toStdString();
+  QThread* thread = QThread::create([this, self, backend, machineCode]() {
+    auto result = backend->getLicenseInfo(machineCode);
 
     QMetaObject::invokeMethod(
-        this,
-        [this, result]() {
+        qApp,
+        [this, self, result]() {
+          if (!self) return;
           m_progressBar->setVisible(false);
           setButtonsEnabled(true);
 
@@ -370,6 +403,7 @@ void LicenseMainWindow::onCheckLicenseInfo() {
         Qt::QueuedConnection);
   });
 
+  connect(thread, &QThread::finished, thread, &QObject::deleteLater);
   thread->start();
 }
 
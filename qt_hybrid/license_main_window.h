@@ -12,6 +12,10 @@
 #include <QTimer>
 #include <QVBoxLayout>
 
+#include <memory>
+
+class LicenseBackend;
+
 /// <summary>
 /// Qt UI 主窗口
 /// 只负责界面显示，业务逻辑使用纯 C++ 实现
@@ -63,6 +67,11 @@ class LicenseMainWindow : public QMainWindow {
   QTextEdit* m_logEdit;
   QProgressBar* m_progressBar;
 
+  // 业务后端（窗口存续期间保持，各工作线程共用，连接与缓存保持温热）
+  // 每个工作线程持有一份共享指针：窗口先于工作线程关闭时后端仍然有效，
+  // 由最后一个结束的线程释放
+  std::shared_ptr<LicenseBackend> m_backend;
+
   // 数据
   QString m_currentMachineCode;
   QString m_currentLicenseKey;
@@ -11,14 +11,17 @@ SOURCES += \
     license_backend.cpp \
     ../computer_id/win_product.cpp \
     ../computer_id/secure_transport_cpp.cpp \
-    ../computer_id/http_client_cpp.cpp
+    ../computer_id/http_client_cpp.cpp \
+    ../computer_id/curl_multi_engine.cpp
 
 HEADERS += \
     license_main_window.h \
     license_backend.h \
     ../computer_id/win_product.h \
     ../computer_id/secure_transport_cpp.h \
-    ../computer_id/http_client_cpp.h
+    ../computer_id/http_client_cpp.h \
+    ../computer_id/license_client_coro.h \
+    ../computer_id/curl_multi_engine.h
 
 # OpenSSL 配置（通过 vcpkg 安装）
 # 假设使用 x64-windows 架构
@@ -36,6 +39,17 @@ LIBS += -lssl -lcrypto
 # libcurl 库
 LIBS += -lcurl
 
+# zlib 库（请求体 gzip 压缩，可选：未安装时 http_client_cpp 不压缩请求体）
+# vcpkg 的发布版为 lib/zlib.lib，调试版为 debug/lib/zlibd.lib
+exists($$VCPKG_ROOT/installed/x64-windows/include/zlib.h) {
+    DEFINES += HTTP_CLIENT_HAS_ZLIB=1
+    CONFIG(debug, debug|release) {
+        LIBS += -L$$VCPKG_ROOT/installed/x64-windows/debug/lib -lzlibd
+    } else {
+        LIBS += -lzlib
+    }
+}
+
 # Windows 系统库
 LIBS += -lws2_32 -lcrypt32 -lwbemuuid -lole32 -loleaut32 -ladvapi32
 
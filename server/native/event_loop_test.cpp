@@ -0,0 +1,209 @@
+// 外部事件循环接入测试（Linux）
+// 在进程内启动回环替身服务器，由本线程的 epoll 循环驱动 HttpClientCpp 与
+// LicenseClientCpp；并检查已在使用内置事件循环的客户端拒绝接入时配置不变
+//
+// 用法: license_event_loop_test（失败时以非零状态退出）
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <string>
+
+#include "http_client_cpp.h"
+#include "license_standin.h"
+#include "secure_transport_cpp.h"
+#include "standin_listener.h"
+
+static int g_failures = 0;
+
+static void check(bool condition, const std::string& message) {
+  if (!condition) {
+    g_failures++;
+    std::cerr << "[FAIL] " << message << std::endl;
+  }
+}
+
+// 最小 epoll 事件循环（与 examples/epoll_event_loop_example.cpp 相同的接法）
+class EpollLoop {
+ public:
+  EpollLoop()
+      : m_epoll(epoll_create1(EPOLL_CLOEXEC)),
+        m_wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = m_wakeFd;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &event);
+  }
+
+  ~EpollLoop() {
+    close(m_wakeFd);
+    close(m_epoll);
+  }
+
+  bool attach(HttpClientCpp& client) {
+    m_client = &client;
+    return client.setEventLoopCallbacks(
+        [this](int fd, bool readable, bool writable) {
+          watch(fd, readable, writable);
+        },
+        [this](long) {
+          uint64_t one = 1;
+          ssize_t written = write(m_wakeFd, &one, sizeof(one));
+          (void)written;
+        });
+  }
+
+  // 运行循环直到 done() 返回 true；超过 timeoutMs 返回 false
+  bool runUntil(const std::function<bool()>& done, long timeoutMs) {
+    const int kMaxEvents = 64;
+    epoll_event events[kMaxEvents];
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(timeoutMs);
+
+    while (!done()) {
+      if (std::chrono::steady_clock::now() > deadline) return false;
+      long timeout = m_client->eventLoopTimeoutMs();
+      if (timeout < 0 || timeout > 100) timeout = 100;
+      int count = epoll_wait(m_epoll, events, kMaxEvents,
+                             static_cast<int>(timeout));
+      if (count < 0 && errno != EINTR) return false;
+
+      for (int i = 0; i < count; i++) {
+        int fd = events[i].data.fd;
+        if (fd == m_wakeFd) {
+          uint64_t value = 0;
+          ssize_t drained = read(m_wakeFd, &value, sizeof(value));
+          (void)drained;
+          continue;
+        }
+        if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+          m_client->onReadable(fd);
+        }
+        if (events[i].events & EPOLLOUT) {
+          m_client->onWritable(fd);
+        }
+      }
+
+      if (m_client->eventLoopTimeoutMs() == 0) {
+        m_client->onTimeout();
+      }
+    }
+    return true;
+  }
+
+ private:
+  void watch(int fd, bool readable, bool writable) {
+    if (!readable && !writable) {
+      epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+      return;
+    }
+    epoll_event event{};
+    event.events = (readable ? EPOLLIN : 0u) | (writable ? EPOLLOUT : 0u);
+    event.data.fd = fd;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &event) != 0 && errno == ENOENT) {
+      epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event);
+    }
+  }
+
+  int m_epoll;
+  int m_wakeFd;
+  HttpClientCpp* m_client = nullptr;
+};
+
+// 已在使用内置事件循环：拒绝接入，配置不变，同步与异步请求照常工作
+static void testRejectedAfterInternalLoop(const std::string& baseUrl) {
+  HttpClientCpp client;
+  check(client.get(baseUrl + "/health").success, "首个同步请求失败");
+
+  std::promise<bool> finished;
+  client.getAsync(baseUrl + "/health",
+                  [&finished](const HttpClientCpp::Response& response) {
+                    finished.set_value(response.success);
+                  });
+  check(finished.get_future().get(), "内置事件循环的异步请求失败");
+
+  EpollLoop loop;
+  check(!loop.attach(client), "内置事件循环运行时仍接受了外部回调");
+  check(!client.options().engine.externalLoop,
+        "拒绝接入后配置仍被标记为外部事件循环");
+  check(client.get(baseUrl + "/health").success, "拒绝接入后同步请求失败");
+}
+
+// 外部事件循环驱动并发请求与非阻塞验证，回调都在本线程执行
+static void testExternalLoop(const std::string& baseUrl,
+                             const LicenseStandIn& standIn) {
+  EpollLoop loop;
+  HttpClientCpp client;
+  check(loop.attach(client), "外部事件循环接入失败");
+  check(client.options().engine.externalLoop, "接入后配置未标记外部事件循环");
+
+  const int kRequests = 50;
+  int completed = 0;
+  int succeeded = 0;
+  for (int i = 0; i < kRequests; i++) {
+    client.getAsync(baseUrl + "/health",
+                    [&](const HttpClientCpp::Response& response) {
+                      completed++;
+                      if (response.success && response.statusCode == 200) {
+                        succeeded++;
+                      }
+                    });
+  }
+  check(loop.runUntil([&]() { return completed == kRequests; }, 10000),
+        "外部事件循环未在时限内完成请求");
+  check(succeeded == kRequests, "外部事件循环请求成功 " +
+                                    std::to_string(succeeded) + " / " +
+                                    std::to_string(kRequests));
+
+  // 同步请求在调用线程直接执行，不等待事件循环
+  check(client.get(baseUrl + "/health").success,
+        "外部事件循环模式下同步请求失败");
+
+  EpollLoop licenseLoop;
+  LicenseClientCpp license(baseUrl);
+  check(licenseLoop.attach(*license.httpClient()), "授权客户端接入失败");
+
+  std::string machineCode = SecureTransportCpp::sha256("event-loop-test");
+  bool done = false;
+  bool valid = false;
+  license.startVerifyLicense(
+      machineCode, standIn.licenseKeyFor(machineCode),
+      [&](const LicenseClientCpp::VerifyResponse& response) {
+        valid = response.valid;
+        done = true;
+      });
+  check(licenseLoop.runUntil([&done]() { return done; }, 10000),
+        "非阻塞验证未在时限内完成");
+  check(valid, "非阻塞验证失败");
+}
+
+int main() {
+  signal(SIGPIPE, SIG_IGN);
+  SecureTransportCpp::setAppSecret("DEFAULT_APP_SECRET_2026_CHANGE_THIS");
+  LicenseStandIn standIn;
+  StandInListener listener(standIn);
+  std::string error;
+  if (!listener.listen(0, error)) {
+    std::cerr << "监听失败: " << error << "\n";
+    return 1;
+  }
+  listener.start();
+  std::string baseUrl =
+      "http://127.0.0.1:" + std::to_string(listener.port()) + "/api";
+
+  testRejectedAfterInternalLoop(baseUrl);
+  testExternalLoop(baseUrl, standIn);
+
+  listener.stop();
+  std::cout << "外部事件循环测试 " << (g_failures == 0 ? "通过" : "失败")
+            << "，失败 " << g_failures << std::endl;
+  return g_failures == 0 ? 0 : 1;
+}
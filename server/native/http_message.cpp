@@ -0,0 +1,221 @@
+#include "http_message.h"
+
+#include <cctype>
+#include <cstdlib>
+
+// 由构建系统在找到并链接 zlib 时定义（只检测头文件可能链接失败）
+#ifdef HTTP_MESSAGE_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+static const char* statusText(int statusCode) {
+  switch (statusCode) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 409: return "Conflict";
+    case 413: return "Payload Too Large";
+    case 415: return "Unsupported Media Type";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "Unknown";
+  }
+}
+
+static bool equalsIgnoreCase(const std::string& a, const char* b) {
+  size_t i = 0;
+  for (; i < a.size() && b[i] != '\0'; i++) {
+    if (std::tolower(static_cast<unsigned char>(a[i])) !=
+        std::tolower(static_cast<unsigned char>(b[i]))) {
+      return false;
+    }
+  }
+  return i == a.size() && b[i] == '\0';
+}
+
+HttpParseStatus parseHttpRequest(const std::string& buffer,
+                                 HttpClientCpp::Request& request,
+                                 size_t& consumed, bool& keepAlive) {
+  size_t headEnd = buffer.find("\r\n\r\n");
+  if (headEnd == std::string::npos) {
+    return buffer.size() > kHttpMaxHeaderBytes ? HttpInvalid : HttpIncomplete;
+  }
+  if (headEnd > kHttpMaxHeaderBytes) {
+    return HttpInvalid;
+  }
+
+  // 请求行: METHOD SP target SP HTTP/x.y
+  size_t lineEnd = buffer.find("\r\n");
+  size_t methodEnd = buffer.find(' ');
+  size_t targetEnd =
+      methodEnd < lineEnd ? buffer.find(' ', methodEnd + 1) : std::string::npos;
+  if (methodEnd == 0 || targetEnd == std::string::npos || targetEnd > lineEnd) {
+    return HttpInvalid;
+  }
+
+  request.method = buffer.substr(0, methodEnd);
+  request.url = buffer.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+  request.headers.clear();
+  request.body.clear();
+  keepAlive = buffer.compare(targetEnd + 1, lineEnd - targetEnd - 1,
+                             "HTTP/1.0") != 0;
+
+  size_t contentLength = 0;
+  size_t pos = lineEnd + 2;
+  while (pos < headEnd) {
+    size_t end = buffer.find("\r\n", pos);
+    size_t colon = buffer.find(':', pos);
+    if (colon == std::string::npos || colon > end) {
+      return HttpInvalid;
+    }
+
+    std::string name = buffer.substr(pos, colon - pos);
+    size_t valueStart = buffer.find_first_not_of(" \t", colon + 1);
+    size_t valueEnd = buffer.find_last_not_of(" \t", end - 1);
+    std::string value;
+    if (valueStart < end && valueEnd >= valueStart) {
+      value = buffer.substr(valueStart, valueEnd - valueStart + 1);
+    }
+
+    if (equalsIgnoreCase(name, "Content-Length")) {
+      char* parsedEnd = nullptr;
+      unsigned long long length = std::strtoull(value.c_str(), &parsedEnd, 10);
+      if (value.empty() || *parsedEnd != '\0' || length > kHttpMaxBodyBytes) {
+        return HttpInvalid;
+      }
+      contentLength = static_cast<size_t>(length);
+    } else if (equalsIgnoreCase(name, "Connection")) {
+      if (equalsIgnoreCase(value, "close")) keepAlive = false;
+      if (equalsIgnoreCase(value, "keep-alive")) keepAlive = true;
+    } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+      return HttpInvalid;  // 不支持分块请求体
+    }
+
+    request.headers[name] = value;
+    pos = end + 2;
+  }
+
+  size_t bodyStart = headEnd + 4;
+  if (buffer.size() - bodyStart < contentLength) {
+    return HttpIncomplete;
+  }
+
+  request.body = buffer.substr(bodyStart, contentLength);
+  consumed = bodyStart + contentLength;
+  return HttpComplete;
+}
+
+std::string formatHttpResponse(const HttpClientCpp::Response& response,
+                               bool keepAlive) {
+  std::string reply;
+  reply.reserve(160 + response.rawHeaders.size() + response.body.size());
+  reply += "HTTP/1.1 ";
+  reply += std::to_string(response.statusCode);
+  reply += ' ';
+  reply += statusText(response.statusCode);
+  reply += "\r\n";
+  reply += response.rawHeaders;
+  reply += "Content-Length: ";
+  reply += std::to_string(response.body.size());
+  reply += keepAlive ? "\r\nConnection: keep-alive\r\n\r\n"
+                     : "\r\nConnection: close\r\n\r\n";
+  reply += response.body;
+  return reply;
+}
+
+bool gunzipBody(std::string& body, size_t maxSize) {
+#ifdef HTTP_MESSAGE_HAS_ZLIB
+  z_stream stream = {};
+  // windowBits 15 + 16：只接受 gzip 封装
+  if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+    return false;
+  }
+
+  std::string output;
+  char chunk[16 * 1024];
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body.data()));
+  stream.avail_in = static_cast<uInt>(body.size());
+
+  int res = Z_OK;
+  while (res == Z_OK) {
+    stream.next_out = reinterpret_cast<Bytef*>(chunk);
+    stream.avail_out = sizeof(chunk);
+    res = inflate(&stream, Z_NO_FLUSH);
+    if (res != Z_OK && res != Z_STREAM_END) break;
+
+    output.append(chunk, sizeof(chunk) - stream.avail_out);
+    if (output.size() > maxSize) {
+      res = Z_MEM_ERROR;  // 解压炸弹
+      break;
+    }
+    if (res == Z_OK && stream.avail_in == 0 && stream.avail_out != 0) {
+      res = Z_DATA_ERROR;  // 数据被截断
+    }
+  }
+  inflateEnd(&stream);
+
+  if (res != Z_STREAM_END) {
+    return false;
+  }
+  body.swap(output);
+  return true;
+#else
+  (void)body;
+  (void)maxSize;
+  return false;
+#endif
+}
+
+void gzipResponse(const HttpClientCpp::Request& request,
+                  HttpClientCpp::Response& response, size_t minSize) {
+#ifdef HTTP_MESSAGE_HAS_ZLIB
+  if (response.body.size() < minSize || response.statusCode < 200 ||
+      response.statusCode >= 300) {
+    return;
+  }
+
+  bool acceptsGzip = false;
+  for (const auto& header : request.headers) {
+    if (equalsIgnoreCase(header.first, "Accept-Encoding")) {
+      std::string value = header.second;
+      for (char& c : value) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+      }
+      acceptsGzip = value.find("gzip") != std::string::npos;
+    }
+  }
+  if (!acceptsGzip) return;
+
+  z_stream stream = {};
+  if (deflateInit2(&stream, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) !=
+      Z_OK) {
+    return;
+  }
+
+  std::string output;
+  output.resize(
+      deflateBound(&stream, static_cast<uLong>(response.body.size())));
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(response.body.data()));
+  stream.avail_in = static_cast<uInt>(response.body.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  stream.avail_out = static_cast<uInt>(output.size());
+
+  int res = deflate(&stream, Z_FINISH);
+  output.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  if (res == Z_STREAM_END) {
+    response.body.swap(output);
+    response.rawHeaders +=
+        "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n";
+  }
+#else
+  (void)request;
+  (void)response;
+  (void)minSize;
+#endif
+}
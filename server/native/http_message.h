@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "http_client_cpp.h"
+
+// ============================================================================
+// HTTP/1.1 报文的解析与生成（原生服务端与替身服务器共用）
+// 只支持 Content-Length 请求体，不支持分块传输
+// ============================================================================
+
+// 请求头与请求体的上限
+static const size_t kHttpMaxHeaderBytes = 16 * 1024;
+static const size_t kHttpMaxBodyBytes = 1024 * 1024;
+
+enum HttpParseStatus {
+  HttpIncomplete,  // 数据不完整，需要继续读取
+  HttpComplete,    // 解析出一个完整请求
+  HttpInvalid      // 请求格式错误或超出上限，应返回 400 后关闭连接
+};
+
+/// <summary>
+/// 从 buffer 开头解析一个请求
+/// 完整时 consumed 为该请求占用的字节数（之后可能还有流水线请求），
+/// keepAlive 表示响应后是否保持连接
+/// </summary>
+HttpParseStatus parseHttpRequest(const std::string& buffer,
+                                 HttpClientCpp::Request& request,
+                                 size_t& consumed, bool& keepAlive);
+
+/// <summary>
+/// 生成响应报文（状态行、response.rawHeaders、Content-Length、Connection）
+/// </summary>
+std::string formatHttpResponse(const HttpClientCpp::Response& response,
+                               bool keepAlive);
+
+/// <summary>
+/// 解压 Content-Encoding: gzip 的请求体（解压后超过 maxSize 时失败）
+/// 未编译 zlib 支持时总是失败
+/// </summary>
+bool gunzipBody(std::string& body, size_t maxSize);
+
+/// <summary>
+/// 客户端接受 gzip 且响应体不小于 minSize 时压缩响应体，并添加响应头
+/// 未编译 zlib 支持时不做任何事
+/// </summary>
+void gzipResponse(const HttpClientCpp::Request& request,
+                  HttpClientCpp::Response& response, size_t minSize = 1024);
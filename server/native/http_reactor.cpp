@@ -0,0 +1,407 @@
+#include "http_reactor.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <utility>
+
+#include "http_message.h"
+#include "license_protocol.h"
+
+// epoll 数据中的保留标识（连接 id 从 1 开始）
+static const uint64_t kListenerId = 0;
+static const uint64_t kWakeupId = UINT64_MAX;
+
+// 事件循环的最长等待时间（用于空闲连接检查）
+static const int kEpollTimeoutMs = 1000;
+static const int kMaxEvents = 256;
+
+static HttpClientCpp::Response errorResponse(int statusCode,
+                                             const char* message) {
+  return jsonResponse(statusCode,
+                      std::string("{\"success\":false,\"message\":\"") +
+                          message + "\"}");
+}
+
+// ============================================================================
+// HttpReactor 实现
+// ============================================================================
+
+HttpReactor::HttpReactor(const Options& options, HandlerFactory factory)
+    : m_options(options),
+      m_factory(std::move(factory)),
+      m_listener(-1),
+      m_epoll(-1),
+      m_wakeup(-1),
+      m_running(false),
+      m_nextId(1),
+      m_stopping(false) {
+  if (m_options.workers <= 0) {
+    m_options.workers =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+}
+
+HttpReactor::~HttpReactor() {
+  shutdownWorkers();
+  for (auto& entry : m_connections) {
+    close(entry.second.fd);
+  }
+  if (m_listener >= 0) close(m_listener);
+  if (m_wakeup >= 0) close(m_wakeup);
+  if (m_epoll >= 0) close(m_epoll);
+}
+
+bool HttpReactor::start(std::string& error) {
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(m_options.port));
+  if (inet_pton(AF_INET, m_options.bindAddress.c_str(), &address.sin_addr) !=
+      1) {
+    error = "无效的监听地址: " + m_options.bindAddress;
+    return false;
+  }
+
+  m_listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  int reuse = 1;
+  setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  if (m_listener < 0 ||
+      bind(m_listener, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      listen(m_listener, SOMAXCONN) != 0) {
+    error = std::strerror(errno);
+    return false;
+  }
+
+  m_epoll = epoll_create1(EPOLL_CLOEXEC);
+  m_wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_epoll < 0 || m_wakeup < 0) {
+    error = std::strerror(errno);
+    return false;
+  }
+
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.u64 = kListenerId;
+  epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_listener, &event);
+  event.data.u64 = kWakeupId;
+  epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &event);
+
+  // 处理函数在各自的工作线程中创建
+  for (int i = 0; i < m_options.workers; i++) {
+    m_workers.emplace_back(&HttpReactor::workerLoop, this);
+  }
+
+  m_running = true;
+  return true;
+}
+
+void HttpReactor::stop() {
+  m_running = false;
+  uint64_t one = 1;
+  ssize_t ignored = write(m_wakeup, &one, sizeof(one));
+  (void)ignored;
+}
+
+void HttpReactor::run() {
+  epoll_event events[kMaxEvents];
+  std::time_t lastSweep = std::time(nullptr);
+
+  while (m_running) {
+    int count = epoll_wait(m_epoll, events, kMaxEvents, kEpollTimeoutMs);
+    if (count < 0 && errno != EINTR) {
+      std::cerr << "epoll_wait 失败: " << std::strerror(errno) << "\n";
+      break;
+    }
+
+    for (int i = 0; i < count; i++) {
+      uint64_t id = events[i].data.u64;
+      if (id == kListenerId) {
+        acceptConnections();
+      } else if (id == kWakeupId) {
+        uint64_t value;
+        ssize_t ignored = read(m_wakeup, &value, sizeof(value));
+        (void)ignored;
+        drainCompletions();
+      } else {
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+          closeConnection(id);
+          continue;
+        }
+        if (events[i].events & EPOLLOUT) flushConnection(id);
+        if (events[i].events & EPOLLIN) readConnection(id);
+      }
+    }
+
+    std::time_t now = std::time(nullptr);
+    if (now != lastSweep) {
+      lastSweep = now;
+      sweepIdle();
+    }
+  }
+
+  shutdownWorkers();
+}
+
+void HttpReactor::workerLoop() {
+  Handler handler = m_factory();
+
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(m_jobMutex);
+      m_jobReady.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+      if (m_stopping) return;
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+    }
+
+    HttpClientCpp::Response response;
+    std::string encoding = requestHeader(job.request, "Content-Encoding");
+    if (!encoding.empty() && encoding != "gzip" && encoding != "identity") {
+      response = errorResponse(415, "Unsupported Content-Encoding");
+    } else if (encoding == "gzip" &&
+               !gunzipBody(job.request.body, kHttpMaxBodyBytes)) {
+      response = errorResponse(400, "Invalid gzip body");
+    } else {
+      try {
+        response = handler(job.request, job.clientIp);
+      } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << std::endl;
+        response = errorResponse(500, "Server error");
+      }
+      gzipResponse(job.request, response);
+    }
+
+    Completion completion{job.connectionId,
+                          formatHttpResponse(response, job.keepAlive),
+                          job.keepAlive};
+    {
+      std::lock_guard<std::mutex> lock(m_completionMutex);
+      m_completions.push_back(std::move(completion));
+    }
+    uint64_t one = 1;
+    ssize_t ignored = write(m_wakeup, &one, sizeof(one));
+    (void)ignored;
+  }
+}
+
+void HttpReactor::acceptConnections() {
+  while (true) {
+    sockaddr_in peer{};
+    socklen_t peerLength = sizeof(peer);
+    int fd = accept4(m_listener, reinterpret_cast<sockaddr*>(&peer),
+                     &peerLength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        std::cerr << "accept 失败: " << std::strerror(errno) << "\n";
+      }
+      return;
+    }
+
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    char ip[INET_ADDRSTRLEN] = {};
+    inet_ntop(AF_INET, &peer.sin_addr, ip, sizeof(ip));
+
+    uint64_t id = m_nextId++;
+    Connection& connection = m_connections[id];
+    connection.fd = fd;
+    connection.clientIp = ip;
+    connection.lastActive = std::time(nullptr);
+    connection.events = EPOLLIN | EPOLLRDHUP;
+
+    epoll_event event{};
+    event.events = connection.events;
+    event.data.u64 = id;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event);
+  }
+}
+
+void HttpReactor::readConnection(uint64_t id) {
+  auto it = m_connections.find(id);
+  if (it == m_connections.end()) return;
+  Connection& connection = it->second;
+
+  char chunk[16 * 1024];
+  while (true) {
+    ssize_t n = recv(connection.fd, chunk, sizeof(chunk), 0);
+    if (n > 0) {
+      connection.input.append(chunk, static_cast<size_t>(n));
+      // 处理中的连接继续发送的流水线数据也不能无限缓冲
+      if (connection.input.size() > kHttpMaxHeaderBytes + kHttpMaxBodyBytes) {
+        closeConnection(id);
+        return;
+      }
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+    // 对端关闭写端（半关闭）：仍可写回，答复已收到的完整请求后再关闭；
+    // 不再关注可读事件（否则水平触发会持续报告 EOF）
+    if (n == 0) {
+      connection.peerClosed = true;
+      updateEvents(id, connection);
+      break;
+    }
+
+    // 连接出错
+    closeConnection(id);
+    return;
+  }
+
+  connection.lastActive = std::time(nullptr);
+  processInput(id);
+}
+
+void HttpReactor::processInput(uint64_t id) {
+  auto it = m_connections.find(id);
+  if (it == m_connections.end()) return;
+  Connection& connection = it->second;
+  if (connection.busy || connection.closeAfterWrite) return;
+
+  Job job;
+  size_t consumed = 0;
+  bool keepAlive = true;
+  HttpParseStatus status =
+      parseHttpRequest(connection.input, job.request, consumed, keepAlive);
+
+  if (status == HttpIncomplete) {
+    // 对端已半关闭：不会再有数据，发送完已有答复后关闭
+    if (connection.peerClosed) {
+      connection.closeAfterWrite = true;
+      flushConnection(id);
+    }
+    return;
+  }
+
+  if (status == HttpInvalid) {
+    connection.output +=
+        formatHttpResponse(errorResponse(400, "Bad request"), false);
+    connection.closeAfterWrite = true;
+    flushConnection(id);
+    return;
+  }
+
+  connection.input.erase(0, consumed);
+  connection.busy = true;
+  job.connectionId = id;
+  job.clientIp = connection.clientIp;
+  job.keepAlive = keepAlive;
+  {
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    m_jobs.push_back(std::move(job));
+  }
+  m_jobReady.notify_one();
+}
+
+void HttpReactor::flushConnection(uint64_t id) {
+  auto it = m_connections.find(id);
+  if (it == m_connections.end()) return;
+  Connection& connection = it->second;
+
+  size_t written = 0;
+  while (written < connection.output.size()) {
+    ssize_t n = ::send(connection.fd, connection.output.data() + written,
+                       connection.output.size() - written, MSG_NOSIGNAL);
+    if (n > 0) {
+      written += static_cast<size_t>(n);
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    closeConnection(id);
+    return;
+  }
+  connection.output.erase(0, written);
+
+  // 内核发送缓冲区已满时等待 EPOLLOUT
+  updateEvents(id, connection);
+
+  if (connection.output.empty() && connection.closeAfterWrite) {
+    closeConnection(id);
+  }
+}
+
+void HttpReactor::updateEvents(uint64_t id, Connection& connection) {
+  uint32_t events = 0;
+  if (!connection.peerClosed) events |= EPOLLIN | EPOLLRDHUP;
+  if (!connection.output.empty()) events |= EPOLLOUT;
+  if (events == connection.events) return;
+
+  epoll_event event{};
+  event.events = events;
+  event.data.u64 = id;
+  epoll_ctl(m_epoll, EPOLL_CTL_MOD, connection.fd, &event);
+  connection.events = events;
+}
+
+void HttpReactor::drainCompletions() {
+  std::vector<Completion> completions;
+  {
+    std::lock_guard<std::mutex> lock(m_completionMutex);
+    completions.swap(m_completions);
+  }
+
+  for (Completion& completion : completions) {
+    auto it = m_connections.find(completion.connectionId);
+    if (it == m_connections.end()) continue;  // 处理期间连接已关闭
+
+    Connection& connection = it->second;
+    connection.busy = false;
+    connection.lastActive = std::time(nullptr);
+    connection.output += completion.reply;
+    if (!completion.keepAlive) connection.closeAfterWrite = true;
+
+    flushConnection(completion.connectionId);
+    // 继续处理流水线中已到达的下一个请求
+    processInput(completion.connectionId);
+  }
+}
+
+void HttpReactor::sweepIdle() {
+  std::time_t deadline = std::time(nullptr) - m_options.idleTimeoutSeconds;
+  std::vector<uint64_t> idle;
+  for (const auto& entry : m_connections) {
+    if (!entry.second.busy && entry.second.lastActive < deadline) {
+      idle.push_back(entry.first);
+    }
+  }
+  for (uint64_t id : idle) {
+    closeConnection(id);
+  }
+}
+
+void HttpReactor::closeConnection(uint64_t id) {
+  auto it = m_connections.find(id);
+  if (it == m_connections.end()) return;
+  epoll_ctl(m_epoll, EPOLL_CTL_DEL, it->second.fd, nullptr);
+  close(it->second.fd);
+  m_connections.erase(it);
+}
+
+void HttpReactor::shutdownWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    m_stopping = true;
+  }
+  m_jobReady.notify_all();
+  for (std::thread& worker : m_workers) {
+    worker.join();
+  }
+  m_workers.clear();
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "http_client_cpp.h"
+
+/// <summary>
+/// epoll 反应器 + 工作线程池的 HTTP/1.1 服务器（Linux）
+/// 反应器线程负责 accept、读写与报文解析，处理函数在工作线程中执行；
+/// 同一连接一次只处理一个请求，完成后再解析缓冲区中的下一个（支持流水线）
+/// </summary>
+class HttpReactor {
+ public:
+  struct Options {
+    std::string bindAddress = "0.0.0.0";
+    int port = 5000;
+    int workers = 0;                // 0 表示硬件线程数
+    int idleTimeoutSeconds = 60;    // 空闲连接超时
+  };
+
+  using Handler = std::function<HttpClientCpp::Response(
+      const HttpClientCpp::Request& request, const std::string& clientIp)>;
+
+  /// <summary>
+  /// 每个工作线程启动时调用一次，创建该线程独占的处理函数
+  /// （处理函数可以持有线程私有的状态，例如数据库连接）
+  /// </summary>
+  using HandlerFactory = std::function<Handler()>;
+
+  HttpReactor(const Options& options, HandlerFactory factory);
+  ~HttpReactor();
+
+  HttpReactor(const HttpReactor&) = delete;
+  HttpReactor& operator=(const HttpReactor&) = delete;
+
+  /// <summary>
+  /// 监听端口并启动工作线程，失败时返回 false 并设置 error
+  /// </summary>
+  bool start(std::string& error);
+
+  /// <summary>
+  /// 运行事件循环，直到 stop() 被调用
+  /// </summary>
+  void run();
+
+  /// <summary>
+  /// 停止事件循环（线程安全，可在信号处理线程中调用）
+  /// </summary>
+  void stop();
+
+ private:
+  struct Connection {
+    int fd = -1;
+    std::string clientIp;
+    std::string input;
+    std::string output;
+    bool busy = false;              // 有请求在工作线程中处理
+    bool closeAfterWrite = false;
+    bool peerClosed = false;        // 对端已关闭写端：答复已收到的请求后关闭
+    uint32_t events = 0;            // 已注册的 epoll 事件
+    std::time_t lastActive = 0;
+  };
+
+  struct Job {
+    uint64_t connectionId;
+    std::string clientIp;
+    HttpClientCpp::Request request;
+    bool keepAlive;
+  };
+
+  struct Completion {
+    uint64_t connectionId;
+    std::string reply;
+    bool keepAlive;
+  };
+
+  Options m_options;
+  HandlerFactory m_factory;
+
+  int m_listener;
+  int m_epoll;
+  int m_wakeup;  // eventfd：工作线程完成或 stop() 时唤醒反应器
+  std::atomic<bool> m_running;
+
+  uint64_t m_nextId;
+  std::unordered_map<uint64_t, Connection> m_connections;
+
+  std::mutex m_jobMutex;
+  std::condition_variable m_jobReady;
+  std::deque<Job> m_jobs;
+  bool m_stopping;
+
+  std::mutex m_completionMutex;
+  std::vector<Completion> m_completions;
+
+  std::vector<std::thread> m_workers;
+
+  void workerLoop();
+  void acceptConnections();
+  void readConnection(uint64_t id);
+  void processInput(uint64_t id);
+  void flushConnection(uint64_t id);
+  // 按连接状态更新 epoll 关注的事件（读：对端未关闭写端；写：有待发送数据）
+  void updateEvents(uint64_t id, Connection& connection);
+  void drainCompletions();
+  void sweepIdle();
+  void closeConnection(uint64_t id);
+  void shutdownWorkers();
+};
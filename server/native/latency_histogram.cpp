@@ -0,0 +1,236 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+// 最高置位的位置（value 不为 0）
+static int highestBit(uint64_t value) {
+  int bit = 0;
+  for (int shift = 32; shift > 0; shift >>= 1) {
+    if (value >> shift) {
+      value >>= shift;
+      bit += shift;
+    }
+  }
+  return bit;
+}
+
+// ============================================================================
+// LatencyHistogram 实现
+// ============================================================================
+
+LatencyHistogram::LatencyHistogram(int64_t highestTrackableValue,
+                                   int significantDigits)
+    : m_highestTrackableValue(std::max<int64_t>(highestTrackableValue, 2)),
+      m_totalCount(0),
+      m_min(std::numeric_limits<int64_t>::max()),
+      m_max(0) {
+  significantDigits = std::min(std::max(significantDigits, 1), 5);
+
+  // 单位精度覆盖到 2 * 10^digits，细分数取不小于它的 2 的幂
+  int64_t largestValueWithSingleUnitResolution = 2;
+  for (int i = 0; i < significantDigits; i++) {
+    largestValueWithSingleUnitResolution *= 10;
+  }
+  int subBucketCountMagnitude =
+      highestBit(static_cast<uint64_t>(largestValueWithSingleUnitResolution - 1)) + 1;
+  m_subBucketHalfCountMagnitude = std::max(subBucketCountMagnitude, 1) - 1;
+  m_subBucketCount = int64_t(1) << (m_subBucketHalfCountMagnitude + 1);
+  m_subBucketHalfCount = m_subBucketCount / 2;
+  m_subBucketMask = m_subBucketCount - 1;
+
+  // 覆盖最大值所需的桶数
+  int64_t smallestUntrackableValue = m_subBucketCount;
+  m_bucketCount = 1;
+  while (smallestUntrackableValue <= m_highestTrackableValue) {
+    if (smallestUntrackableValue > std::numeric_limits<int64_t>::max() / 2) {
+      m_bucketCount++;
+      break;
+    }
+    smallestUntrackableValue <<= 1;
+    m_bucketCount++;
+  }
+
+  m_countsLength =
+      static_cast<size_t>((m_bucketCount + 1) * m_subBucketHalfCount);
+  m_counts.reset(new std::atomic<uint64_t>[m_countsLength]);
+  for (size_t i = 0; i < m_countsLength; i++) {
+    m_counts[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+int LatencyHistogram::bucketIndexOf(int64_t value) const {
+  int pow2Ceiling =
+      highestBit(static_cast<uint64_t>(value | m_subBucketMask)) + 1;
+  return pow2Ceiling - (m_subBucketHalfCountMagnitude + 1);
+}
+
+size_t LatencyHistogram::countsIndexOf(int64_t value) const {
+  int bucketIndex = bucketIndexOf(value);
+  int64_t subBucketIndex = value >> bucketIndex;
+  int64_t bucketBase = int64_t(bucketIndex + 1) << m_subBucketHalfCountMagnitude;
+  return static_cast<size_t>(bucketBase + (subBucketIndex - m_subBucketHalfCount));
+}
+
+int64_t LatencyHistogram::valueFromIndex(size_t index) const {
+  int bucketIndex =
+      static_cast<int>(index >> m_subBucketHalfCountMagnitude) - 1;
+  int64_t subBucketIndex =
+      static_cast<int64_t>(index & static_cast<size_t>(m_subBucketHalfCount - 1)) +
+      m_subBucketHalfCount;
+  if (bucketIndex < 0) {
+    subBucketIndex -= m_subBucketHalfCount;
+    bucketIndex = 0;
+  }
+  return subBucketIndex << bucketIndex;
+}
+
+int64_t LatencyHistogram::lowestEquivalentValue(int64_t value) const {
+  int bucketIndex = bucketIndexOf(value);
+  return (value >> bucketIndex) << bucketIndex;
+}
+
+int64_t LatencyHistogram::highestEquivalentValue(int64_t value) const {
+  int bucketIndex = bucketIndexOf(value);
+  int64_t subBucketIndex = value >> bucketIndex;
+  int rangeMagnitude =
+      subBucketIndex >= m_subBucketCount ? bucketIndex + 1 : bucketIndex;
+  return lowestEquivalentValue(value) + (int64_t(1) << rangeMagnitude) - 1;
+}
+
+int64_t LatencyHistogram::medianEquivalentValue(int64_t value) const {
+  return (lowestEquivalentValue(value) + highestEquivalentValue(value)) / 2;
+}
+
+void LatencyHistogram::record(int64_t value) {
+  value = std::min(std::max<int64_t>(value, 0), m_highestTrackableValue);
+
+  m_counts[countsIndexOf(value)].fetch_add(1, std::memory_order_relaxed);
+  m_totalCount.fetch_add(1, std::memory_order_relaxed);
+
+  int64_t current = m_min.load(std::memory_order_relaxed);
+  while (value < current &&
+         !m_min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+  current = m_max.load(std::memory_order_relaxed);
+  while (value > current &&
+         !m_max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t LatencyHistogram::totalCount() const {
+  return m_totalCount.load(std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::min() const {
+  return totalCount() == 0 ? 0 : m_min.load(std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::max() const {
+  return m_max.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+  uint64_t total = totalCount();
+  if (total == 0) return 0.0;
+
+  double sum = 0.0;
+  for (size_t i = 0; i < m_countsLength; i++) {
+    uint64_t count = m_counts[i].load(std::memory_order_relaxed);
+    if (count > 0) {
+      sum += static_cast<double>(medianEquivalentValue(valueFromIndex(i))) *
+             static_cast<double>(count);
+    }
+  }
+  return sum / static_cast<double>(total);
+}
+
+double LatencyHistogram::stdDeviation() const {
+  uint64_t total = totalCount();
+  if (total == 0) return 0.0;
+
+  double average = mean();
+  double squares = 0.0;
+  for (size_t i = 0; i < m_countsLength; i++) {
+    uint64_t count = m_counts[i].load(std::memory_order_relaxed);
+    if (count > 0) {
+      double deviation =
+          static_cast<double>(medianEquivalentValue(valueFromIndex(i))) - average;
+      squares += deviation * deviation * static_cast<double>(count);
+    }
+  }
+  return std::sqrt(squares / static_cast<double>(total));
+}
+
+int64_t LatencyHistogram::valueAtPercentile(double percentile) const {
+  uint64_t total = totalCount();
+  if (total == 0) return 0;
+
+  percentile = std::min(std::max(percentile, 0.0), 100.0);
+  uint64_t countAtPercentile =
+      static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5);
+  countAtPercentile = std::max<uint64_t>(countAtPercentile, 1);
+
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < m_countsLength; i++) {
+    cumulative += m_counts[i].load(std::memory_order_relaxed);
+    if (cumulative >= countAtPercentile) {
+      return highestEquivalentValue(valueFromIndex(i));
+    }
+  }
+  return max();
+}
+
+void LatencyHistogram::writePercentileDistribution(std::ostream& out,
+                                                   double valueScale,
+                                                   int ticksPerHalfDistance) const {
+  char line[128];
+  std::snprintf(line, sizeof(line), "%12s %14s %10s %14s\n\n", "Value",
+                "Percentile", "TotalCount", "1/(1-Percentile)");
+  out << line;
+
+  uint64_t total = totalCount();
+  ticksPerHalfDistance = std::max(ticksPerHalfDistance, 1);
+
+  // 百分位按"距 100% 的剩余一半"逐级加密：每减半一次，步长也减半
+  double percentile = 0.0;
+  uint64_t cumulative = 0;
+  size_t index = 0;
+  while (total > 0 && cumulative < total) {
+    uint64_t countAtPercentile = std::max<uint64_t>(
+        static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5),
+        1);
+    while (cumulative < countAtPercentile && index < m_countsLength) {
+      cumulative += m_counts[index++].load(std::memory_order_relaxed);
+    }
+    int64_t value = highestEquivalentValue(valueFromIndex(index - 1));
+
+    std::snprintf(line, sizeof(line), "%12.3f %2.12f %10llu %14.2f\n",
+                  static_cast<double>(value) / valueScale, percentile / 100.0,
+                  static_cast<unsigned long long>(cumulative),
+                  1.0 / (1.0 - percentile / 100.0));
+    out << line;
+
+    double halfDistance =
+        std::pow(2.0, std::floor(std::log2(100.0 / (100.0 - percentile))) + 1.0);
+    percentile += 100.0 / (ticksPerHalfDistance * halfDistance);
+  }
+
+  std::snprintf(line, sizeof(line), "%12.3f %2.12f %10llu\n",
+                static_cast<double>(max()) / valueScale, 1.0,
+                static_cast<unsigned long long>(total));
+  out << line;
+
+  std::snprintf(line, sizeof(line), "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n",
+                mean() / valueScale, stdDeviation() / valueScale);
+  out << line;
+  std::snprintf(line, sizeof(line), "#[Max     = %12.3f, Total count    = %12llu]\n",
+                static_cast<double>(max()) / valueScale,
+                static_cast<unsigned long long>(total));
+  out << line;
+  std::snprintf(line, sizeof(line), "#[Buckets = %12d, SubBuckets     = %12lld]\n",
+                m_bucketCount, static_cast<long long>(m_subBucketCount));
+  out << line;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+/// <summary>
+/// 延迟直方图（HdrHistogram 算法）
+/// 以 2 的幂分桶，每桶再线性细分，在 [1, highestTrackableValue] 内保持
+/// significantDigits 位有效数字的精度；计数为原子变量，可被多个线程同时记录
+/// </summary>
+class LatencyHistogram {
+ public:
+  /// <param name="highestTrackableValue">可记录的最大值（更大的值按最大值记录）</param>
+  /// <param name="significantDigits">有效数字位数（1-5）</param>
+  explicit LatencyHistogram(int64_t highestTrackableValue = 3600LL * 1000 * 1000,
+                            int significantDigits = 3);
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  /// <summary>
+  /// 记录一个值（负值按 0 记录）
+  /// </summary>
+  void record(int64_t value);
+
+  uint64_t totalCount() const;
+  int64_t min() const;
+  int64_t max() const;
+  double mean() const;
+  double stdDeviation() const;
+
+  /// <summary>
+  /// 百分位数（0-100）对应的值：不小于该比例样本的最小等价区间的上界
+  /// </summary>
+  int64_t valueAtPercentile(double percentile) const;
+
+  /// <summary>
+  /// 以 HdrHistogram 的 .hgrm 文本格式输出百分位分布
+  /// </summary>
+  /// <param name="valueScale">输出时值除以的比例（如微秒输出为毫秒用 1000）</param>
+  void writePercentileDistribution(std::ostream& out, double valueScale = 1.0,
+                                   int ticksPerHalfDistance = 5) const;
+
+ private:
+  int64_t m_highestTrackableValue;
+  int m_subBucketHalfCountMagnitude;
+  int64_t m_subBucketCount;
+  int64_t m_subBucketHalfCount;
+  int64_t m_subBucketMask;
+  int m_bucketCount;
+  size_t m_countsLength;
+  std::unique_ptr<std::atomic<uint64_t>[]> m_counts;
+
+  std::atomic<uint64_t> m_totalCount;
+  std::atomic<int64_t> m_min;
+  std::atomic<int64_t> m_max;
+
+  int bucketIndexOf(int64_t value) const;
+  size_t countsIndexOf(int64_t value) const;
+  int64_t valueFromIndex(size_t index) const;
+  int64_t lowestEquivalentValue(int64_t value) const;
+  int64_t highestEquivalentValue(int64_t value) const;
+  int64_t medianEquivalentValue(int64_t value) const;
+};
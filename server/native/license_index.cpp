@@ -0,0 +1,294 @@
+#include "license_index.h"
+
+#include <openssl/evp.h>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <utility>
+
+// 每个分片的初始容量与最大装载率（超过时容量翻倍）
+static const size_t kInitialSlots = 64;
+static const size_t kMaxLoadPercent = 70;
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;  // 大写视为非规范格式（与字符串比较的语义一致）
+}
+
+static uint64_t mix64(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+// SHA-256（算法对象只获取一次，上下文每线程复用；一次性的 SHA256() 每次调用
+// 都要重新获取算法实现，验证路径上慢数倍）
+static void sha256(const std::string& input, uint8_t out[32]) {
+  static EVP_MD* const md = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+  thread_local std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> context(
+      EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+
+  unsigned int length = 0;
+  EVP_DigestInit_ex(context.get(), md, nullptr);
+  EVP_DigestUpdate(context.get(), input.data(), input.size());
+  EVP_DigestFinal_ex(context.get(), out, &length);
+}
+
+static void digestLicenseKey(const std::string& licenseKey,
+                             uint8_t digest[16]) {
+  uint8_t hash[32];
+  sha256(licenseKey, hash);
+  std::memcpy(digest, hash, 16);
+}
+
+// ============================================================================
+// LicenseIndexEntry 实现
+// ============================================================================
+
+bool LicenseIndexEntry::keyMatches(const std::string& licenseKey) const {
+  uint8_t digest[16];
+  digestLicenseKey(licenseKey, digest);
+  uint8_t diff = 0;
+  for (int i = 0; i < 16; i++) {
+    diff |= static_cast<uint8_t>(digest[i] ^ keyDigest[i]);
+  }
+  return diff == 0;
+}
+
+std::string LicenseIndexEntry::expiresAtText() const {
+  char buffer[32];
+  int length = std::snprintf(
+      buffer, sizeof(buffer), "%04u-%02u-%02u %02u:%02u:%02u",
+      static_cast<unsigned>(expiresAt >> 50),
+      static_cast<unsigned>((expiresAt >> 46) & 0xF),
+      static_cast<unsigned>((expiresAt >> 41) & 0x1F),
+      static_cast<unsigned>((expiresAt >> 36) & 0x1F),
+      static_cast<unsigned>((expiresAt >> 30) & 0x3F),
+      static_cast<unsigned>((expiresAt >> 24) & 0x3F));
+  if (has(kHasMicros)) {
+    std::snprintf(buffer + length, sizeof(buffer) - length, ".%06u",
+                  static_cast<unsigned>(expiresAt & 0xFFFFF));
+  }
+  return buffer;
+}
+
+// ============================================================================
+// LicenseIndex 实现
+// ============================================================================
+
+LicenseIndex::LicenseIndex()
+    : m_shards(new Shard[kShardCount]), m_seed(std::random_device{}()) {
+  m_seed = mix64((m_seed << 32) ^ std::random_device{}());
+  for (size_t i = 0; i < kShardCount; i++) {
+    m_shards[i].slots.resize(kInitialSlots);
+  }
+}
+
+uint64_t LicenseIndex::packLocalTime(std::time_t time, long micros) {
+  std::tm local{};
+  localtime_r(&time, &local);
+  return (static_cast<uint64_t>(local.tm_year + 1900) << 50) |
+         (static_cast<uint64_t>(local.tm_mon + 1) << 46) |
+         (static_cast<uint64_t>(local.tm_mday) << 41) |
+         (static_cast<uint64_t>(local.tm_hour) << 36) |
+         (static_cast<uint64_t>(local.tm_min) << 30) |
+         (static_cast<uint64_t>(local.tm_sec) << 24) |
+         static_cast<uint64_t>(micros);
+}
+
+bool LicenseIndex::packLocalTime(const std::string& text, uint64_t& packed,
+                                 bool& withMicros) {
+  // 只接受能原样还原的格式，其他格式交给数据库路径处理
+  unsigned year, month, day, hour, minute, second, micros = 0;
+  int consumed = 0;
+  if (text.size() != 19 && text.size() != 26) return false;
+  if (std::sscanf(text.c_str(), "%4u-%2u-%2u %2u:%2u:%2u%n", &year, &month,
+                  &day, &hour, &minute, &second, &consumed) != 6 ||
+      consumed != 19) {
+    return false;
+  }
+  withMicros = text.size() == 26;
+  if (withMicros && (text[19] != '.' ||
+                     std::sscanf(text.c_str() + 20, "%6u", &micros) != 1)) {
+    return false;
+  }
+  if (year > 9999 || month > 12 || day > 31 || hour > 23 || minute > 59 ||
+      second > 60) {
+    return false;
+  }
+
+  packed = (static_cast<uint64_t>(year) << 50) |
+           (static_cast<uint64_t>(month) << 46) |
+           (static_cast<uint64_t>(day) << 41) |
+           (static_cast<uint64_t>(hour) << 36) |
+           (static_cast<uint64_t>(minute) << 30) |
+           (static_cast<uint64_t>(second) << 24) | micros;
+  return true;
+}
+
+bool LicenseIndex::makeKey(const std::string& machineCode, uint8_t key[32],
+                           bool& hashed) const {
+  if (machineCode.empty()) return false;
+
+  hashed = machineCode.size() != 64;
+  for (size_t i = 0; !hashed && i < 32; i++) {
+    int high = hexValue(machineCode[2 * i]);
+    int low = hexValue(machineCode[2 * i + 1]);
+    if (high < 0 || low < 0) {
+      hashed = true;
+      break;
+    }
+    key[i] = static_cast<uint8_t>((high << 4) | low);
+  }
+
+  if (hashed) {
+    sha256(machineCode, key);
+  }
+  return true;
+}
+
+uint64_t LicenseIndex::hashKey(const uint8_t key[32]) const {
+  uint64_t words[4];
+  std::memcpy(words, key, sizeof(words));
+  uint64_t hash = m_seed;
+  for (uint64_t word : words) {
+    hash = mix64(hash ^ word);
+  }
+  return hash;
+}
+
+void LicenseIndex::insertLocked(Shard& shard,
+                                const LicenseIndexEntry& entry) const {
+  if ((shard.count + 1) * 100 > shard.slots.size() * kMaxLoadPercent) {
+    // 容量翻倍并重新插入（分片内，只阻塞本分片）
+    std::vector<LicenseIndexEntry> old(shard.slots.size() * 2);
+    old.swap(shard.slots);
+    shard.count = 0;
+    for (const LicenseIndexEntry& slot : old) {
+      if (slot.has(LicenseIndexEntry::kOccupied)) insertLocked(shard, slot);
+    }
+  }
+
+  size_t mask = shard.slots.size() - 1;
+  size_t i = static_cast<size_t>(hashKey(entry.key)) & mask;
+  while (true) {
+    LicenseIndexEntry& slot = shard.slots[i];
+    if (!slot.has(LicenseIndexEntry::kOccupied)) {
+      slot = entry;
+      shard.count++;
+      return;
+    }
+    if (std::memcmp(slot.key, entry.key, sizeof(entry.key)) == 0 &&
+        (slot.flags & LicenseIndexEntry::kHashedKey) ==
+            (entry.flags & LicenseIndexEntry::kHashedKey)) {
+      slot = entry;
+      return;
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+bool LicenseIndex::makeEntry(const LicenseRecord& record,
+                             LicenseIndexEntry& entry) const {
+  entry = LicenseIndexEntry{};
+  bool hashed = false;
+  if (!makeKey(record.machineCode, entry.key, hashed)) return false;
+
+  digestLicenseKey(record.licenseKey, entry.keyDigest);
+  entry.flags = LicenseIndexEntry::kOccupied;
+  if (hashed) entry.flags |= LicenseIndexEntry::kHashedKey;
+
+  // 非 active 的状态文本不存入索引（提示信息需要回查数据库）
+  if (record.status != "active") {
+    entry.flags |= LicenseIndexEntry::kNeedsRecord;
+  }
+  if (record.hasExpiresAt) {
+    bool withMicros = false;
+    if (packLocalTime(record.expiresAt, entry.expiresAt, withMicros)) {
+      entry.flags |= LicenseIndexEntry::kHasExpiry;
+      if (withMicros) entry.flags |= LicenseIndexEntry::kHasMicros;
+    } else {
+      entry.flags |= LicenseIndexEntry::kNeedsRecord;
+    }
+  }
+
+  return true;
+}
+
+void LicenseIndex::put(const LicenseRecord& record) {
+  LicenseIndexEntry entry;
+  if (!makeEntry(record, entry)) return;
+
+  // 分片取哈希高位，槽位取低位
+  Shard& shard = m_shards[hashKey(entry.key) >> 58];
+  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+  insertLocked(shard, entry);
+}
+
+bool LicenseIndex::find(const std::string& machineCode,
+                        LicenseIndexEntry& entry) const {
+  uint8_t key[32];
+  bool hashed = false;
+  if (!makeKey(machineCode, key, hashed)) return false;
+  uint8_t hashedFlag = hashed ? LicenseIndexEntry::kHashedKey : 0;
+
+  uint64_t hash = hashKey(key);
+  const Shard& shard = m_shards[hash >> 58];
+  std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+  size_t mask = shard.slots.size() - 1;
+  for (size_t i = static_cast<size_t>(hash) & mask;; i = (i + 1) & mask) {
+    const LicenseIndexEntry& slot = shard.slots[i];
+    if (!slot.has(LicenseIndexEntry::kOccupied)) return false;
+    if (std::memcmp(slot.key, key, sizeof(key)) == 0 &&
+        (slot.flags & LicenseIndexEntry::kHashedKey) == hashedFlag) {
+      entry = slot;
+      return true;
+    }
+  }
+}
+
+size_t LicenseIndex::size() const {
+  size_t total = 0;
+  for (size_t i = 0; i < kShardCount; i++) {
+    std::shared_lock<std::shared_mutex> lock(m_shards[i].mutex);
+    total += m_shards[i].count;
+  }
+  return total;
+}
+
+bool LicenseIndex::load(LicenseStore& store, std::string& error) {
+  return store.forEach([this](const LicenseRecord& record) { put(record); },
+                       error);
+}
+
+bool LicenseIndex::reload(LicenseStore& store, std::string& error) {
+  // 在私有的分片中重建（不加锁），完成后逐个分片交换
+  std::unique_ptr<Shard[]> fresh(new Shard[kShardCount]);
+  for (size_t i = 0; i < kShardCount; i++) {
+    fresh[i].slots.resize(kInitialSlots);
+  }
+  LicenseIndexEntry entry;
+  bool loaded = store.forEach(
+      [&](const LicenseRecord& record) {
+        if (makeEntry(record, entry)) {
+          insertLocked(fresh[hashKey(entry.key) >> 58], entry);
+        }
+      },
+      error);
+  if (!loaded) return false;
+
+  for (size_t i = 0; i < kShardCount; i++) {
+    std::unique_lock<std::shared_mutex> lock(m_shards[i].mutex);
+    m_shards[i].slots.swap(fresh[i].slots);
+    std::swap(m_shards[i].count, fresh[i].count);
+  }
+  return true;
+}
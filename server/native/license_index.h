@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "license_store.h"
+
+/// <summary>
+/// 许可证索引中的一条记录（一个缓存行）
+/// 键为 32 字节的二进制机器码：64 位小写十六进制机器码直接解码，
+/// 其他格式的机器码取 SHA-256（以 kHashedKey 区分，两种键不会互相匹配）
+/// </summary>
+struct alignas(64) LicenseIndexEntry {
+  enum Flags : uint8_t {
+    kOccupied = 1 << 0,
+    kHashedKey = 1 << 1,
+    kHasExpiry = 1 << 2,    // expires_at 非 NULL
+    kHasMicros = 1 << 3,    // expires_at 带微秒
+    kNeedsRecord = 1 << 4,  // 非 active 或过期时间无法编码，需回查数据库
+  };
+
+  uint8_t key[32];
+  uint8_t keyDigest[16];  // SHA-256(license_key) 的前 16 字节
+  uint64_t expiresAt;     // 打包的本地时间，见 LicenseIndex::packLocalTime
+  uint8_t flags;
+
+  bool has(Flags flag) const { return (flags & flag) != 0; }
+
+  /// <summary>
+  /// 许可证密钥是否匹配（常量时间比较摘要）
+  /// </summary>
+  bool keyMatches(const std::string& licenseKey) const;
+
+  /// <summary>
+  /// 过期时间文本，与数据库中的 expires_at 完全一致
+  /// </summary>
+  std::string expiresAtText() const;
+};
+
+static_assert(sizeof(LicenseIndexEntry) == 64, "one cache line per entry");
+
+/// <summary>
+/// 内存中的许可证索引（开放寻址、线性探测，按分片加读写锁）
+/// 启动时从数据库加载，之后由本进程签发的许可证同步更新；
+/// 验证时一次哈希定位到一个缓存行，不访问数据库。
+/// 只用于确认有效的许可证：未命中或结果不是有效时调用方应回查数据库。
+/// 其他进程直接写入数据库的修改（吊销、删除）在下次 reload() 后可见
+/// </summary>
+class LicenseIndex {
+ public:
+  LicenseIndex();
+
+  LicenseIndex(const LicenseIndex&) = delete;
+  LicenseIndex& operator=(const LicenseIndex&) = delete;
+
+  /// <summary>
+  /// 从数据库加载全部许可证，失败时返回 false 并设置 error
+  /// </summary>
+  bool load(LicenseStore& store, std::string& error);
+
+  /// <summary>
+  /// 从数据库重建索引并逐个分片替换（线程安全，查找不中断）
+  /// 重建期间由本进程写入的记录可能被替换掉，回查数据库时会重新写入；
+  /// 失败时保留原索引，返回 false 并设置 error
+  /// </summary>
+  bool reload(LicenseStore& store, std::string& error);
+
+  /// <summary>
+  /// 插入或更新一条许可证（线程安全）
+  /// </summary>
+  void put(const LicenseRecord& record);
+
+  /// <summary>
+  /// 按机器码查找（线程安全），找到时复制记录到 entry
+  /// </summary>
+  bool find(const std::string& machineCode, LicenseIndexEntry& entry) const;
+
+  /// <summary>
+  /// 记录总数
+  /// </summary>
+  size_t size() const;
+
+  /// <summary>
+  /// 把本地时间打包为可直接比较大小的整数：
+  /// 年(14) 月(4) 日(5) 时(5) 分(6) 秒(6) 微秒(20)，高位在前
+  /// </summary>
+  static uint64_t packLocalTime(std::time_t time, long micros);
+
+  /// <summary>
+  /// 解析 "YYYY-MM-DD HH:MM:SS[.ffffff]"，格式不符时返回 false
+  /// </summary>
+  static bool packLocalTime(const std::string& text, uint64_t& packed,
+                            bool& withMicros);
+
+ private:
+  // 分片数（2 的幂），降低锁竞争
+  static const size_t kShardCount = 64;
+
+  struct Shard {
+    mutable std::shared_mutex mutex;
+    std::vector<LicenseIndexEntry> slots;  // 容量为 2 的幂
+    size_t count = 0;
+  };
+
+  std::unique_ptr<Shard[]> m_shards;
+  uint64_t m_seed;  // 进程随机种子，防止构造碰撞的机器码
+
+  bool makeKey(const std::string& machineCode, uint8_t key[32],
+               bool& hashed) const;
+  uint64_t hashKey(const uint8_t key[32]) const;
+
+  // 由数据库记录生成索引条目，机器码为空时返回 false
+  bool makeEntry(const LicenseRecord& record, LicenseIndexEntry& entry) const;
+
+  // 调用方持有分片的写锁
+  void insertLocked(Shard& shard, const LicenseIndexEntry& entry) const;
+};
@@ -0,0 +1,497 @@
+// 授权客户端负载生成器
+// 以 LicenseClientCpp 发送带签名安全数据包的请求，统计吞吐量、错误率与延迟分布
+//
+// 开环模式（--rate > 0）：按固定速率在预定时间发出请求，不等待前一个请求完成；
+//   延迟从预定发送时间算起，服务变慢时排队时间计入延迟（避免协调遗漏）
+// 闭环模式（--rate 0）：始终保持 --concurrency 个请求在途，完成一个发出一个
+//
+// 用法: license_loadgen [选项]
+//   --url URL            服务器地址（默认 http://127.0.0.1:18080/api）
+//   --mode MODE          verify | request | health | startup（默认 verify）
+//   --rate N             每秒请求数，0 为闭环（默认 0）
+//   --concurrency N      同时在途的请求数上限（默认 32）
+//   --duration S         持续秒数（默认 10）
+//   --timeout-ms N       单个请求时限（默认 5000）
+//   --machines N         轮流使用的机器码数（默认 1000）
+//   --binary             使用二进制线格式
+//   --insecure           不验证服务器证书（本机自签名证书的 TLS 服务器）
+//   --no-http2           只使用 HTTP/1.1（默认通过 ALPN 协商 HTTP/2）
+//   --sync               同步调用方：--concurrency 个线程各自循环调用阻塞的
+//                        verifyLicense（只用于 verify 模式）
+//   --secret KEY         服务端密钥，用于计算期望的许可证密钥
+//   --app-secret KEY     应用密钥（与服务端一致）
+//   --hgrm FILE          将延迟分布（毫秒）写入 .hgrm 文件
+//   --in-process         不经过网络，直接调用进程内的 LicenseStandIn
+//   --latency-us N       进程内模式注入的固定延迟（默认 0）
+//   --jitter-us N        进程内模式注入的抖动上限（默认 0）
+//   --seed N             进程内模式的抖动种子（默认 1）
+//
+// startup 模式测量应用启动后首次验证的延迟：每轮新建客户端（无连接池、
+// 无 DNS 与 TLS 会话缓存），等待 --startup-delay-ms（模拟界面初始化与
+// 机器码生成，默认 200）后同步验证一次；冷启动与 prewarm() 交替进行，
+// 各 --runs 轮（默认 20），分别统计
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "http_client_cpp.h"
+#include "in_process_transport.h"
+#include "latency_histogram.h"
+#include "license_standin.h"
+#include "secure_transport_cpp.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadConfig {
+  std::string url = "http://127.0.0.1:18080/api";
+  std::string mode = "verify";
+  double rate = 0.0;
+  size_t concurrency = 32;
+  double durationSeconds = 10.0;
+  long timeoutMs = 5000;
+  size_t machines = 1000;
+  bool binary = false;
+  bool verifySSL = true;
+  bool http2 = true;
+  bool sync = false;
+  std::string secretKey = "DEFAULT_SECRET_KEY_2026";
+  std::string appSecret = "DEFAULT_APP_SECRET_2026_CHANGE_THIS";
+  std::string hgrmFile;
+  bool inProcess = false;
+  InProcessTransport::Options inProcessOptions;
+  int runs = 20;
+  long startupDelayMs = 200;
+};
+
+// 统计结果（回调可能在多个线程执行）
+struct LoadStats {
+  LatencyHistogram latencyUs;
+  std::atomic<uint64_t> completed{0};
+  std::atomic<uint64_t> errors{0};
+  std::atomic<int64_t> lastCompletionUs{0};  // 最后一次完成距开始的微秒数
+  std::mutex errorMutex;
+  std::string firstError;
+};
+
+// 闭环模式的在途请求配额
+class Permits {
+ public:
+  explicit Permits(size_t count) : m_available(count) {}
+
+  void acquire() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]() { return m_available > 0; });
+    m_available--;
+  }
+
+  void release() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_available++;
+    }
+    m_cv.notify_one();
+  }
+
+ private:
+  size_t m_available;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+};
+
+static bool parseArgs(int argc, char* argv[], LoadConfig& config) {
+  for (int i = 1; i < argc; i++) {
+    std::string name = argv[i];
+    if (name == "--binary") {
+      config.binary = true;
+      continue;
+    }
+    if (name == "--in-process") {
+      config.inProcess = true;
+      continue;
+    }
+    if (name == "--insecure") {
+      config.verifySSL = false;
+      continue;
+    }
+    if (name == "--no-http2") {
+      config.http2 = false;
+      continue;
+    }
+    if (name == "--sync") {
+      config.sync = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      std::cerr << "缺少参数值: " << name << "\n";
+      return false;
+    }
+
+    std::string value = argv[++i];
+    if (name == "--url") {
+      config.url = value;
+    } else if (name == "--mode") {
+      config.mode = value;
+    } else if (name == "--rate") {
+      config.rate = std::atof(value.c_str());
+    } else if (name == "--concurrency") {
+      config.concurrency = std::max(1, std::atoi(value.c_str()));
+    } else if (name == "--duration") {
+      config.durationSeconds = std::atof(value.c_str());
+    } else if (name == "--timeout-ms") {
+      config.timeoutMs = std::atol(value.c_str());
+    } else if (name == "--machines") {
+      config.machines = std::max(1, std::atoi(value.c_str()));
+    } else if (name == "--secret") {
+      config.secretKey = value;
+    } else if (name == "--app-secret") {
+      config.appSecret = value;
+    } else if (name == "--hgrm") {
+      config.hgrmFile = value;
+    } else if (name == "--latency-us") {
+      config.inProcessOptions.latencyUs = std::atol(value.c_str());
+    } else if (name == "--jitter-us") {
+      config.inProcessOptions.jitterUs = std::atol(value.c_str());
+    } else if (name == "--runs") {
+      config.runs = std::max(1, std::atoi(value.c_str()));
+    } else if (name == "--startup-delay-ms") {
+      config.startupDelayMs = std::atol(value.c_str());
+    } else if (name == "--seed") {
+      config.inProcessOptions.seed =
+          static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+    } else {
+      std::cerr << "未知参数: " << name << "\n";
+      return false;
+    }
+  }
+
+  if (config.mode != "verify" && config.mode != "request" &&
+      config.mode != "health" && config.mode != "startup") {
+    std::cerr << "未知模式: " << config.mode << "\n";
+    return false;
+  }
+  if (config.sync && config.mode != "verify") {
+    std::cerr << "--sync 只用于 verify 模式\n";
+    return false;
+  }
+  if (config.mode == "startup" && config.inProcess) {
+    std::cerr << "startup 模式测量连接建立，不能与 --in-process 同时使用\n";
+    return false;
+  }
+  return true;
+}
+
+static void printReport(const LoadConfig& config, const LoadStats& stats,
+                        uint64_t sent, double sendSeconds) {
+  uint64_t completed = stats.completed.load();
+  uint64_t errors = stats.errors.load();
+  double elapsedSeconds =
+      std::max(sendSeconds, stats.lastCompletionUs.load() / 1e6);
+  const LatencyHistogram& histogram = stats.latencyUs;
+
+  auto ms = [](int64_t us) { return us / 1000.0; };
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "\n=== 结果（" << config.mode << "，"
+            << (config.sync ? "同步" : config.rate > 0 ? "开环" : "闭环") << "，"
+            << (config.inProcess ? "进程内" : config.url) << "）===\n";
+  std::cout << "已发送:     " << sent << "（"
+            << (sendSeconds > 0 ? sent / sendSeconds : 0.0) << " 次/秒）\n";
+  std::cout << "已完成:     " << completed << "\n";
+  std::cout << "错误:       " << errors << "（"
+            << (completed > 0 ? 100.0 * errors / completed : 0.0) << "%）\n";
+  std::cout << "吞吐量:     "
+            << (elapsedSeconds > 0 ? (completed - errors) / elapsedSeconds : 0.0)
+            << " 次/秒（成功）\n";
+  std::cout << "延迟 (ms):  min " << ms(histogram.min()) << "  mean "
+            << histogram.mean() / 1000.0 << "  p50 "
+            << ms(histogram.valueAtPercentile(50.0)) << "  p90 "
+            << ms(histogram.valueAtPercentile(90.0)) << "  p99 "
+            << ms(histogram.valueAtPercentile(99.0)) << "  p99.9 "
+            << ms(histogram.valueAtPercentile(99.9)) << "  max "
+            << ms(histogram.max()) << "\n";
+  if (!stats.firstError.empty()) {
+    std::cout << "首个错误:   " << stats.firstError << "\n";
+  }
+}
+
+static void printLatencyLine(const char* label, const LatencyHistogram& histogram) {
+  auto ms = [](int64_t us) { return us / 1000.0; };
+  std::cout << label << "min " << ms(histogram.min()) << "  mean "
+            << histogram.mean() / 1000.0 << "  p50 "
+            << ms(histogram.valueAtPercentile(50.0)) << "  p90 "
+            << ms(histogram.valueAtPercentile(90.0)) << "  max "
+            << ms(histogram.max()) << "\n";
+}
+
+// 启动基准：首次验证延迟，冷启动与预热交替进行
+static int runStartupBenchmark(const LoadConfig& config,
+                               const std::string& machineCode,
+                               const std::string& licenseKey) {
+  LatencyHistogram cold;
+  LatencyHistogram warm;
+  int errors = 0;
+  std::string firstError;
+
+  std::cout << "开始: startup，" << config.runs << " 轮，启动延迟 "
+            << config.startupDelayMs << " ms" << std::endl;
+
+  for (int run = 0; run < config.runs * 2; run++) {
+    bool prewarm = run % 2 == 1;
+
+    // 私有事件循环与连接池：每轮都从零开始建立连接
+    HttpClientCpp::Options options;
+    options.headers["User-Agent"] = "license_loadgen/1.0";
+    options.sharedCache = false;
+    options.verifySSL = config.verifySSL;
+    options.http2 = config.http2;
+    options.engine.multiplex = config.http2;
+    auto transport = std::make_shared<CurlHttpTransport>(options);
+
+    LicenseClientCpp client(std::vector<std::string>{config.url}, transport);
+    client.setBinaryWireFormat(config.binary);
+
+    LicenseClientCpp::RetryPolicy retry;
+    retry.maxAttempts = 1;
+    retry.attemptTimeoutMs = config.timeoutMs;
+    retry.totalTimeoutMs = config.timeoutMs;
+    client.setRetryPolicy(retry);
+
+    if (prewarm) {
+      client.prewarm();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(config.startupDelayMs));
+
+    auto start = Clock::now();
+    LicenseClientCpp::VerifyResponse response =
+        client.verifyLicense(machineCode, licenseKey);
+    int64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                            Clock::now() - start)
+                            .count();
+
+    if (!response.valid) {
+      errors++;
+      if (firstError.empty()) {
+        firstError = response.error.empty() ? response.message : response.error;
+      }
+      continue;
+    }
+    (prewarm ? warm : cold).record(elapsedUs);
+  }
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "\n=== 首次验证延迟（" << config.url << "）===\n";
+  printLatencyLine("冷启动 (ms):  ", cold);
+  printLatencyLine("预热后 (ms):  ", warm);
+  std::cout << "错误:         " << errors << "\n";
+  if (!firstError.empty()) {
+    std::cout << "首个错误:     " << firstError << "\n";
+  }
+  return errors == 0 ? 0 : 2;
+}
+
+int main(int argc, char* argv[]) {
+  LoadConfig config;
+  if (!parseArgs(argc, argv, config)) {
+    return 1;
+  }
+
+  SecureTransportCpp::setAppSecret(config.appSecret);
+  LicenseStandIn standIn(config.secretKey);
+
+  // 机器码与期望的许可证密钥（替身服务端按相同规则派生）
+  std::vector<std::string> machineCodes;
+  std::vector<std::string> licenseKeys;
+  for (size_t i = 0; i < config.machines; i++) {
+    machineCodes.push_back(
+        SecureTransportCpp::sha256("loadgen-" + std::to_string(i)));
+    licenseKeys.push_back(standIn.licenseKeyFor(machineCodes.back()));
+  }
+
+  if (config.mode == "startup") {
+    return runStartupBenchmark(config, machineCodes[0], licenseKeys[0]);
+  }
+
+  std::shared_ptr<HttpTransport> transport;
+  if (config.inProcess) {
+    config.inProcessOptions.asyncThreads = std::min<size_t>(
+        config.concurrency, std::max(1u, std::thread::hardware_concurrency()));
+    transport = std::make_shared<InProcessTransport>(
+        [&standIn](const HttpClientCpp::Request& request) {
+          return standIn.handle(request);
+        },
+        config.inProcessOptions);
+  } else {
+    HttpClientCpp::Options options;
+    options.headers["User-Agent"] = "license_loadgen/1.0";
+    options.sharedCache = false;
+    options.verifySSL = config.verifySSL;
+    options.http2 = config.http2;
+    options.engine.multiplex = config.http2;
+    options.engine.maxInFlight = config.concurrency;
+    options.engine.maxQueued = std::numeric_limits<int>::max();
+    transport = std::make_shared<CurlHttpTransport>(options);
+  }
+
+  LicenseClientCpp client(std::vector<std::string>{config.url}, transport);
+  client.setBinaryWireFormat(config.binary);
+
+  // 每个请求只尝试一次，熔断器不打开：错误如实计入统计
+  LicenseClientCpp::RetryPolicy retry;
+  retry.maxAttempts = 1;
+  retry.attemptTimeoutMs = config.timeoutMs;
+  retry.totalTimeoutMs = config.timeoutMs;
+  client.setRetryPolicy(retry);
+
+  CircuitBreaker::Options breaker;
+  breaker.failureThreshold = std::numeric_limits<int>::max();
+  client.setCircuitBreaker(breaker);
+
+  LoadStats stats;
+  Permits permits(config.concurrency);
+  bool closedLoop = config.rate <= 0;
+
+  auto start = Clock::now();
+  auto end = start + std::chrono::microseconds(
+                         static_cast<int64_t>(config.durationSeconds * 1e6));
+
+  auto complete = [&stats, &permits, start, closedLoop](
+                      Clock::time_point intended, bool ok,
+                      const std::string& error) {
+    auto now = Clock::now();
+    stats.latencyUs.record(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - intended)
+            .count());
+    if (!ok) {
+      stats.errors++;
+      std::lock_guard<std::mutex> lock(stats.errorMutex);
+      if (stats.firstError.empty()) stats.firstError = error;
+    }
+
+    int64_t sinceStart =
+        std::chrono::duration_cast<std::chrono::microseconds>(now - start)
+            .count();
+    int64_t last = stats.lastCompletionUs.load();
+    while (sinceStart > last &&
+           !stats.lastCompletionUs.compare_exchange_weak(last, sinceStart)) {
+    }
+
+    stats.completed++;
+    if (closedLoop) permits.release();
+  };
+
+  std::cout << "开始: " << config.mode << "，";
+  if (config.sync) {
+    std::cout << "同步调用方 " << config.concurrency << " 个，持续 "
+              << config.durationSeconds << " 秒" << std::endl;
+
+    // 每个线程轮流使用不同的机器码，相同的验证不会被合并
+    std::atomic<uint64_t> sentCount{0};
+    std::vector<std::thread> callers;
+    for (size_t t = 0; t < config.concurrency; t++) {
+      callers.emplace_back([&, t]() {
+        for (size_t i = t; Clock::now() < end; i += config.concurrency) {
+          size_t machine = i % config.machines;
+          Clock::time_point intended = Clock::now();
+          sentCount++;
+          LicenseClientCpp::VerifyResponse response =
+              client.verifyLicense(machineCodes[machine], licenseKeys[machine]);
+          complete(intended, response.valid,
+                   response.error.empty() ? response.message : response.error);
+        }
+      });
+    }
+    for (std::thread& caller : callers) {
+      caller.join();
+    }
+
+    printReport(config, stats, sentCount.load(),
+                std::chrono::duration<double>(Clock::now() - start).count());
+    return stats.errors.load() == 0 ? 0 : 2;
+  }
+  if (closedLoop) {
+    std::cout << "闭环，并发 " << config.concurrency;
+  } else {
+    std::cout << "开环，" << config.rate << " 次/秒";
+  }
+  std::cout << "，持续 " << config.durationSeconds << " 秒" << std::endl;
+
+  uint64_t sent = 0;
+  while (true) {
+    Clock::time_point intended;
+    if (closedLoop) {
+      permits.acquire();
+      intended = Clock::now();
+      if (intended >= end) {
+        permits.release();
+        break;
+      }
+    } else {
+      // 预定发送时间只由速率决定，与之前的请求是否完成无关
+      intended = start + std::chrono::nanoseconds(
+                             static_cast<int64_t>(sent * 1e9 / config.rate));
+      if (intended >= end) break;
+      std::this_thread::sleep_until(intended);
+    }
+
+    size_t machine = sent % config.machines;
+    if (config.mode == "verify") {
+      client.startVerifyLicense(
+          machineCodes[machine], licenseKeys[machine],
+          [complete, intended](const LicenseClientCpp::VerifyResponse& response) {
+            complete(intended, response.valid,
+                     response.error.empty() ? response.message : response.error);
+          });
+    } else if (config.mode == "request") {
+      client.startRequestLicense(
+          machineCodes[machine], "loadgen",
+          [complete, intended](const LicenseClientCpp::LicenseResponse& response) {
+            complete(intended, response.success,
+                     response.error.empty() ? response.message : response.error);
+          });
+    } else {
+      HttpClientCpp::Request request;
+      request.url = config.url + "/health";
+      transport->sendAsync(
+          request, [complete, intended](const HttpClientCpp::Response& response) {
+            complete(intended, response.success,
+                     response.error.empty() ? std::to_string(response.statusCode)
+                                            : response.error);
+          });
+    }
+    sent++;
+  }
+
+  double sendSeconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  // 等待在途请求完成（每个请求都有时限，必然结束）
+  while (stats.completed.load() < sent) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  printReport(config, stats, sent, sendSeconds);
+
+  if (!config.hgrmFile.empty()) {
+    std::ofstream file(config.hgrmFile);
+    if (!file) {
+      std::cerr << "无法写入 " << config.hgrmFile << "\n";
+      return 1;
+    }
+    stats.latencyUs.writePercentileDistribution(file, 1000.0);
+    std::cout << "延迟分布已写入 " << config.hgrmFile << "\n";
+  }
+  return stats.errors.load() == 0 ? 0 : 2;
+}
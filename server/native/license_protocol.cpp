@@ -0,0 +1,359 @@
+#include "license_protocol.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// 声明支持的请求体格式，客户端据此切换到二进制线格式
+static const char* const kResponseHeaders =
+    "Content-Type: application/json\r\n"
+    "Accept-Post: application/json, application/x-license-packet\r\n";
+
+static std::string toLower(const std::string& value) {
+  std::string lower(value);
+  for (char& c : lower) {
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+  return lower;
+}
+
+// 媒体类型（去掉参数与空白，小写）
+static std::string mimeType(const std::string& contentType) {
+  size_t end = contentType.find(';');
+  std::string type = contentType.substr(0, end);
+  size_t first = type.find_first_not_of(" \t");
+  size_t last = type.find_last_not_of(" \t");
+  if (first == std::string::npos) return "";
+  return toLower(type.substr(first, last - first + 1));
+}
+
+static void appendUtf8(std::string& out, uint32_t codePoint) {
+  if (codePoint < 0x80) {
+    out.push_back(static_cast<char>(codePoint));
+  } else if (codePoint < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+    out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+  } else if (codePoint < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+  }
+}
+
+static bool parseHex4(const std::string& json, size_t pos, size_t end,
+                      uint32_t& value) {
+  if (pos + 4 > end) return false;
+  value = 0;
+  for (size_t i = pos; i < pos + 4; i++) {
+    char c = json[i];
+    value <<= 4;
+    if (c >= '0' && c <= '9') {
+      value |= static_cast<uint32_t>(c - '0');
+    } else if (c >= 'a' && c <= 'f') {
+      value |= static_cast<uint32_t>(c - 'a' + 10);
+    } else if (c >= 'A' && c <= 'F') {
+      value |= static_cast<uint32_t>(c - 'A' + 10);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 整数字段：数字或数字字符串（Python 客户端发送数字，C++ 客户端发送字符串）
+static bool jsonInteger(const std::string& json, const std::string& key,
+                        int64_t& value) {
+  const std::string quotedKey = "\"" + key + "\"";
+  size_t pos = json.find(quotedKey);
+  if (pos == std::string::npos) {
+    value = 0;  // 缺失字段由 verifySecurePacket 报告
+    return true;
+  }
+
+  size_t cursor = json.find_first_not_of(" \t\r\n", pos + quotedKey.size());
+  if (cursor == std::string::npos || json[cursor] != ':') return false;
+  cursor = json.find_first_not_of(" \t\r\n", cursor + 1);
+  if (cursor == std::string::npos) return false;
+
+  std::string text = json[cursor] == '"' ? jsonField(json, key)
+                                         : json.substr(cursor, 20);
+  char* parsedEnd = nullptr;
+  long long parsed = std::strtoll(text.c_str(), &parsedEnd, 10);
+  if (parsedEnd == text.c_str()) return false;
+  value = static_cast<int64_t>(parsed);
+  return true;
+}
+
+// 数据包 JSON（字段超出定长容量时视为格式错误）
+static bool parsePacketJson(const std::string& json, SecurePacketCpp& packet) {
+  size_t first = json.find_first_not_of(" \t\r\n");
+  if (first == std::string::npos || json[first] != '{') return false;
+
+  return packet.machineCode.assign(jsonField(json, "machine_code")) &&
+         packet.nonce.assign(jsonField(json, "nonce")) &&
+         packet.signature.assign(jsonField(json, "signature")) &&
+         jsonInteger(json, "timestamp", packet.timestamp);
+}
+
+// ============================================================================
+// 请求解析
+// ============================================================================
+
+SecureRequestBody readSecureRequest(const HttpClientCpp::Request& request,
+                                    const std::string& extraField) {
+  SecureRequestBody body;
+  std::string type = mimeType(requestHeader(request, "Content-Type"));
+
+  if (type == SecurePacketCpp::kBinaryContentType) {
+    // 定长数据包 + 附加字段的原始 UTF-8 字节
+    if (!SecurePacketCpp::fromBinary(request.body, body.packet)) {
+      return body;
+    }
+    body.supported = true;
+    body.binary = true;
+    body.hasPacket = true;
+    if (!extraField.empty()) {
+      body.extraValue = request.body.substr(SecurePacketCpp::kBinarySize);
+    }
+    return body;
+  }
+
+  if (type != "application/json") {
+    return body;
+  }
+  size_t first = request.body.find_first_not_of(" \t\r\n");
+  if (first == std::string::npos || request.body[first] != '{') {
+    return body;
+  }
+  body.supported = true;
+
+  // JSON 请求中数据包为 Base64 编码的 JSON
+  std::string encoded = jsonField(request.body, "secure_packet");
+  if (!encoded.empty()) {
+    body.hasPacket = true;
+    std::vector<unsigned char> decoded =
+        SecureTransportCpp::base64Decode(encoded);
+    std::string packetJson = decoded.empty()
+                                 ? encoded
+                                 : std::string(decoded.begin(), decoded.end());
+    if (!parsePacketJson(packetJson, body.packet)) {
+      body.packetError = "Invalid JSON format";
+    }
+  } else {
+    body.machineCode = jsonField(request.body, "machine_code");
+  }
+
+  if (!extraField.empty()) {
+    body.extraValue = jsonField(request.body, extraField);
+  }
+  return body;
+}
+
+bool verifySecurePacket(const SecurePacketCpp& packet, int maxAgeSeconds,
+                        std::string& error) {
+  if (packet.machineCode.size() == 0 || packet.timestamp == 0 ||
+      packet.nonce.size() == 0 || packet.signature.size() == 0) {
+    error = "Missing required fields";
+    return false;
+  }
+
+  int64_t now = static_cast<int64_t>(std::time(nullptr));
+  if (now - packet.timestamp > maxAgeSeconds) {
+    error = "Request expired";
+    return false;
+  }
+  if (packet.timestamp > now + kMaxClockSkewSeconds) {
+    error = "Invalid timestamp (future)";
+    return false;
+  }
+
+  if (!packet.verify(maxAgeSeconds)) {
+    error = "Invalid signature";
+    return false;
+  }
+  return true;
+}
+
+HttpClientCpp::Response jsonResponse(int statusCode, const std::string& body) {
+  HttpClientCpp::Response response;
+  response.statusCode = statusCode;
+  response.body = body;
+  response.rawHeaders = kResponseHeaders;
+  response.success = statusCode >= 200 && statusCode < 300;
+  return response;
+}
+
+std::string requestHeader(const HttpClientCpp::Request& request,
+                          const std::string& name) {
+  for (const auto& header : request.headers) {
+    if (header.first.size() != name.size()) continue;
+    bool equal = true;
+    for (size_t i = 0; i < name.size() && equal; i++) {
+      equal = std::tolower(static_cast<unsigned char>(header.first[i])) ==
+              std::tolower(static_cast<unsigned char>(name[i]));
+    }
+    if (equal) return header.second;
+  }
+  return "";
+}
+
+std::string requestPath(const HttpClientCpp::Request& request) {
+  const std::string& url = request.url;
+  size_t start = 0;
+  size_t scheme = url.find("://");
+  if (scheme != std::string::npos) {
+    start = url.find('/', scheme + 3);
+    if (start == std::string::npos) return "/";
+  }
+  size_t end = url.find('?', start);
+  return url.substr(start, end == std::string::npos ? std::string::npos
+                                                    : end - start);
+}
+
+// ============================================================================
+// JSON 工具
+// ============================================================================
+
+std::string jsonField(const std::string& json, const std::string& key,
+                      size_t begin, size_t end) {
+  end = std::min(end, json.size());
+  const std::string quotedKey = "\"" + key + "\"";
+
+  size_t pos = json.find(quotedKey, begin);
+  while (pos != std::string::npos && pos + quotedKey.size() <= end) {
+    // 键之后应为冒号与字符串值
+    size_t cursor = json.find_first_not_of(" \t\r\n", pos + quotedKey.size());
+    if (cursor < end && json[cursor] == ':') {
+      cursor = json.find_first_not_of(" \t\r\n", cursor + 1);
+      if (cursor < end && json[cursor] == '"') {
+        std::string value;
+        for (size_t i = cursor + 1; i < end; i++) {
+          char c = json[i];
+          if (c == '"') return value;
+          if (c != '\\') {
+            value.push_back(c);
+            continue;
+          }
+          if (++i >= end) break;
+          switch (json[i]) {
+            case 'n': value.push_back('\n'); break;
+            case 't': value.push_back('\t'); break;
+            case 'r': value.push_back('\r'); break;
+            case 'b': value.push_back('\b'); break;
+            case 'f': value.push_back('\f'); break;
+            case 'u': {
+              uint32_t codePoint = 0;
+              if (!parseHex4(json, i + 1, end, codePoint)) return "";
+              i += 4;
+              // 代理对
+              uint32_t low = 0;
+              if (codePoint >= 0xD800 && codePoint <= 0xDBFF && i + 2 < end &&
+                  json[i + 1] == '\\' && json[i + 2] == 'u' &&
+                  parseHex4(json, i + 3, end, low) && low >= 0xDC00 &&
+                  low <= 0xDFFF) {
+                codePoint =
+                    0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                i += 6;
+              }
+              appendUtf8(value, codePoint);
+              break;
+            }
+            default: value.push_back(json[i]); break;  // \" \\ \/
+          }
+        }
+        return "";
+      }
+    }
+    pos = json.find(quotedKey, pos + 1);
+  }
+  return "";
+}
+
+size_t jsonObjectEnd(const std::string& json, size_t start) {
+  int depth = 0;
+  bool inString = false;
+  for (size_t i = start; i < json.size(); i++) {
+    char c = json[i];
+    if (inString) {
+      if (c == '\\') {
+        i++;
+      } else if (c == '"') {
+        inString = false;
+      }
+    } else if (c == '"') {
+      inString = true;
+    } else if (c == '{' || c == '[') {
+      depth++;
+    } else if (c == '}' || c == ']') {
+      if (--depth == 0) return c == '}' ? i : std::string::npos;
+    }
+  }
+  return std::string::npos;
+}
+
+std::string jsonString(const std::string& value) {
+  std::string out;
+  out.reserve(value.size() + 2);
+  out.push_back('"');
+  for (char c : value) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x",
+                        static_cast<unsigned char>(c));
+          out += escaped;
+        } else {
+          out.push_back(c);
+        }
+    }
+  }
+  out.push_back('"');
+  return out;
+}
+
+// ============================================================================
+// 时间格式
+// ============================================================================
+
+std::string formatLocalTime(std::time_t time, bool withMicros, long micros) {
+  std::tm local{};
+#ifdef _WIN32
+  localtime_s(&local, &time);
+#else
+  localtime_r(&time, &local);
+#endif
+  char buffer[40];
+  size_t length =
+      std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+  if (withMicros) {
+    std::snprintf(buffer + length, sizeof(buffer) - length, ".%06ld", micros);
+  }
+  return buffer;
+}
+
+bool parseLocalTime(const std::string& text, std::time_t& time) {
+  std::tm local{};
+  if (std::sscanf(text.c_str(), "%d-%d-%d %d:%d:%d", &local.tm_year,
+                  &local.tm_mon, &local.tm_mday, &local.tm_hour, &local.tm_min,
+                  &local.tm_sec) != 6) {
+    return false;
+  }
+  local.tm_year -= 1900;
+  local.tm_mon -= 1;
+  local.tm_isdst = -1;
+  time = std::mktime(&local);
+  return time != static_cast<std::time_t>(-1);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <ctime>
+#include <string>
+
+#include "http_client_cpp.h"
+#include "secure_transport_cpp.h"
+
+// ============================================================================
+// 授权协议的公共部分（原生服务端与授权服务替身共用）
+// 与 secure_license_server.py 的请求/响应格式保持一致
+// ============================================================================
+
+/// <summary>
+/// 请求体中的安全数据包与附加字段
+/// </summary>
+struct SecureRequestBody {
+  bool supported = false;   // Content-Type 受支持（否则应返回 415）
+  bool binary = false;      // 二进制线格式
+  bool hasPacket = false;   // 携带了安全数据包
+  std::string packetError;  // 数据包无法解析时的原因（hasPacket 为 true）
+  SecurePacketCpp packet;
+  std::string extraValue;   // 附加字段（二进制请求为数据包之后的原始字节）
+  std::string machineCode;  // 未携带数据包时的 machine_code 字段（旧版客户端）
+};
+
+/// <summary>
+/// 读取 JSON 或二进制线格式的请求体
+/// </summary>
+/// <param name="extraField">附加字段名（如 license_key），为空表示没有</param>
+SecureRequestBody readSecureRequest(const HttpClientCpp::Request& request,
+                                    const std::string& extraField);
+
+/// <summary>
+/// 允许客户端时钟超前的秒数（防重放缓存的时效窗口随之延长）
+/// </summary>
+static const int kMaxClockSkewSeconds = 60;
+
+/// <summary>
+/// 校验数据包的字段、时间戳（过期或超前 kMaxClockSkewSeconds 以上）与签名
+/// 失败时 error 为与 Python 服务端相同的原因
+/// </summary>
+bool verifySecurePacket(const SecurePacketCpp& packet, int maxAgeSeconds,
+                        std::string& error);
+
+/// <summary>
+/// 带协议公共响应头（Content-Type 与 Accept-Post）的 JSON 响应
+/// </summary>
+HttpClientCpp::Response jsonResponse(int statusCode, const std::string& body);
+
+/// <summary>
+/// 请求头（名称不区分大小写），不存在时返回空串
+/// </summary>
+std::string requestHeader(const HttpClientCpp::Request& request,
+                          const std::string& name);
+
+/// <summary>
+/// 请求 URL 的路径部分（去掉协议、主机与查询串）
+/// </summary>
+std::string requestPath(const HttpClientCpp::Request& request);
+
+/// <summary>
+/// 取出 JSON 对象中的字符串字段（处理转义），不存在时返回空串
+/// 只在 json 的 [begin, end) 范围内查找
+/// </summary>
+std::string jsonField(const std::string& json, const std::string& key,
+                      size_t begin = 0, size_t end = std::string::npos);
+
+/// <summary>
+/// 从 start 处的 '{' 找到与之匹配的 '}'（跳过字符串与转义），
+/// 不完整或括号不匹配时返回 npos
+/// </summary>
+size_t jsonObjectEnd(const std::string& json, size_t start);
+
+/// <summary>
+/// 转义为 JSON 字符串字面量（含两侧引号）
+/// </summary>
+std::string jsonString(const std::string& value);
+
+/// <summary>
+/// 本地时间 "YYYY-MM-DD HH:MM:SS"，withMicros 时附加 ".ffffff"
+/// （与 Python datetime 写入 SQLite 的格式一致）
+/// </summary>
+std::string formatLocalTime(std::time_t time, bool withMicros = false,
+                            long micros = 0);
+
+/// <summary>
+/// 解析 "YYYY-MM-DD HH:MM:SS[.ffffff]"（本地时间），失败返回 false
+/// </summary>
+bool parseLocalTime(const std::string& text, std::time_t& time);
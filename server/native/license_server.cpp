@@ -0,0 +1,267 @@
+// 原生授权服务器（Linux）
+// 与 secure_license_server.py 的接口和数据库兼容：epoll 反应器线程负责网络 I/O，
+// 工作线程池执行 LicenseService（每个工作线程一个 SQLite 连接）
+//
+// 用法: license_server [--port 5000] [--bind 0.0.0.0] [--db licenses.db]
+//                      [--workers N] [--secret 服务端密钥] [--app-secret 应用密钥]
+//                      [--no-index] [--index-reload 秒]
+//                      [--nonce-rate 每秒数据包数]
+//                      [--no-rate-limit] [--sync-logs]
+//
+// SIGHUP 立即从数据库重建许可证索引
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "http_reactor.h"
+#include "license_index.h"
+#include "license_service.h"
+#include "nonce_cache.h"
+#include "secure_transport_cpp.h"
+#include "verify_log_writer.h"
+
+static HttpReactor* g_reactor = nullptr;
+static std::atomic<bool> g_reloadIndex{false};
+
+static void onSignal(int) {
+  if (g_reactor) g_reactor->stop();
+}
+
+static void onReloadSignal(int) { g_reloadIndex = true; }
+
+/// <summary>
+/// 定期（或收到 SIGHUP 时）从数据库重建许可证索引，
+/// 使其他进程的吊销与删除在 intervalSeconds 内生效（0 表示只响应 SIGHUP）
+/// </summary>
+class IndexReloader {
+ public:
+  IndexReloader(LicenseIndex& index, const std::string& databasePath,
+                int intervalSeconds)
+      : m_index(index),
+        m_databasePath(databasePath),
+        m_intervalSeconds(intervalSeconds),
+        m_thread(&IndexReloader::run, this) {}
+
+  ~IndexReloader() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+  }
+
+ private:
+  LicenseIndex& m_index;
+  std::string m_databasePath;
+  int m_intervalSeconds;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  bool m_stopping = false;
+  std::thread m_thread;  // 最后初始化：其他成员就绪后才启动
+
+  void run() {
+    LicenseStore store;
+    std::string error;
+    if (!store.open(m_databasePath, error)) {
+      std::cerr << "[ERROR] 索引重建线程打开数据库失败: " << error << std::endl;
+      return;
+    }
+
+    auto last = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+      // 每秒检查一次 SIGHUP 标记（信号处理函数中不能通知条件变量）
+      m_wake.wait_for(lock, std::chrono::seconds(1));
+      if (m_stopping) break;
+
+      auto now = std::chrono::steady_clock::now();
+      bool due = m_intervalSeconds > 0 &&
+                 now - last >= std::chrono::seconds(m_intervalSeconds);
+      if (!g_reloadIndex.exchange(false) && !due) continue;
+      last = now;
+
+      lock.unlock();
+      if (!m_index.reload(store, error)) {
+        std::cerr << "[WARNING] 重建许可证索引失败: " << error << std::endl;
+      }
+      lock.lock();
+    }
+  }
+};
+
+int main(int argc, char* argv[]) {
+  HttpReactor::Options reactorOptions;
+  LicenseService::Options serviceOptions;
+  std::string appSecret = "DEFAULT_APP_SECRET_2026_CHANGE_THIS";
+  bool useIndex = true;
+  int indexReloadSeconds = 60;
+  bool useRateLimit = true;
+  bool batchLogs = true;
+  NonceCache::Options nonceOptions;
+  nonceOptions.expectedRate = 0;  // 按工作线程数确定
+
+  for (int i = 1; i < argc; i += 2) {
+    std::string name = argv[i];
+    if (name == "--no-index") {
+      useIndex = false;
+      i--;  // 无参数值
+    } else if (name == "--no-rate-limit") {
+      useRateLimit = false;
+      i--;
+    } else if (name == "--sync-logs") {
+      batchLogs = false;
+      i--;
+    } else if (i + 1 >= argc) {
+      std::cerr << "参数缺少值: " << name << "\n";
+      return 1;
+    } else if (name == "--port") {
+      reactorOptions.port = std::atoi(argv[i + 1]);
+    } else if (name == "--bind") {
+      reactorOptions.bindAddress = argv[i + 1];
+    } else if (name == "--db") {
+      serviceOptions.databasePath = argv[i + 1];
+    } else if (name == "--index-reload") {
+      indexReloadSeconds = std::atoi(argv[i + 1]);
+    } else if (name == "--workers") {
+      reactorOptions.workers = std::atoi(argv[i + 1]);
+    } else if (name == "--nonce-rate") {
+      nonceOptions.expectedRate = std::strtoul(argv[i + 1], nullptr, 10);
+    } else if (name == "--secret") {
+      serviceOptions.secretKey = argv[i + 1];
+    } else if (name == "--app-secret") {
+      appSecret = argv[i + 1];
+    } else {
+      std::cerr << "未知参数: " << name << "\n";
+      return 1;
+    }
+  }
+
+  SecureTransportCpp::setAppSecret(appSecret);
+
+  // 先在主线程打开一次：创建表结构，数据库不可用时立即退出
+  std::string error;
+  {
+    LicenseService service(serviceOptions);
+    if (!service.open(error)) {
+      std::cerr << "打开数据库 " << serviceOptions.databasePath
+                << " 失败: " << error << "\n";
+      return 1;
+    }
+  }
+
+  // 许可证索引：验证时不再查询数据库
+  std::unique_ptr<LicenseIndex> index;
+  if (useIndex) {
+    auto loadStart = std::chrono::steady_clock::now();
+    index.reset(new LicenseIndex());
+    LicenseStore store;
+    if (!store.open(serviceOptions.databasePath, error) ||
+        !index->load(store, error)) {
+      std::cerr << "加载许可证索引失败: " << error << "\n";
+      return 1;
+    }
+    auto loadMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now() - loadStart)
+                      .count();
+    std::cout << "许可证索引: " << index->size() << " 条，加载耗时 " << loadMs
+              << " ms" << std::endl;
+  }
+
+  // 防重放缓存：容量按预期速率 × 数据包时效窗口预先分配，
+  // 未指定 --nonce-rate 时按工作线程数估计速率
+  nonceOptions.maxAgeSeconds = serviceOptions.maxRequestAge;
+  if (nonceOptions.expectedRate == 0) {
+    int workers = reactorOptions.workers > 0
+                      ? reactorOptions.workers
+                      : static_cast<int>(std::thread::hardware_concurrency());
+    nonceOptions.expectedRate =
+        static_cast<size_t>(std::max(1, workers)) * NonceCache::kRatePerWorker;
+  }
+  NonceCache nonces(nonceOptions);
+
+  // 按客户端 IP 限流（负载测试时用 --no-rate-limit 关闭）
+  LicenseRateLimits limits;
+
+  // 验证日志由后台线程批量提交（--sync-logs 恢复每次验证一个写事务）
+  // 声明在反应器之前：工作线程全部退出后才提交剩余日志
+  VerifyLogWriter::Options logOptions;
+  logOptions.databasePath = serviceOptions.databasePath;
+  VerifyLogWriter logs(logOptions);
+  if (batchLogs && !logs.open(error)) {
+    std::cerr << "打开验证日志写入连接失败: " << error << "\n";
+    return 1;
+  }
+
+  LicenseService::Shared shared;
+  shared.index = index.get();
+  shared.nonces = &nonces;
+  shared.limits = useRateLimit ? &limits : nullptr;
+  shared.logs = batchLogs ? &logs : nullptr;
+
+  HttpReactor reactor(reactorOptions, [serviceOptions, shared] {
+    auto service = std::make_shared<LicenseService>(serviceOptions, shared);
+    std::string openError;
+    if (!service->open(openError)) {
+      std::cerr << "[ERROR] 工作线程打开数据库失败: " << openError << std::endl;
+    }
+    return [service](const HttpClientCpp::Request& request,
+                     const std::string& clientIp) {
+      return service->handle(request, clientIp);
+    };
+  });
+
+  if (!reactor.start(error)) {
+    std::cerr << "监听 " << reactorOptions.bindAddress << ":"
+              << reactorOptions.port << " 失败: " << error << "\n";
+    return 1;
+  }
+
+  g_reactor = &reactor;
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  signal(SIGHUP, onReloadSignal);
+
+  std::unique_ptr<IndexReloader> reloader;
+  if (index) {
+    reloader.reset(new IndexReloader(*index, serviceOptions.databasePath,
+                                     indexReloadSeconds));
+  }
+
+  std::cout << "============================================================\n"
+            << "原生授权服务器已启动\n"
+            << "============================================================\n"
+            << "Listen: http://" << reactorOptions.bindAddress << ":"
+            << reactorOptions.port << "/api\n"
+            << "Database: " << serviceOptions.databasePath << "\n"
+            << "Request Age Limit: " << serviceOptions.maxRequestAge << "s\n"
+            << "Replay Cache: " << nonces.memoryBytes() / (1024 * 1024)
+            << " MiB (" << nonceOptions.expectedRate << " packets/s)\n"
+            << "============================================================"
+            << std::endl;
+
+  reactor.run();
+  g_reactor = nullptr;
+  reloader.reset();
+
+  uint64_t unlimited = limits.request.unlimitedCount() +
+                       limits.verify.unlimitedCount() +
+                       limits.verifyBatch.unlimitedCount() +
+                       limits.info.unlimitedCount();
+  if (unlimited > 0) {
+    std::cout << "限流表并发替换时放行的请求: " << unlimited << std::endl;
+  }
+
+  std::cout << "授权服务器已停止" << std::endl;
+  return 0;
+}
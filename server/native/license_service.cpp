@@ -0,0 +1,463 @@
+#include "license_service.h"
+
+#include <chrono>
+#include <ctime>
+#include <exception>
+#include <utility>
+#include <vector>
+
+#include "license_protocol.h"
+#include "secure_transport_cpp.h"
+
+static std::string trim(const std::string& value) {
+  size_t first = value.find_first_not_of(" \t\r\n");
+  if (first == std::string::npos) return "";
+  size_t last = value.find_last_not_of(" \t\r\n");
+  return value.substr(first, last - first + 1);
+}
+
+// 常量时间比较（不因前缀匹配长度泄露时间信息）
+static bool constantTimeEquals(const std::string& a, const std::string& b) {
+  if (a.size() != b.size()) return false;
+  unsigned char diff = 0;
+  for (size_t i = 0; i < a.size(); i++) {
+    diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+  }
+  return diff == 0;
+}
+
+static std::string nullableString(bool present, const std::string& value) {
+  return present ? jsonString(value) : "null";
+}
+
+// 日志中只保留机器码前 16 位
+static std::string machineSummary(const std::string& machineCode) {
+  return "Machine: " + machineCode.substr(0, 16) + "...";
+}
+
+// 当前时间（秒）与微秒部分
+static std::time_t currentTime(long& micros) {
+  auto now = std::chrono::system_clock::now();
+  micros = static_cast<long>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          now.time_since_epoch())
+          .count() %
+      1000000);
+  return std::chrono::system_clock::to_time_t(now);
+}
+
+static HttpClientCpp::Response failure(int statusCode, const char* resultField,
+                                       const std::string& message) {
+  return jsonResponse(statusCode, std::string("{\"") + resultField +
+                                      "\":false,\"message\":" +
+                                      jsonString(message) + "}");
+}
+
+static HttpClientCpp::Response unsupportedMediaType() {
+  return jsonResponse(415,
+                      "{\"success\":false,\"valid\":false,"
+                      "\"message\":\"Unsupported Content-Type\"}");
+}
+
+// ============================================================================
+// LicenseService 实现
+// ============================================================================
+
+LicenseService::LicenseService(const Options& options)
+    : LicenseService(options, Shared()) {}
+
+LicenseService::LicenseService(const Options& options, const Shared& shared)
+    : m_options(options), m_shared(shared) {}
+
+bool LicenseService::open(std::string& error) {
+  return m_store.open(m_options.databasePath, error);
+}
+
+std::string LicenseService::licenseKeyFor(
+    const std::string& machineCode) const {
+  return SecureTransportCpp::sha256(machineCode + m_options.secretKey);
+}
+
+HttpClientCpp::Response LicenseService::handle(
+    const HttpClientCpp::Request& request, const std::string& clientIp) {
+  std::string path = requestPath(request);
+
+  try {
+    if (path == "/api/health") {
+      if (request.method != "GET") {
+        return failure(405, "success", "Method not allowed");
+      }
+      long micros = 0;
+      std::time_t now = currentTime(micros);
+      std::string timestamp = formatLocalTime(now, true, micros);
+      timestamp[10] = 'T';  // ISO 8601
+      return jsonResponse(200, "{\"status\":\"ok\",\"timestamp\":\"" +
+                                   timestamp + "\",\"security\":\"enabled\"}");
+    }
+
+    HttpClientCpp::Response (LicenseService::*handler)(
+        const HttpClientCpp::Request&, const std::string&) = nullptr;
+    LicenseRateLimits* limits = m_shared.limits;
+    RateLimiter* limiter = nullptr;
+    if (path == "/api/license/request") {
+      handler = &LicenseService::handleRequest;
+      limiter = limits ? &limits->request : nullptr;
+    } else if (path == "/api/license/verify") {
+      handler = &LicenseService::handleVerify;
+      limiter = limits ? &limits->verify : nullptr;
+    } else if (path == "/api/license/verify_batch") {
+      handler = &LicenseService::handleVerifyBatch;
+      limiter = limits ? &limits->verifyBatch : nullptr;
+    } else if (path == "/api/license/info") {
+      handler = &LicenseService::handleInfo;
+      limiter = limits ? &limits->info : nullptr;
+    } else {
+      return failure(404, "success", "Not found");
+    }
+
+    if (request.method != "POST") {
+      return failure(405, "success", "Method not allowed");
+    }
+    if (limiter && !limiter->allow(clientIp)) {
+      return failure(429, "success",
+                     "Too many requests. Please try again later.");
+    }
+    return (this->*handler)(request, clientIp);
+  } catch (const std::exception& e) {
+    logSecurityEvent("SERVER_ERROR", clientIp, e.what());
+    return failure(500, "success", "Server error");
+  }
+}
+
+bool LicenseService::checkPacket(const SecurePacketCpp& packet,
+                                 std::string& error) {
+  if (!verifySecurePacket(packet, m_options.maxRequestAge, error)) {
+    return false;
+  }
+  if (!m_shared.nonces) return true;
+
+  switch (m_shared.nonces->check(packet)) {
+    case NonceCache::Fresh:
+      return true;
+    case NonceCache::Replay:
+      error = "Replay detected";
+      return false;
+    case NonceCache::Full:
+    default:
+      error = "Replay cache full";
+      return false;
+  }
+}
+
+std::string LicenseService::checkLicense(const std::string& machineCode,
+                                         const std::string& licenseKey,
+                                         std::string& message,
+                                         std::string& expiresAt) {
+  if (machineCode.empty()) {
+    return evaluate(nullptr, message);
+  }
+
+  // 索引只用于确认有效的许可证；未命中、密钥不符、过期或需要状态文本时以
+  // 数据库为准（其他进程签发或续期的许可证、重建索引期间签发的许可证）
+  LicenseIndex* index = m_shared.index;
+  if (index) {
+    LicenseIndexEntry entry;
+    if (index->find(machineCode, entry) && entry.keyMatches(licenseKey) &&
+        !entry.has(LicenseIndexEntry::kNeedsRecord)) {
+      long micros = 0;
+      std::time_t now = currentTime(micros);
+      bool hasExpiry = entry.has(LicenseIndexEntry::kHasExpiry);
+      if (!hasExpiry ||
+          LicenseIndex::packLocalTime(now, micros) <= entry.expiresAt) {
+        message = "License is valid";
+        expiresAt = hasExpiry ? jsonString(entry.expiresAtText()) : "null";
+        return "success";
+      }
+    }
+  }
+
+  LicenseRecord record;
+  bool found = m_store.find(machineCode, record);
+  if (found && index) index->put(record);
+  found = found && constantTimeEquals(record.licenseKey, licenseKey);
+  std::string result = evaluate(found ? &record : nullptr, message);
+  if (result == "success") {
+    expiresAt = nullableString(record.hasExpiresAt, record.expiresAt);
+  }
+  return result;
+}
+
+void LicenseService::logSecurityEvent(const std::string& eventType,
+                                      const std::string& clientIp,
+                                      const std::string& details) {
+  if (m_shared.logs) {
+    m_shared.logs->logSecurityEvent(eventType, clientIp, details);
+  } else {
+    m_store.logSecurityEvent(eventType, clientIp, details);
+  }
+}
+
+void LicenseService::recordVerify(const std::string& machineCode,
+                                  const std::string& result,
+                                  const std::string& clientIp,
+                                  const std::string& verifiedAt) {
+  if (m_shared.logs) {
+    m_shared.logs->logVerify(machineCode, result, clientIp, verifiedAt);
+    return;
+  }
+  if (result == "success") {
+    m_store.markVerified(machineCode, verifiedAt);
+  }
+  m_store.logVerify(machineCode, result, clientIp, verifiedAt);
+}
+
+std::string LicenseService::evaluate(const LicenseRecord* record,
+                                     std::string& message) {
+  if (record == nullptr) {
+    message = "License not found";
+    return "not_found";
+  }
+
+  if (record->status != "active") {
+    message = "License is " + record->status;
+    return "inactive";
+  }
+
+  std::time_t expiresAt = 0;
+  if (record->hasExpiresAt && parseLocalTime(record->expiresAt, expiresAt) &&
+      std::time(nullptr) > expiresAt) {
+    message = "License has expired";
+    return "expired";
+  }
+
+  message = "License is valid";
+  return "success";
+}
+
+HttpClientCpp::Response LicenseService::handleRequest(
+    const HttpClientCpp::Request& request, const std::string& clientIp) {
+  SecureRequestBody body = readSecureRequest(request, "user_info");
+  if (!body.supported) {
+    return unsupportedMediaType();
+  }
+
+  if (!body.hasPacket) {
+    logSecurityEvent("INVALID_REQUEST", clientIp, "Missing secure_packet");
+    return failure(400, "success", "Invalid request format");
+  }
+
+  std::string error = body.packetError;
+  if (error.empty()) {
+    checkPacket(body.packet, error);
+  }
+  if (!error.empty()) {
+    logSecurityEvent("VERIFICATION_FAILED", clientIp, "Error: " + error);
+    return failure(403, "success", "Security verification failed: " + error);
+  }
+
+  std::string machineCode = body.packet.machineCode.str();
+  std::string licenseKey = licenseKeyFor(machineCode);
+
+  // 数据库中的过期时间带微秒（与 Python datetime 的写入格式一致）
+  long micros = 0;
+  std::time_t expires =
+      currentTime(micros) +
+      static_cast<std::time_t>(m_options.licenseDays) * 24 * 3600;
+
+  bool renewed = false;
+  if (!m_store.issue(machineCode, licenseKey, body.extraValue,
+                     formatLocalTime(expires, true, micros), renewed)) {
+    return failure(500, "success", "Server error");
+  }
+  if (m_shared.index) {
+    LicenseRecord record;
+    record.machineCode = machineCode;
+    record.licenseKey = licenseKey;
+    record.status = "active";
+    record.expiresAt = formatLocalTime(expires, true, micros);
+    record.hasExpiresAt = true;
+    m_shared.index->put(record);
+  }
+  logSecurityEvent("LICENSE_ISSUED", clientIp, machineSummary(machineCode));
+
+  std::string message = renewed ? "License renewed successfully"
+                                : "License generated successfully";
+  return jsonResponse(200, "{\"success\":true,\"license_key\":\"" + licenseKey +
+                               "\",\"message\":" + jsonString(message) +
+                               ",\"expires_at\":\"" + formatLocalTime(expires) +
+                               "\"}");
+}
+
+HttpClientCpp::Response LicenseService::handleVerify(
+    const HttpClientCpp::Request& request, const std::string& clientIp) {
+  SecureRequestBody body = readSecureRequest(request, "license_key");
+  if (!body.supported) {
+    return unsupportedMediaType();
+  }
+
+  std::string machineCode;
+  if (body.hasPacket) {
+    std::string error = body.packetError;
+    if (error.empty()) {
+      checkPacket(body.packet, error);
+    }
+    if (!error.empty()) {
+      logSecurityEvent("VERIFY_FAILED", clientIp, "Error: " + error);
+      return failure(403, "valid", "Security verification failed: " + error);
+    }
+    machineCode = body.packet.machineCode.str();
+  } else {
+    // 兼容旧版本（不推荐）
+    machineCode = trim(body.machineCode);
+  }
+
+  std::string licenseKey = trim(body.extraValue);
+  if (machineCode.empty() || licenseKey.empty()) {
+    return failure(400, "valid", "Missing required parameters");
+  }
+
+  std::string message;
+  std::string expiresAt;
+  std::string result =
+      checkLicense(machineCode, licenseKey, message, expiresAt);
+
+  VerifyLogWriter* logs = m_shared.logs;
+  if (!logs) m_store.begin();
+  recordVerify(machineCode, result, clientIp, LicenseStore::currentTimestamp());
+  if (result == "not_found") {
+    logSecurityEvent("VERIFY_NOT_FOUND", clientIp, machineSummary(machineCode));
+  }
+  if (!logs) m_store.commit();
+
+  if (result != "success") {
+    return failure(200, "valid", message);
+  }
+  return jsonResponse(200, "{\"valid\":true,\"message\":\"License is valid\","
+                           "\"expires_at\":" +
+                               expiresAt + "}");
+}
+
+HttpClientCpp::Response LicenseService::handleVerifyBatch(
+    const HttpClientCpp::Request& request, const std::string& clientIp) {
+  SecureRequestBody body = readSecureRequest(request, "");
+  if (!body.supported || body.binary) {
+    return unsupportedMediaType();
+  }
+
+  // items 数组中的 {machine_code, license_key} 对象
+  std::vector<std::pair<std::string, std::string>> pairs;
+  const std::string& json = request.body;
+  size_t pos = json.find("\"items\"");
+  pos = pos == std::string::npos ? pos : json.find('[', pos);
+  while (pos != std::string::npos && pairs.size() <= m_options.maxBatchSize) {
+    size_t objectStart = json.find_first_of("{]", pos + 1);
+    if (objectStart == std::string::npos || json[objectStart] == ']') break;
+    // 值中可能含有 '}'：按字符串与转义找到对象的结尾
+    size_t objectEnd = jsonObjectEnd(json, objectStart);
+    if (objectEnd == std::string::npos) break;
+
+    pairs.emplace_back(
+        trim(jsonField(json, "machine_code", objectStart, objectEnd)),
+        trim(jsonField(json, "license_key", objectStart, objectEnd)));
+    pos = objectEnd;
+  }
+
+  if (pairs.empty() || pairs.size() > m_options.maxBatchSize) {
+    return failure(400, "success",
+                   "items must contain 1-" +
+                       std::to_string(m_options.maxBatchSize) + " entries");
+  }
+
+  if (!body.hasPacket) {
+    return failure(400, "success", "Invalid request format");
+  }
+
+  // 数据包的机器码字段为全部条目的摘要，签名因此覆盖整个批次
+  std::string error = body.packetError;
+  if (error.empty() &&
+      checkPacket(body.packet, error)) {
+    std::string canonical;
+    canonical.reserve(pairs.size() * 130);
+    for (const auto& pair : pairs) {
+      canonical += pair.first + ":" + pair.second + "\n";
+    }
+    if (!constantTimeEquals(body.packet.machineCode.str(),
+                            SecureTransportCpp::sha256(canonical))) {
+      error = "Batch digest mismatch";
+    }
+  }
+  if (!error.empty()) {
+    logSecurityEvent("VERIFY_BATCH_FAILED", clientIp, "Error: " + error);
+    return failure(403, "success", "Security verification failed: " + error);
+  }
+
+  std::string results;
+  results.reserve(pairs.size() * 96);
+  std::string verifiedAt = LicenseStore::currentTimestamp();
+  if (!m_shared.logs) m_store.begin();
+  for (size_t i = 0; i < pairs.size(); i++) {
+    const std::string& machineCode = pairs[i].first;
+
+    std::string message;
+    std::string expiresAt;
+    std::string result =
+        checkLicense(machineCode, pairs[i].second, message, expiresAt);
+
+    if (i > 0) results += ",";
+    results += "{\"valid\":";
+    results += result == "success" ? "true" : "false";
+    results += ",\"message\":" + jsonString(message);
+    if (result == "success") {
+      results += ",\"expires_at\":" + expiresAt;
+    }
+    results += "}";
+
+    recordVerify(machineCode, result, clientIp, verifiedAt);
+  }
+  if (!m_shared.logs) m_store.commit();
+
+  return jsonResponse(200, "{\"success\":true,\"results\":[" + results + "]}");
+}
+
+HttpClientCpp::Response LicenseService::handleInfo(
+    const HttpClientCpp::Request& request, const std::string& /*clientIp*/) {
+  SecureRequestBody body = readSecureRequest(request, "");
+  if (!body.supported) {
+    return unsupportedMediaType();
+  }
+
+  std::string machineCode;
+  if (body.hasPacket) {
+    std::string error = body.packetError;
+    if (error.empty()) {
+      checkPacket(body.packet, error);
+    }
+    if (!error.empty()) {
+      return failure(403, "success", "Security verification failed: " + error);
+    }
+    machineCode = body.packet.machineCode.str();
+  } else {
+    machineCode = trim(body.machineCode);
+  }
+
+  if (machineCode.empty()) {
+    return failure(400, "success", "Machine code is required");
+  }
+
+  LicenseRecord record;
+  if (!m_store.find(machineCode, record)) {
+    return failure(200, "success", "License not found");
+  }
+
+  return jsonResponse(
+      200, "{\"success\":true,\"license_info\":{\"status\":" +
+               jsonString(record.status) + ",\"user_info\":" +
+               nullableString(record.hasUserInfo, record.userInfo) +
+               ",\"created_at\":" +
+               nullableString(record.hasCreatedAt, record.createdAt) +
+               ",\"expires_at\":" +
+               nullableString(record.hasExpiresAt, record.expiresAt) +
+               ",\"last_verified\":" +
+               nullableString(record.hasLastVerified, record.lastVerified) +
+               "}}");
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <string>
+
+#include "http_client_cpp.h"
+#include "license_index.h"
+#include "license_store.h"
+#include "nonce_cache.h"
+#include "rate_limiter.h"
+#include "verify_log_writer.h"
+
+/// <summary>
+/// 各接口按客户端 IP 的限流（与 secure_license_server.py 的 rate_limit 一致）
+/// </summary>
+struct LicenseRateLimits {
+  RateLimiter request{{10, 3600}};
+  RateLimiter verify{{100, 3600}};
+  RateLimiter verifyBatch{{100, 3600}};
+  RateLimiter info{{50, 3600}};
+};
+
+/// <summary>
+/// 授权服务的接口实现（与 secure_license_server.py 的协议一致）
+/// /api/health、/api/license/request、/verify、/verify_batch、/info
+/// 每个实例持有自己的数据库连接，只能由一个线程使用（每个工作线程一个实例）
+/// </summary>
+class LicenseService {
+ public:
+  struct Options {
+    std::string databasePath = "licenses.db";
+    std::string secretKey = "DEFAULT_SECRET_KEY_2026";  // 派生许可证密钥
+    int maxRequestAge = 300;     // 数据包最大时效（秒）
+    size_t maxBatchSize = 1000;  // 批量验证单次最多条目数
+    int licenseDays = 365;       // 新签发许可证的有效期（天）
+  };
+
+  /// <summary>
+  /// 所有工作线程共享的组件，均可为空：
+  /// index 为空时验证直接查询数据库，nonces 为空时不检测重放，
+  /// limits 为空时不限流，logs 为空时验证日志在请求内同步写入
+  /// </summary>
+  struct Shared {
+    LicenseIndex* index = nullptr;
+    NonceCache* nonces = nullptr;
+    LicenseRateLimits* limits = nullptr;
+    VerifyLogWriter* logs = nullptr;
+  };
+
+  explicit LicenseService(const Options& options);
+  LicenseService(const Options& options, const Shared& shared);
+
+  /// <summary>
+  /// 打开数据库，失败时返回 false 并设置 error
+  /// </summary>
+  bool open(std::string& error);
+
+  /// <summary>
+  /// 处理一个请求，clientIp 用于日志
+  /// </summary>
+  HttpClientCpp::Response handle(const HttpClientCpp::Request& request,
+                                 const std::string& clientIp);
+
+  /// <summary>
+  /// 机器码对应的许可证密钥：SHA256(机器码 + 服务端密钥) 的十六进制
+  /// </summary>
+  std::string licenseKeyFor(const std::string& machineCode) const;
+
+ private:
+  Options m_options;
+  LicenseStore m_store;
+  Shared m_shared;
+
+  HttpClientCpp::Response handleRequest(const HttpClientCpp::Request& request,
+                                        const std::string& clientIp);
+  HttpClientCpp::Response handleVerify(const HttpClientCpp::Request& request,
+                                       const std::string& clientIp);
+  HttpClientCpp::Response handleVerifyBatch(
+      const HttpClientCpp::Request& request, const std::string& clientIp);
+  HttpClientCpp::Response handleInfo(const HttpClientCpp::Request& request,
+                                     const std::string& clientIp);
+
+  // 校验数据包（字段、时间戳、签名）并检测重放
+  bool checkPacket(const SecurePacketCpp& packet, std::string& error);
+
+  // 查找并检查许可证（优先使用索引），返回结果代码
+  // 成功时 expiresAt 为 JSON 值（字符串或 null）
+  std::string checkLicense(const std::string& machineCode,
+                           const std::string& licenseKey, std::string& message,
+                           std::string& expiresAt);
+
+  // 记录安全事件：有 logs 时入队，否则同步写入本连接
+  // （失败的数据包可由任何人触发，不能在工作线程上占用写事务）
+  void logSecurityEvent(const std::string& eventType,
+                        const std::string& clientIp,
+                        const std::string& details);
+
+  // 记录一次验证（last_verified 与 verify_logs）：有 logs 时入队，
+  // 否则写入本连接，由调用方包在事务中
+  void recordVerify(const std::string& machineCode, const std::string& result,
+                    const std::string& clientIp,
+                    const std::string& verifiedAt);
+
+  // 检查许可证记录的状态与有效期，返回结果代码并设置提示信息
+  static std::string evaluate(const LicenseRecord* record,
+                              std::string& message);
+};
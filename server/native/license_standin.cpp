@@ -0,0 +1,100 @@
+#include "license_standin.h"
+
+#include <ctime>
+
+#include "license_protocol.h"
+
+// 许可证有效期（与 Python 服务端一致）
+static const int kLicenseDays = 365;
+
+// 数据包最大时效（秒）
+static const int kMaxRequestAge = 300;
+
+// ============================================================================
+// LicenseStandIn 实现
+// ============================================================================
+
+LicenseStandIn::LicenseStandIn(const std::string& secretKey)
+    : m_secretKey(secretKey) {}
+
+std::string LicenseStandIn::licenseKeyFor(const std::string& machineCode) const {
+  return SecureTransportCpp::sha256(machineCode + m_secretKey);
+}
+
+HttpClientCpp::Response LicenseStandIn::handle(
+    const HttpClientCpp::Request& request) const {
+  std::string path = requestPath(request);
+
+  if (path == "/api/health") {
+    return jsonResponse(200, "{\"status\":\"ok\",\"security\":\"enabled\"}");
+  }
+
+  // 各接口的结果字段名与附加字段
+  std::string resultField;
+  std::string extraField;
+  if (path == "/api/license/request") {
+    resultField = "success";
+    extraField = "user_info";
+  } else if (path == "/api/license/verify") {
+    resultField = "valid";
+    extraField = "license_key";
+  } else if (path == "/api/license/info") {
+    resultField = "success";
+  } else {
+    return jsonResponse(404, "{\"success\":false,\"message\":\"Not found\"}");
+  }
+
+  if (request.method != "POST") {
+    return jsonResponse(
+        405, "{\"" + resultField + "\":false,\"message\":\"Method not allowed\"}");
+  }
+
+  SecureRequestBody body = readSecureRequest(request, extraField);
+  if (!body.supported) {
+    return jsonResponse(415, "{\"" + resultField +
+                                 "\":false,\"message\":\"Unsupported Content-Type\"}");
+  }
+  if (!body.hasPacket) {
+    return jsonResponse(400, "{\"" + resultField +
+                                 "\":false,\"message\":\"Invalid request format\"}");
+  }
+
+  std::string error = body.packetError;
+  if (error.empty()) {
+    verifySecurePacket(body.packet, kMaxRequestAge, error);
+  }
+  if (!error.empty()) {
+    return jsonResponse(403, "{\"" + resultField +
+                                 "\":false,\"message\":" +
+                                 jsonString("Security verification failed: " + error) +
+                                 "}");
+  }
+
+  std::string machineCode = body.packet.machineCode.str();
+  std::string licenseKey = licenseKeyFor(machineCode);
+  std::string expiresAt =
+      formatLocalTime(std::time(nullptr) + kLicenseDays * 24 * 3600);
+
+  if (path == "/api/license/request") {
+    return jsonResponse(200, "{\"success\":true,\"license_key\":\"" + licenseKey +
+                                 "\",\"message\":\"License generated "
+                                 "successfully\",\"expires_at\":\"" +
+                                 expiresAt + "\"}");
+  }
+
+  if (path == "/api/license/verify") {
+    if (body.extraValue != licenseKey) {
+      return jsonResponse(200,
+                          "{\"valid\":false,\"message\":\"License not found\"}");
+    }
+    return jsonResponse(200,
+                        "{\"valid\":true,\"message\":\"License is valid\","
+                        "\"expires_at\":\"" +
+                            expiresAt + "\"}");
+  }
+
+  return jsonResponse(200,
+                      "{\"success\":true,\"license_info\":{\"status\":\"active\","
+                      "\"user_info\":\"\",\"created_at\":\"\",\"expires_at\":\"" +
+                          expiresAt + "\",\"last_verified\":\"\"}}");
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+#include "http_client_cpp.h"
+
+/// <summary>
+/// 授权服务的最小替身（无状态，不访问数据库）
+/// 按 secure_license_server.py 的协议处理 health / request / verify / info：
+/// 校验安全数据包（JSON 或二进制线格式），许可证密钥由机器码确定性地派生
+/// （与 Python 服务端 generate_license_key 相同），任何机器码都能直接验证成功
+/// 仅用于负载生成与基准测试；应用密钥使用 SecureTransportCpp::setAppSecret 设置
+/// </summary>
+class LicenseStandIn {
+ public:
+  explicit LicenseStandIn(
+      const std::string& secretKey = "DEFAULT_SECRET_KEY_2026");
+
+  /// <summary>
+  /// 处理一个请求（线程安全）
+  /// request.url 可以是完整 URL（进程内传输）或仅路径（回环服务器）
+  /// </summary>
+  HttpClientCpp::Response handle(const HttpClientCpp::Request& request) const;
+
+  /// <summary>
+  /// 机器码对应的许可证密钥：SHA256(机器码 + 服务端密钥) 的十六进制
+  /// </summary>
+  std::string licenseKeyFor(const std::string& machineCode) const;
+
+ private:
+  std::string m_secretKey;
+};
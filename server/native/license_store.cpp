@@ -0,0 +1,275 @@
+#include "license_store.h"
+
+#include <sqlite3.h>
+
+#include <ctime>
+#include <iostream>
+
+// 与 secure_license_server.py 的 init_database 相同的表结构
+static const char* const kSchema =
+    "CREATE TABLE IF NOT EXISTS licenses ("
+    "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    "  machine_code TEXT UNIQUE NOT NULL,"
+    "  license_key TEXT NOT NULL,"
+    "  user_info TEXT,"
+    "  status TEXT DEFAULT 'active',"
+    "  created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
+    "  expires_at TIMESTAMP,"
+    "  last_verified TIMESTAMP"
+    ");"
+    "CREATE TABLE IF NOT EXISTS verify_logs ("
+    "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    "  machine_code TEXT NOT NULL,"
+    "  verified_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
+    "  result TEXT,"
+    "  ip_address TEXT"
+    ");"
+    "CREATE TABLE IF NOT EXISTS security_logs ("
+    "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    "  event_type TEXT NOT NULL,"
+    "  ip_address TEXT,"
+    "  details TEXT,"
+    "  created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP"
+    ");";
+
+// 其他连接持有写锁时的等待上限（毫秒）
+static const int kBusyTimeoutMs = 5000;
+
+static void bindText(sqlite3_stmt* statement, int index,
+                     const std::string& value) {
+  sqlite3_bind_text(statement, index, value.data(),
+                    static_cast<int>(value.size()), SQLITE_STATIC);
+}
+
+// 读取文本列，NULL 时返回 false
+static bool columnText(sqlite3_stmt* statement, int column, std::string& out) {
+  if (sqlite3_column_type(statement, column) == SQLITE_NULL) {
+    out.clear();
+    return false;
+  }
+  const unsigned char* text = sqlite3_column_text(statement, column);
+  out.assign(reinterpret_cast<const char*>(text),
+             static_cast<size_t>(sqlite3_column_bytes(statement, column)));
+  return true;
+}
+
+// 读取一行（列顺序与 m_find 相同）
+static void readRecord(sqlite3_stmt* statement, LicenseRecord& record) {
+  columnText(statement, 0, record.machineCode);
+  columnText(statement, 1, record.licenseKey);
+  record.hasUserInfo = columnText(statement, 2, record.userInfo);
+  columnText(statement, 3, record.status);
+  record.hasCreatedAt = columnText(statement, 4, record.createdAt);
+  record.hasExpiresAt = columnText(statement, 5, record.expiresAt);
+  record.hasLastVerified = columnText(statement, 6, record.lastVerified);
+}
+
+// 执行一条写语句并重置，失败时输出警告
+static bool stepOnce(sqlite3* db, sqlite3_stmt* statement) {
+  int res = sqlite3_step(statement);
+  sqlite3_reset(statement);
+  sqlite3_clear_bindings(statement);
+  if (res != SQLITE_DONE) {
+    std::cerr << "[WARNING] SQLite: " << sqlite3_errmsg(db) << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// ============================================================================
+// LicenseStore 实现
+// ============================================================================
+
+LicenseStore::LicenseStore()
+    : m_db(nullptr),
+      m_find(nullptr),
+      m_insert(nullptr),
+      m_renew(nullptr),
+      m_touch(nullptr),
+      m_logVerify(nullptr),
+      m_logSecurity(nullptr) {}
+
+LicenseStore::~LicenseStore() { close(); }
+
+void LicenseStore::close() {
+  sqlite3_stmt* statements[] = {m_find,  m_insert,    m_renew,
+                                m_touch, m_logVerify, m_logSecurity};
+  for (sqlite3_stmt* statement : statements) {
+    sqlite3_finalize(statement);
+  }
+  m_find = m_insert = m_renew = m_touch = m_logVerify = m_logSecurity = nullptr;
+
+  if (m_db) {
+    sqlite3_close(m_db);
+    m_db = nullptr;
+  }
+}
+
+bool LicenseStore::execute(const char* sql, std::string* error) {
+  char* message = nullptr;
+  if (sqlite3_exec(m_db, sql, nullptr, nullptr, &message) != SQLITE_OK) {
+    if (error) *error = message ? message : "unknown error";
+    sqlite3_free(message);
+    return false;
+  }
+  return true;
+}
+
+bool LicenseStore::open(const std::string& path, std::string& error) {
+  close();
+
+  // 每个连接只由一个线程使用，不需要 SQLite 内部互斥
+  int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+  if (sqlite3_open_v2(path.c_str(), &m_db, flags, nullptr) != SQLITE_OK) {
+    error = m_db ? sqlite3_errmsg(m_db) : "out of memory";
+    close();
+    return false;
+  }
+  sqlite3_busy_timeout(m_db, kBusyTimeoutMs);
+
+  // WAL：读不阻塞写，多个工作线程的连接可以并发访问
+  if (!execute("PRAGMA journal_mode=WAL;", &error) ||
+      !execute("PRAGMA synchronous=NORMAL;", &error) ||
+      !execute(kSchema, &error)) {
+    close();
+    return false;
+  }
+
+  struct {
+    sqlite3_stmt** statement;
+    const char* sql;
+  } prepared[] = {
+      {&m_find,
+       "SELECT machine_code, license_key, user_info, status, created_at, "
+       "expires_at, last_verified FROM licenses WHERE machine_code = ?"},
+      {&m_insert,
+       "INSERT INTO licenses "
+       "(machine_code, license_key, user_info, expires_at) "
+       "VALUES (?, ?, ?, ?)"},
+      {&m_renew,
+       "UPDATE licenses SET license_key = ?, user_info = ?, expires_at = ?, "
+       "status = 'active' WHERE machine_code = ?"},
+      {&m_touch,
+       "UPDATE licenses SET last_verified = ? WHERE machine_code = ?"},
+      {&m_logVerify,
+       "INSERT INTO verify_logs "
+       "(machine_code, result, ip_address, verified_at) "
+       "VALUES (?, ?, ?, ?)"},
+      {&m_logSecurity,
+       "INSERT INTO security_logs (event_type, ip_address, details) "
+       "VALUES (?, ?, ?)"},
+  };
+
+  for (const auto& entry : prepared) {
+    if (sqlite3_prepare_v2(m_db, entry.sql, -1, entry.statement, nullptr) !=
+        SQLITE_OK) {
+      error = sqlite3_errmsg(m_db);
+      close();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool LicenseStore::find(const std::string& machineCode, LicenseRecord& record) {
+  bindText(m_find, 1, machineCode);
+
+  bool found = sqlite3_step(m_find) == SQLITE_ROW;
+  if (found) {
+    readRecord(m_find, record);
+  }
+
+  sqlite3_reset(m_find);
+  sqlite3_clear_bindings(m_find);
+  return found;
+}
+
+bool LicenseStore::forEach(
+    const std::function<void(const LicenseRecord&)>& callback,
+    std::string& error) {
+  sqlite3_stmt* statement = nullptr;
+  if (sqlite3_prepare_v2(m_db,
+                         "SELECT machine_code, license_key, user_info, status, "
+                         "created_at, expires_at, last_verified FROM licenses "
+                         "ORDER BY id",
+                         -1, &statement, nullptr) != SQLITE_OK) {
+    error = sqlite3_errmsg(m_db);
+    return false;
+  }
+
+  int res;
+  LicenseRecord record;
+  while ((res = sqlite3_step(statement)) == SQLITE_ROW) {
+    readRecord(statement, record);
+    callback(record);
+  }
+  sqlite3_finalize(statement);
+
+  if (res != SQLITE_DONE) {
+    error = sqlite3_errmsg(m_db);
+    return false;
+  }
+  return true;
+}
+
+bool LicenseStore::issue(const std::string& machineCode,
+                         const std::string& licenseKey,
+                         const std::string& userInfo,
+                         const std::string& expiresAt, bool& renewed) {
+  LicenseRecord existing;
+  renewed = find(machineCode, existing);
+
+  if (renewed) {
+    bindText(m_renew, 1, licenseKey);
+    bindText(m_renew, 2, userInfo);
+    bindText(m_renew, 3, expiresAt);
+    bindText(m_renew, 4, machineCode);
+    return stepOnce(m_db, m_renew);
+  }
+
+  bindText(m_insert, 1, machineCode);
+  bindText(m_insert, 2, licenseKey);
+  bindText(m_insert, 3, userInfo);
+  bindText(m_insert, 4, expiresAt);
+  return stepOnce(m_db, m_insert);
+}
+
+void LicenseStore::markVerified(const std::string& machineCode,
+                                const std::string& verifiedAt) {
+  bindText(m_touch, 1, verifiedAt);
+  bindText(m_touch, 2, machineCode);
+  stepOnce(m_db, m_touch);
+}
+
+void LicenseStore::logVerify(const std::string& machineCode,
+                             const std::string& result,
+                             const std::string& ipAddress,
+                             const std::string& verifiedAt) {
+  bindText(m_logVerify, 1, machineCode);
+  bindText(m_logVerify, 2, result);
+  bindText(m_logVerify, 3, ipAddress);
+  bindText(m_logVerify, 4, verifiedAt);
+  stepOnce(m_db, m_logVerify);
+}
+
+void LicenseStore::logSecurityEvent(const std::string& eventType,
+                                    const std::string& ipAddress,
+                                    const std::string& details) {
+  bindText(m_logSecurity, 1, eventType);
+  bindText(m_logSecurity, 2, ipAddress);
+  bindText(m_logSecurity, 3, details);
+  stepOnce(m_db, m_logSecurity);
+}
+
+void LicenseStore::begin() { execute("BEGIN IMMEDIATE;"); }
+
+void LicenseStore::commit() { execute("COMMIT;"); }
+
+std::string LicenseStore::currentTimestamp() {
+  std::time_t now = std::time(nullptr);
+  std::tm utc{};
+  gmtime_r(&now, &utc);
+  char buffer[32];
+  std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &utc);
+  return buffer;
+}
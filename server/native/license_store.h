@@ -0,0 +1,105 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+/// <summary>
+/// licenses 表中的一条记录
+/// 可为 NULL 的列用 has* 标记（JSON 中输出 null）
+/// </summary>
+struct LicenseRecord {
+  std::string machineCode;
+  std::string licenseKey;
+  std::string userInfo;
+  std::string status;
+  std::string createdAt;
+  std::string expiresAt;
+  std::string lastVerified;
+  bool hasUserInfo = false;
+  bool hasCreatedAt = false;
+  bool hasExpiresAt = false;
+  bool hasLastVerified = false;
+};
+
+/// <summary>
+/// 授权数据库（SQLite，与 secure_license_server.py 使用同一表结构，可共用数据库文件）
+/// 每个实例持有一个连接与预编译语句，只能由一个线程使用；
+/// 多个实例（每个工作线程一个）通过 WAL 模式并发读写同一文件
+/// </summary>
+class LicenseStore {
+ public:
+  LicenseStore();
+  ~LicenseStore();
+
+  LicenseStore(const LicenseStore&) = delete;
+  LicenseStore& operator=(const LicenseStore&) = delete;
+
+  /// <summary>
+  /// 打开数据库并创建缺失的表，失败时返回 false 并设置 error
+  /// </summary>
+  bool open(const std::string& path, std::string& error);
+
+  /// <summary>
+  /// 按机器码查找许可证
+  /// </summary>
+  bool find(const std::string& machineCode, LicenseRecord& record);
+
+  /// <summary>
+  /// 按主键顺序遍历全部许可证，失败时返回 false 并设置 error
+  /// </summary>
+  bool forEach(const std::function<void(const LicenseRecord&)>& callback,
+               std::string& error);
+
+  /// <summary>
+  /// 签发许可证：已有记录时续期并重新激活（renewed 为 true），否则插入
+  /// </summary>
+  bool issue(const std::string& machineCode, const std::string& licenseKey,
+             const std::string& userInfo, const std::string& expiresAt,
+             bool& renewed);
+
+  /// <summary>
+  /// 更新最后验证时间（verifiedAt 见 currentTimestamp）
+  /// </summary>
+  void markVerified(const std::string& machineCode,
+                    const std::string& verifiedAt);
+
+  /// <summary>
+  /// 记录验证结果（success / not_found / inactive / expired）
+  /// </summary>
+  void logVerify(const std::string& machineCode, const std::string& result,
+                 const std::string& ipAddress, const std::string& verifiedAt);
+
+  /// <summary>
+  /// 记录安全事件（写入失败只输出警告）
+  /// </summary>
+  void logSecurityEvent(const std::string& eventType,
+                        const std::string& ipAddress,
+                        const std::string& details);
+
+  /// <summary>
+  /// 显式事务：批量写入时减少提交次数
+  /// </summary>
+  void begin();
+  void commit();
+
+  /// <summary>
+  /// 当前 UTC 时间 "YYYY-MM-DD HH:MM:SS"（与 SQLite CURRENT_TIMESTAMP 一致）
+  /// 延后写入时用于保留实际的验证时间
+  /// </summary>
+  static std::string currentTimestamp();
+
+ private:
+  sqlite3* m_db;
+  sqlite3_stmt* m_find;
+  sqlite3_stmt* m_insert;
+  sqlite3_stmt* m_renew;
+  sqlite3_stmt* m_touch;
+  sqlite3_stmt* m_logVerify;
+  sqlite3_stmt* m_logSecurity;
+
+  void close();
+  bool execute(const char* sql, std::string* error = nullptr);
+};
@@ -0,0 +1,226 @@
+// 客户端并发压力测试（以 ThreadSanitizer 构建，见 CMakeLists.txt）
+// 在进程内启动回环替身服务器，多个线程同时使用共享的 HttpClientCpp 与
+// LicenseClientCpp：同步/异步请求、取消、验证缓存读写与清空、请求在途时
+// 析构客户端；另有线程在共享的进程内传输上取消尚未到期的请求。不访问外网；检测到数据竞争时 TSan 以非零状态退出
+//
+// 用法: license_stress [--rounds N]（每个线程的循环次数，默认 200）
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "http_client_cpp.h"
+#include "in_process_transport.h"
+#include "license_standin.h"
+#include "secure_transport_cpp.h"
+#include "standin_listener.h"
+
+static std::atomic<int> g_failures{0};
+
+static void fail(const std::string& message) {
+  g_failures++;
+  std::cerr << "[FAIL] " << message << std::endl;
+}
+
+static std::string machineCodeFor(int index) {
+  return SecureTransportCpp::sha256("stress-machine-" + std::to_string(index));
+}
+
+// 共享 HttpClientCpp：同步请求、异步请求与取消
+static void httpWorker(HttpClientCpp& client, const std::string& baseUrl,
+                       int rounds) {
+  for (int i = 0; i < rounds; i++) {
+    HttpClientCpp::Response response = client.get(baseUrl + "/health");
+    if (!response.success) fail("health: " + response.error);
+
+    std::atomic<bool> done{false};
+    HttpClientCpp::Request request;
+    request.url = baseUrl + "/health";
+    HttpRequestHandle handle =
+        client.sendAsync(request, [&done](const HttpClientCpp::Response&) {
+          done = true;
+        });
+    if (i % 3 == 0) handle.cancel();
+    while (!done) std::this_thread::yield();
+  }
+}
+
+// 共享 LicenseClientCpp：同步、合并的异步与非阻塞验证，同时读写验证缓存
+static void verifyWorker(LicenseClientCpp& client, const LicenseStandIn& standIn,
+                         int worker, int rounds) {
+  for (int i = 0; i < rounds; i++) {
+    // 少量机器码在线程间重复：覆盖请求合并与缓存命中
+    std::string machineCode = machineCodeFor((worker + i) % 8);
+    std::string licenseKey = standIn.licenseKeyFor(machineCode);
+
+    LicenseClientCpp::VerifyResponse result =
+        client.verifyLicense(machineCode, licenseKey);
+    if (!result.valid) fail("verifyLicense: " + result.message);
+
+    std::atomic<int> pending{2};
+    client.verifyLicenseAsync(
+        machineCode, licenseKey,
+        [&pending](const LicenseClientCpp::VerifyResponse& response) {
+          if (!response.valid) fail("verifyLicenseAsync: " + response.message);
+          pending--;
+        });
+    client.startVerifyLicense(
+        machineCode, licenseKey,
+        [&pending](const LicenseClientCpp::VerifyResponse& response) {
+          if (!response.valid) fail("startVerifyLicense: " + response.message);
+          pending--;
+        });
+    while (pending > 0) std::this_thread::yield();
+
+    if (i % 10 == worker) client.clearVerifyCache();
+  }
+}
+
+// 请求在途时析构客户端：未完成的请求以取消或 "Client destroyed" 结束
+static void lifecycleWorker(const std::string& baseUrl,
+                            const LicenseStandIn& standIn, int rounds) {
+  for (int i = 0; i < rounds; i++) {
+    std::string machineCode = machineCodeFor(100 + i);
+    std::string licenseKey = standIn.licenseKeyFor(machineCode);
+    auto callbacks = std::make_shared<std::atomic<int>>(0);
+    {
+      LicenseClientCpp client(baseUrl);
+      client.verifyLicenseAsync(
+          machineCode, licenseKey,
+          [callbacks](const LicenseClientCpp::VerifyResponse&) {
+            (*callbacks)++;
+          });
+      client.startVerifyLicense(
+          machineCode, licenseKey,
+          [callbacks](const LicenseClientCpp::VerifyResponse&) {
+            (*callbacks)++;
+          });
+    }
+    if (callbacks->load() != 2) {
+      fail("lifecycle: " + std::to_string(callbacks->load()) +
+           " of 2 callbacks before destruction returned");
+    }
+  }
+}
+
+// 共享的进程内传输：按句柄取消尚未到期的请求，并析构共享它的客户端
+static void inProcessWorker(std::shared_ptr<InProcessTransport> transport,
+                            const LicenseStandIn& standIn, int rounds) {
+  HttpClientCpp::Request request;
+  request.url = "http://in-process/api/health";
+  for (int i = 0; i < rounds; i++) {
+    std::atomic<bool> done{false};
+    std::atomic<bool> cancelled{false};
+    HttpRequestHandle handle = transport->sendAsync(
+        request, [&](const HttpClientCpp::Response& response) {
+          cancelled = response.error == "Request cancelled";
+          done = true;
+        });
+    handle.cancel();
+    while (!done) std::this_thread::yield();
+    if (!cancelled) fail("in-process: request not cancelled");
+
+    std::string machineCode = machineCodeFor(200 + i);
+    auto callbacks = std::make_shared<std::atomic<int>>(0);
+    {
+      LicenseClientCpp client({"http://in-process/api"}, transport);
+      client.startVerifyLicense(
+          machineCode, standIn.licenseKeyFor(machineCode),
+          [callbacks](const LicenseClientCpp::VerifyResponse&) {
+            (*callbacks)++;
+          });
+    }
+    if (callbacks->load() != 1) fail("in-process: verify not finished");
+  }
+}
+
+int main(int argc, char* argv[]) {
+  int rounds = 200;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string name = argv[i];
+    if (name == "--rounds") {
+      rounds = std::atoi(argv[i + 1]);
+    } else {
+      std::cerr << "未知参数: " << name << "\n";
+      return 1;
+    }
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  SecureTransportCpp::setAppSecret("DEFAULT_APP_SECRET_2026_CHANGE_THIS");
+  LicenseStandIn standIn;
+  StandInListener listener(standIn);
+  std::string error;
+  if (!listener.listen(0, error)) {
+    std::cerr << "监听失败: " << error << "\n";
+    return 1;
+  }
+  listener.start();
+  std::string baseUrl =
+      "http://127.0.0.1:" + std::to_string(listener.port()) + "/api";
+
+  char cacheDir[] = "/tmp/license_stress_XXXXXX";
+  if (!mkdtemp(cacheDir)) {
+    std::cerr << "创建临时目录失败\n";
+    return 1;
+  }
+  std::string cacheFile = std::string(cacheDir) + "/verify_cache.bin";
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    HttpClientCpp httpClient;
+    LicenseClientCpp licenseClient(baseUrl);
+    LicenseClientCpp::VerifyCacheOptions cacheOptions;
+    cacheOptions.filePath = cacheFile;
+    licenseClient.setVerifyCache(cacheOptions);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back(httpWorker, std::ref(httpClient), baseUrl, rounds);
+    }
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back(verifyWorker, std::ref(licenseClient),
+                           std::cref(standIn), t, rounds);
+    }
+    threads.emplace_back(lifecycleWorker, baseUrl, std::cref(standIn),
+                         rounds / 5 + 1);
+
+    // 请求延迟远大于取消所需时间：回调只能来自取消
+    InProcessTransport::Options inProcessOptions;
+    inProcessOptions.latencyUs = 10 * 1000 * 1000;
+    inProcessOptions.asyncThreads = 2;
+    auto inProcess = std::make_shared<InProcessTransport>(
+        [&standIn](const HttpClientCpp::Request& request) {
+          return standIn.handle(request);
+        },
+        inProcessOptions);
+    for (int t = 0; t < 2; t++) {
+      threads.emplace_back(inProcessWorker, inProcess, std::cref(standIn),
+                           rounds);
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+  }
+  listener.stop();
+
+  std::remove(cacheFile.c_str());
+  rmdir(cacheDir);
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << "压力测试 " << (g_failures == 0 ? "通过" : "失败") << "：每线程 "
+            << rounds << " 轮，" << elapsed << " ms，失败 " << g_failures.load()
+            << std::endl;
+  return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+#include "nonce_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+// 线性探测的最大步数（8 个槽位为一个缓存行）
+static const size_t kMaxProbes = 32;
+
+// 每个时间片的容量为预期条目数的两倍（装载率不超过 50%）
+static const size_t kCapacityFactor = 2;
+
+// 溢出表的条目上限为时间片槽位数的倍数
+static const size_t kOverflowFactor = 4;
+
+static uint64_t mix64(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+static uint64_t hashBytes(uint64_t hash, const char* data, size_t length) {
+  while (length >= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, 8);
+    hash = mix64(hash ^ word);
+    data += 8;
+    length -= 8;
+  }
+  uint64_t tail = 0;
+  std::memcpy(&tail, data, length);
+  // 长度参与哈希，避免尾部补零的歧义
+  return mix64(hash ^ tail ^ (static_cast<uint64_t>(length) << 56));
+}
+
+static size_t nextPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+// ============================================================================
+// NonceCache 实现
+// ============================================================================
+
+NonceCache::NonceCache(const Options& options) : m_options(options) {
+  if (m_options.bucketSeconds <= 0) m_options.bucketSeconds = 1;
+
+  // 时效窗口内的时间片互不重叠地映射到不同的桶，另留两个桶作为边界余量
+  int window = m_options.maxAgeSeconds + m_options.futureSkewSeconds;
+  m_bucketCount = static_cast<size_t>(window / m_options.bucketSeconds) + 2;
+  m_slotsPerBucket = nextPowerOfTwo(std::max<size_t>(
+      64, m_options.expectedRate * m_options.bucketSeconds * kCapacityFactor));
+
+  size_t total = m_bucketCount * m_slotsPerBucket;
+  m_slots.reset(new std::atomic<uint64_t>[total]);
+  for (size_t i = 0; i < total; i++) {
+    m_slots[i].store(0, std::memory_order_relaxed);
+  }
+  m_overflow.reset(new Overflow[m_bucketCount]);
+
+  std::random_device random;
+  m_seed = mix64((static_cast<uint64_t>(random()) << 32) ^ random());
+}
+
+size_t NonceCache::memoryBytes() const {
+  return m_bucketCount * m_slotsPerBucket * sizeof(uint64_t);
+}
+
+uint64_t NonceCache::fingerprint(const SecurePacketCpp& packet) const {
+  uint64_t hash = mix64(m_seed ^ static_cast<uint64_t>(packet.timestamp));
+  hash = hashBytes(hash, packet.nonce.chars, packet.nonce.size());
+  return hashBytes(hash, packet.machineCode.chars, packet.machineCode.size());
+}
+
+NonceCache::Result NonceCache::check(const SecurePacketCpp& packet) {
+  uint64_t epoch = static_cast<uint64_t>(packet.timestamp) /
+                   static_cast<uint64_t>(m_options.bucketSeconds);
+  uint64_t tag = epoch & 0xFFFF;
+
+  // 高 48 位为指纹（最低位置 1，保证槽位值非 0），探测起点取再次混合的值
+  uint64_t hash = fingerprint(packet);
+  uint64_t value = ((hash | (1ULL << 16)) & ~0xFFFFULL) | tag;
+
+  std::atomic<uint64_t>* bucket =
+      &m_slots[(epoch % m_bucketCount) * m_slotsPerBucket];
+  size_t mask = m_slotsPerBucket - 1;
+  size_t index = static_cast<size_t>(mix64(hash)) & mask;
+
+  for (size_t probe = 0; probe < kMaxProbes; probe++) {
+    std::atomic<uint64_t>& slot = bucket[(index + probe) & mask];
+    uint64_t current = slot.load(std::memory_order_acquire);
+
+    while (current == 0 || (current & 0xFFFF) != tag) {
+      // 空槽位或过期时间片留下的旧值：尝试占用
+      if (slot.compare_exchange_weak(current, value,
+                                     std::memory_order_acq_rel,
+                                     std::memory_order_acquire)) {
+        return Fresh;
+      }
+    }
+
+    // 当前时间片的槽位只会被占用、不会被释放，相同指纹必然在探测链上
+    if (current == value) {
+      return Replay;
+    }
+  }
+  // 探测链已满且只会保持已满：同一数据包的重放必然也走到溢出表
+  return checkOverflow(epoch, value);
+}
+
+NonceCache::Result NonceCache::checkOverflow(uint64_t epoch, uint64_t value) {
+  Overflow& overflow = m_overflow[epoch % m_bucketCount];
+  std::lock_guard<std::mutex> lock(overflow.mutex);
+
+  if (overflow.epoch != epoch) {
+    // 同一个桶的旧时间片已超出时效
+    overflow.values.clear();
+    overflow.epoch = epoch;
+    overflow.fullLogged = false;
+    std::cerr << "[WARNING] 防重放缓存时间片已满（预期速率 "
+              << m_options.expectedRate << " 次/秒），改用溢出表"
+              << std::endl;
+  }
+
+  if (overflow.values.count(value) > 0) return Replay;
+  if (overflow.values.size() >= m_slotsPerBucket * kOverflowFactor) {
+    if (!overflow.fullLogged) {
+      overflow.fullLogged = true;
+      std::cerr << "[WARNING] 防重放缓存溢出表已满，拒绝本时间片的新数据包"
+                << std::endl;
+    }
+    return Full;
+  }
+  overflow.values.insert(value);
+  return Fresh;
+}
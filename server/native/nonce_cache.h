@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+#include "license_protocol.h"
+#include "secure_transport_cpp.h"
+
+/// <summary>
+/// 安全数据包的防重放缓存（无锁，按时间戳分桶）
+/// 数据包时间戳按 bucketSeconds 划分时间片，每个时间片映射到一个固定容量的
+/// 开放寻址表；槽位为一个 64 位原子值：48 位指纹 + 16 位时间片标记。
+/// 标记不是当前时间片的槽位视为空，因此超出时效的整个时间片无需清理即失效，
+/// 内存固定为 请求速率 × 时效窗口。
+/// 时间片写满后改用该时间片加锁的溢出表（首次发生时输出警告），
+/// 溢出表也达到上限时才拒绝
+/// </summary>
+class NonceCache {
+ public:
+  struct Options {
+    int maxAgeSeconds = 300;  // 与数据包最大时效一致
+    int futureSkewSeconds = kMaxClockSkewSeconds;  // 与时间戳校验一致
+    int bucketSeconds = 10;   // 时间片长度
+    size_t expectedRate = 4096;  // 预期每秒数据包数，决定每个时间片的容量
+  };
+
+  /// <summary>
+  /// 每个工作线程对应的预期数据包速率（每秒）
+  /// 服务器按工作线程数乘以该值确定 expectedRate；加上溢出表，
+  /// 每个工作线程约 32000 次/秒以内不会拒绝（单个工作线程实测约 10000 次/秒）
+  /// </summary>
+  static const size_t kRatePerWorker = 2048;
+
+  enum Result {
+    Fresh,   // 首次出现，已记录
+    Replay,  // 时效窗口内已出现过
+    Full,    // 所在时间片与其溢出表都已满，无法记录
+  };
+
+  explicit NonceCache(const Options& options);
+
+  NonceCache(const NonceCache&) = delete;
+  NonceCache& operator=(const NonceCache&) = delete;
+
+  /// <summary>
+  /// 检查并记录数据包（线程安全，无锁）
+  /// 调用前应已通过 verifySecurePacket 的时间戳校验
+  /// </summary>
+  Result check(const SecurePacketCpp& packet);
+
+  /// <summary>
+  /// 占用的内存（字节）
+  /// </summary>
+  size_t memoryBytes() const;
+
+ private:
+  Options m_options;
+  size_t m_bucketCount;
+  size_t m_slotsPerBucket;  // 2 的幂
+  uint64_t m_seed;
+  std::unique_ptr<std::atomic<uint64_t>[]> m_slots;
+
+  // 每个桶的溢出表：只保存 epoch 时间片的条目，时间片变化时清空
+  struct Overflow {
+    std::mutex mutex;
+    uint64_t epoch = ~0ULL;
+    std::unordered_set<uint64_t> values;
+    bool fullLogged = false;
+  };
+  std::unique_ptr<Overflow[]> m_overflow;
+
+  uint64_t fingerprint(const SecurePacketCpp& packet) const;
+  Result checkOverflow(uint64_t epoch, uint64_t value);
+};
@@ -0,0 +1,137 @@
+#include "rate_limiter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+// 分片数（2 的幂）与每个键的最大探测步数
+static const size_t kShardCount = 64;
+static const size_t kMaxProbes = 16;
+
+static uint64_t mix64(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+static size_t nextPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+// ============================================================================
+// RateLimiter 实现
+// ============================================================================
+
+RateLimiter::RateLimiter(const Options& options)
+    : m_options(options), m_start(std::chrono::steady_clock::now()) {
+  m_options.maxRequests = std::max<uint32_t>(1, m_options.maxRequests);
+  m_options.windowSeconds = std::max<uint32_t>(1, m_options.windowSeconds);
+
+  m_intervalMicros = static_cast<int64_t>(m_options.windowSeconds) * 1000000 /
+                     m_options.maxRequests;
+  m_burstMicros = m_intervalMicros * (m_options.maxRequests - 1);
+
+  // 装载率不超过 50%
+  m_slotsPerShard =
+      nextPowerOfTwo(std::max<size_t>(16, m_options.maxKeys * 2 / kShardCount));
+  m_shards.reset(new Shard[kShardCount]);
+  for (size_t i = 0; i < kShardCount; i++) {
+    m_shards[i].slots.reset(new Slot[m_slotsPerShard]);
+  }
+
+  std::random_device random;
+  m_seed = mix64((static_cast<uint64_t>(random()) << 32) ^ random());
+}
+
+bool RateLimiter::consume(Slot& slot, int64_t now) {
+  int64_t tat = slot.tat.load(std::memory_order_relaxed);
+  while (true) {
+    // 理论到达时间早于现在说明桶已补满
+    int64_t start = std::max(tat, now);
+    if (start - now > m_burstMicros) {
+      return false;
+    }
+    if (slot.tat.compare_exchange_weak(tat, start + m_intervalMicros,
+                                       std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+}
+
+bool RateLimiter::allow(const std::string& key) {
+  int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - m_start)
+                    .count();
+
+  uint64_t hash = m_seed;
+  const char* data = key.data();
+  size_t length = key.size();
+  for (; length >= 8; data += 8, length -= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, 8);
+    hash = mix64(hash ^ word);
+  }
+  uint64_t tail = 0;
+  std::memcpy(&tail, data, length);
+  hash = mix64(hash ^ tail ^ (static_cast<uint64_t>(length) << 56));
+  if (hash == 0) hash = 1;  // 0 表示空槽位
+
+  Slot* slots = m_shards[hash >> 58].slots.get();
+  size_t mask = m_slotsPerShard - 1;
+  size_t index = static_cast<size_t>(mix64(hash)) & mask;
+  Slot* victim = nullptr;
+  int64_t victimTat = 0;
+
+  for (size_t probe = 0; probe < kMaxProbes; probe++) {
+    Slot& slot = slots[(index + probe) & mask];
+    uint64_t current = slot.key.load(std::memory_order_acquire);
+
+    if (current == 0) {
+      // 空槽位：占用后 tat 为 0，即桶满（并发占用同一槽位的线程会看到相同的键）
+      if (slot.key.compare_exchange_strong(current, hash,
+                                           std::memory_order_acq_rel)) {
+        return consume(slot, now);
+      }
+    }
+    if (current == hash) {
+      return consume(slot, now);
+    }
+    // 理论到达时间最早的键最先补满（已补满的键 tat 不晚于现在）
+    int64_t tat = slot.tat.load(std::memory_order_relaxed);
+    if (!victim || tat < victimTat) {
+      victim = &slot;
+      victimTat = tat;
+    }
+  }
+
+  // 探测范围内没有空槽位：替换最早补满的键。已补满的键被替换等同于没有记录；
+  // 尚未补满时新键从满桶开始，只在 tat 未被并发修改时重置，不会丢失其他线程
+  // 的消耗（被替换的键之后再来时重新占用槽位，同样从满桶开始）
+  uint64_t current = victim->key.load(std::memory_order_acquire);
+  victimTat = victim->tat.load(std::memory_order_relaxed);
+  if (current != hash &&
+      victim->key.compare_exchange_strong(current, hash,
+                                          std::memory_order_acq_rel)) {
+    if (victimTat > now) {
+      victim->tat.compare_exchange_strong(victimTat, now,
+                                          std::memory_order_relaxed);
+    }
+    return consume(*victim, now);
+  }
+  if (current == hash) {
+    return consume(*victim, now);
+  }
+
+  // 其他线程同时替换了该槽位：放行并计数，不因表满拒绝新键
+  m_unlimited.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+uint64_t RateLimiter::unlimitedCount() const {
+  return m_unlimited.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/// <summary>
+/// 按键（如客户端 IP）限流的令牌桶（线程安全，无锁）
+/// 每个键的状态只有一个原子整数：理论到达时间（GCRA，与令牌桶等价），
+/// 检查时按经过的时间惰性补充，常数时间完成
+/// 键分布在固定数量的分片中，总容量在构造时确定；探测范围内没有空槽位时
+/// 替换最早补满的键，内存不随客户端数量增长，新键不会因表满被拒绝
+/// </summary>
+class RateLimiter {
+ public:
+  struct Options {
+    uint32_t maxRequests = 10;     // 桶容量：窗口内最多请求次数
+    uint32_t windowSeconds = 3600; // 补满整个桶所需的时间
+    size_t maxKeys = 65536;        // 同时跟踪的键数量上限
+  };
+
+  explicit RateLimiter(const Options& options);
+
+  RateLimiter(const RateLimiter&) = delete;
+  RateLimiter& operator=(const RateLimiter&) = delete;
+
+  /// <summary>
+  /// 消耗 key 的一个令牌，令牌不足时返回 false
+  /// </summary>
+  bool allow(const std::string& key);
+
+  /// <summary>
+  /// 因并发替换同一槽位而未经限流放行的请求数
+  /// </summary>
+  uint64_t unlimitedCount() const;
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> key{0};  // 键的哈希，0 表示空
+    std::atomic<int64_t> tat{0};   // 理论到达时间（微秒，相对 m_start）
+  };
+
+  struct alignas(64) Shard {
+    std::unique_ptr<Slot[]> slots;
+  };
+
+  Options m_options;
+  int64_t m_intervalMicros;   // 补充一个令牌的时间
+  int64_t m_burstMicros;      // 允许提前的时间：(容量 - 1) × 间隔
+  size_t m_slotsPerShard;     // 2 的幂
+  uint64_t m_seed;
+  std::chrono::steady_clock::time_point m_start;
+  std::unique_ptr<Shard[]> m_shards;
+  std::atomic<uint64_t> m_unlimited{0};
+
+  bool consume(Slot& slot, int64_t now);
+};
@@ -0,0 +1,159 @@
+#include "standin_listener.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "http_message.h"
+#include "license_protocol.h"
+
+static bool writeAll(int fd, const std::string& data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = ::send(fd, data.data() + written, data.size() - written,
+                       MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    written += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// ============================================================================
+// StandInListener 实现
+// ============================================================================
+
+StandInListener::StandInListener(const LicenseStandIn& standIn, int delayMs)
+    : m_standIn(standIn), m_delayMs(delayMs) {}
+
+StandInListener::~StandInListener() { stop(); }
+
+bool StandInListener::listen(int port, std::string& error) {
+  m_listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (m_listener < 0) {
+    error = std::strerror(errno);
+    return false;
+  }
+  int reuse = 1;
+  setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  socklen_t length = sizeof(address);
+  if (bind(m_listener, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      ::listen(m_listener, SOMAXCONN) != 0 ||
+      getsockname(m_listener, reinterpret_cast<sockaddr*>(&address),
+                  &length) != 0) {
+    error = std::strerror(errno);
+    close(m_listener);
+    m_listener = -1;
+    return false;
+  }
+  m_port = ntohs(address.sin_port);
+  return true;
+}
+
+void StandInListener::run() {
+  while (true) {
+    int fd = accept4(m_listener, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!m_stopping) {
+        std::cerr << "accept 失败: " << std::strerror(errno) << "\n";
+      }
+      break;
+    }
+
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping) {
+      close(fd);
+      break;
+    }
+    m_connections.insert(fd);
+    std::thread(&StandInListener::serveConnection, this, fd).detach();
+  }
+}
+
+void StandInListener::start() {
+  m_acceptThread = std::thread(&StandInListener::run, this);
+}
+
+void StandInListener::stop() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_stopping = true;
+
+  // shutdown 让阻塞的 accept/recv 返回；文件描述符由各自的线程关闭
+  if (m_listener >= 0) shutdown(m_listener, SHUT_RDWR);
+  for (int fd : m_connections) {
+    shutdown(fd, SHUT_RDWR);
+  }
+  lock.unlock();
+
+  if (m_acceptThread.joinable()) m_acceptThread.join();
+
+  lock.lock();
+  m_idle.wait(lock, [this]() { return m_connections.empty(); });
+  if (m_listener >= 0) {
+    close(m_listener);
+    m_listener = -1;
+  }
+}
+
+void StandInListener::serveConnection(int fd) {
+  std::string buffer;
+  char chunk[16 * 1024];
+
+  while (true) {
+    HttpClientCpp::Request request;
+    size_t consumed = 0;
+    bool keepAlive = true;
+    HttpParseStatus status =
+        parseHttpRequest(buffer, request, consumed, keepAlive);
+
+    if (status == HttpIncomplete) {
+      ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+      if (n <= 0) break;
+      buffer.append(chunk, static_cast<size_t>(n));
+      continue;
+    }
+
+    if (status == HttpInvalid) {
+      writeAll(fd, formatHttpResponse(
+                       jsonResponse(400, "{\"success\":false,\"message\":"
+                                         "\"Bad request\"}"),
+                       false));
+      break;
+    }
+
+    buffer.erase(0, consumed);
+    // 模拟慢服务器（多服务器选择实验）
+    if (m_delayMs > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(m_delayMs));
+    }
+    if (!writeAll(fd,
+                  formatHttpResponse(m_standIn.handle(request), keepAlive)) ||
+        !keepAlive) {
+      break;
+    }
+  }
+
+  // 在锁内关闭：stop() 不会对已复用的描述符调用 shutdown
+  std::lock_guard<std::mutex> lock(m_mutex);
+  close(fd);
+  m_connections.erase(fd);
+  m_idle.notify_all();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "license_standin.h"
+
+/// <summary>
+/// 授权服务替身的回环 HTTP 监听器（POSIX）
+/// 每个连接一个线程，支持 keep-alive 与流水线请求，只监听 127.0.0.1；
+/// 请求交给 LicenseStandIn 处理。license_standin 与压力测试共用
+/// </summary>
+class StandInListener {
+ public:
+  /// <param name="delayMs">每个响应前的注入延迟（模拟慢服务器）</param>
+  explicit StandInListener(const LicenseStandIn& standIn, int delayMs = 0);
+
+  /// <summary>
+  /// 停止监听并等待所有连接线程结束
+  /// </summary>
+  ~StandInListener();
+
+  StandInListener(const StandInListener&) = delete;
+  StandInListener& operator=(const StandInListener&) = delete;
+
+  /// <summary>
+  /// 绑定 127.0.0.1:port 并开始监听（port 为 0 时由系统分配）
+  /// </summary>
+  bool listen(int port, std::string& error);
+
+  /// <summary>
+  /// 实际监听的端口
+  /// </summary>
+  int port() const { return m_port; }
+
+  /// <summary>
+  /// 在当前线程接受连接，直到 stop() 或出错
+  /// </summary>
+  void run();
+
+  /// <summary>
+  /// 在后台线程接受连接
+  /// </summary>
+  void start();
+
+  /// <summary>
+  /// 停止接受连接，关闭已有连接并等待连接线程结束
+  /// </summary>
+  void stop();
+
+ private:
+  const LicenseStandIn& m_standIn;
+  int m_delayMs;
+  int m_listener = -1;
+  int m_port = 0;
+  std::thread m_acceptThread;
+
+  // 活动连接：stop() 关闭它们并等待线程退出
+  std::mutex m_mutex;
+  std::condition_variable m_idle;
+  std::set<int> m_connections;
+  bool m_stopping = false;
+
+  void serveConnection(int fd);
+};
@@ -0,0 +1,55 @@
+// 授权服务替身的回环 HTTP 服务器（POSIX）
+// 每个连接一个线程，支持 keep-alive 与流水线请求，只监听 127.0.0.1；
+// 请求交给 LicenseStandIn 处理，用于在本机对客户端做负载测试
+//
+// 用法: license_standin [--port 18080] [--secret 服务端密钥] [--app-secret 应用密钥]
+//                       [--delay-ms 每个响应前的注入延迟]
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "license_standin.h"
+#include "secure_transport_cpp.h"
+#include "standin_listener.h"
+
+int main(int argc, char* argv[]) {
+  int port = 18080;
+  int delayMs = 0;
+  std::string secretKey = "DEFAULT_SECRET_KEY_2026";
+  std::string appSecret = "DEFAULT_APP_SECRET_2026_CHANGE_THIS";
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string name = argv[i];
+    if (name == "--port") {
+      port = std::atoi(argv[i + 1]);
+    } else if (name == "--delay-ms") {
+      delayMs = std::atoi(argv[i + 1]);
+    } else if (name == "--secret") {
+      secretKey = argv[i + 1];
+    } else if (name == "--app-secret") {
+      appSecret = argv[i + 1];
+    } else {
+      std::cerr << "未知参数: " << name << "\n";
+      return 1;
+    }
+  }
+
+  SecureTransportCpp::setAppSecret(appSecret);
+  LicenseStandIn standIn(secretKey);
+
+  StandInListener listener(standIn, delayMs);
+  std::string error;
+  if (!listener.listen(port, error)) {
+    std::cerr << "监听 127.0.0.1:" << port << " 失败: " << error << "\n";
+    return 1;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  std::cout << "授权服务替身已启动: http://127.0.0.1:" << listener.port()
+            << "/api" << std::endl;
+
+  listener.run();
+  return 1;
+}
@@ -0,0 +1,123 @@
+#include "verify_log_writer.h"
+
+#include <chrono>
+#include <iostream>
+#include <utility>
+
+// ============================================================================
+// VerifyLogWriter 实现
+// ============================================================================
+
+VerifyLogWriter::VerifyLogWriter(const Options& options)
+    : m_options(options) {}
+
+VerifyLogWriter::~VerifyLogWriter() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_wake.notify_all();
+  if (m_thread.joinable()) m_thread.join();
+}
+
+bool VerifyLogWriter::open(std::string& error) {
+  if (!m_store.open(m_options.databasePath, error)) return false;
+  m_running = true;
+  m_thread = std::thread(&VerifyLogWriter::run, this);
+  return true;
+}
+
+void VerifyLogWriter::logVerify(const std::string& machineCode,
+                                const std::string& result,
+                                const std::string& ipAddress,
+                                const std::string& verifiedAt) {
+  Entry entry;
+  entry.first = machineCode;
+  entry.second = result;
+  entry.ipAddress = ipAddress;
+  entry.verifiedAt = verifiedAt;
+  enqueue(std::move(entry));
+}
+
+void VerifyLogWriter::logSecurityEvent(const std::string& eventType,
+                                       const std::string& ipAddress,
+                                       const std::string& details) {
+  Entry entry;
+  entry.verify = false;
+  entry.first = eventType;
+  entry.second = details;
+  entry.ipAddress = ipAddress;
+  enqueue(std::move(entry));
+}
+
+void VerifyLogWriter::enqueue(Entry&& entry) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_pending.size() >= m_options.maxPending) {
+    m_dropped++;
+    return;
+  }
+  m_pending.push_back(std::move(entry));
+  m_enqueued++;
+  if (m_pending.size() == m_options.flushBatch) m_wake.notify_one();
+}
+
+void VerifyLogWriter::flush() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  uint64_t target = m_enqueued;
+  m_flushRequested = true;
+  m_wake.notify_one();
+  m_flushed.wait(lock, [&]() { return m_committed >= target || !m_running; });
+}
+
+uint64_t VerifyLogWriter::dropped() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_dropped;
+}
+
+void VerifyLogWriter::run() {
+  std::vector<Entry> batch;
+  uint64_t reportedDrops = 0;
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while (true) {
+    // 等到间隔到期、队列达到批量长度或有 flush() 等待
+    m_wake.wait_for(lock, std::chrono::milliseconds(m_options.flushIntervalMs),
+                    [this]() {
+                      return !m_running || m_flushRequested ||
+                             m_pending.size() >= m_options.flushBatch;
+                    });
+    bool running = m_running;
+    m_flushRequested = false;
+    batch.swap(m_pending);
+    uint64_t drops = m_dropped - reportedDrops;
+    reportedDrops = m_dropped;
+    lock.unlock();
+
+    if (drops > 0) {
+      std::cerr << "[WARNING] 验证日志队列已满，丢弃 " << drops << " 条"
+                << std::endl;
+    }
+    if (!batch.empty()) {
+      // 一个事务提交整批写入：每批只获取一次写锁、同步一次 WAL
+      m_store.begin();
+      for (const Entry& entry : batch) {
+        if (!entry.verify) {
+          m_store.logSecurityEvent(entry.first, entry.ipAddress, entry.second);
+          continue;
+        }
+        if (entry.second == "success") {
+          m_store.markVerified(entry.first, entry.verifiedAt);
+        }
+        m_store.logVerify(entry.first, entry.second, entry.ipAddress,
+                          entry.verifiedAt);
+      }
+      m_store.commit();
+    }
+
+    lock.lock();
+    m_committed += batch.size();
+    batch.clear();
+    m_flushed.notify_all();
+    if (!running && m_pending.empty()) break;
+  }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "license_store.h"
+
+/// <summary>
+/// 验证日志的后台批量写入（所有工作线程共享）
+/// 工作线程只把 last_verified / verify_logs / security_logs 的写入放入队列，
+/// 后台线程按间隔或队列长度把积累的写入合并为一个事务提交，
+/// 验证请求的热路径不再争用 SQLite 的写锁。
+/// 验证时间由调用方记录，不受提交延迟影响；队列超过上限时丢弃新条目并计数
+/// </summary>
+class VerifyLogWriter {
+ public:
+  struct Options {
+    std::string databasePath = "licenses.db";
+    int flushIntervalMs = 50;   // 最长提交间隔
+    size_t flushBatch = 1024;   // 队列达到该长度时立即提交
+    size_t maxPending = 65536;  // 队列上限（数据库长时间不可写时保护内存）
+  };
+
+  explicit VerifyLogWriter(const Options& options);
+
+  /// <summary>
+  /// 提交队列中剩余的写入并停止后台线程
+  /// </summary>
+  ~VerifyLogWriter();
+
+  VerifyLogWriter(const VerifyLogWriter&) = delete;
+  VerifyLogWriter& operator=(const VerifyLogWriter&) = delete;
+
+  /// <summary>
+  /// 打开数据库并启动后台线程，失败时返回 false 并设置 error
+  /// </summary>
+  bool open(std::string& error);
+
+  /// <summary>
+  /// 记录验证结果，result 为 success 时同时更新 last_verified（线程安全）
+  /// verifiedAt 见 LicenseStore::currentTimestamp
+  /// </summary>
+  void logVerify(const std::string& machineCode, const std::string& result,
+                 const std::string& ipAddress, const std::string& verifiedAt);
+
+  /// <summary>
+  /// 记录安全事件（线程安全）
+  /// </summary>
+  void logSecurityEvent(const std::string& eventType,
+                        const std::string& ipAddress,
+                        const std::string& details);
+
+  /// <summary>
+  /// 等待此前入队的写入全部提交
+  /// </summary>
+  void flush();
+
+  /// <summary>
+  /// 因队列已满而丢弃的条目数
+  /// </summary>
+  uint64_t dropped() const;
+
+ private:
+  struct Entry {
+    bool verify = true;  // false 为安全事件
+    std::string first;   // 机器码 / 事件类型
+    std::string second;  // 验证结果 / 详情
+    std::string ipAddress;
+    std::string verifiedAt;  // 验证时间（安全事件以提交时间记录）
+  };
+
+  Options m_options;
+  LicenseStore m_store;  // 只由后台线程使用
+  std::thread m_thread;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_flushed;
+  std::vector<Entry> m_pending;
+  uint64_t m_enqueued = 0;   // 累计入队条目数
+  uint64_t m_committed = 0;  // 累计已提交（或写入失败）的条目数
+  uint64_t m_dropped = 0;
+  bool m_flushRequested = false;
+  bool m_running = false;
+
+  void enqueue(Entry&& entry);
+  void run();
+};
@@ -13,9 +13,13 @@ from flask import Flask, request, jsonify
 from flask_cors import CORS
 import hashlib
 import hmac
+import io
 import sqlite3
 import json
 import base64
+import gzip
+import struct
+import zlib
 import time
 from datetime import datetime, timedelta
 from functools import wraps
@@ -29,6 +33,17 @@ APP_SECRET = "DEFAULT_APP_SECRET_2026_CHANGE_THIS"
 SECRET_KEY = "DEFAULT_SECRET_KEY_2026"
 DATABASE = "licenses.db"
 MAX_REQUEST_AGE = 300  # 最大请求时间差（秒）
+MAX_BATCH_SIZE = 1000  # 批量验证单次最多条目数
+
+# 压缩配置
+COMPRESS_MIN_SIZE = 1024  # 响应体达到该大小才压缩（字节）
+MAX_DECOMPRESSED_SIZE = 8 * 1024 * 1024  # 请求体解压后的上限（防压缩炸弹）
+
+# 二进制线格式（与 SecurePacketCpp::toBinary 保持一致）
+# 32 字节机器码 + 8 字节时间戳（大端）+ 16 字节 nonce + 32 字节 MAC
+BINARY_PACKET_TYPE = 'application/x-license-packet'
+BINARY_PACKET_FORMAT = '>32sq16s32s'
+BINARY_PACKET_SIZE = struct.calcsize(BINARY_PACKET_FORMAT)
 
 # 请求频率限制（简单实现）
 request_counter = {}
@@ -57,7 +72,7 @@ def verify_secure_packet(packet_json):
         packet = json.loads(packet_json)
         
         machine_code = packet.get('machine_code', '')
-        timestamp = packet.get('timestamp', 0)
+        timestamp = int(packet.get('timestamp', 0))
         nonce = packet.get('nonce', '')
         signature = packet.get('signature', '')
         
@@ -82,11 +97,60 @@ def verify_secure_packet(packet_json):
         
         return True, machine_code, None
         
-    except json.JSONDecodeError:
+    except (json.JSONDecodeError, ValueError):
         return False, None, "Invalid JSON format"
     except Exception as e:
         return False, None, f"Verification error: {str(e)}"
 
+def read_request_data(extra_field=None):
+    """
+    读取请求数据，兼容 JSON 与二进制线格式
+    二进制请求: 定长数据包 + extra_field 的原始 UTF-8 字节
+    返回: 请求字典（二进制数据包已解码到 packet_json），格式不支持时返回 None
+    """
+    if request.mimetype == BINARY_PACKET_TYPE:
+        raw = request.get_data()
+        if len(raw) < BINARY_PACKET_SIZE:
+            return None
+        
+        machine_code, timestamp, nonce, mac = struct.unpack_from(
+            BINARY_PACKET_FORMAT, raw)
+        data = {
+            'packet_json': json.dumps({
+                'machine_code': machine_code.hex(),
+                'timestamp': timestamp,
+                'nonce': nonce.decode('ascii', errors='replace'),
+                'signature': mac.hex()
+            })
+        }
+        if extra_field:
+            data[extra_field] = raw[BINARY_PACKET_SIZE:].decode(
+                'utf-8', errors='replace')
+        return data
+    
+    return request.get_json(silent=True)
+
+def read_secure_packet(data):
+    """取出数据包 JSON（JSON 请求中为 Base64 编码）"""
+    if 'packet_json' in data:
+        return data['packet_json']
+    
+    secure_packet = data.get('secure_packet', '')
+    if not secure_packet:
+        return ''
+    
+    try:
+        return base64.b64decode(secure_packet).decode('utf-8')
+    except:
+        return secure_packet
+
+def unsupported_media_type():
+    return jsonify({
+        'success': False,
+        'valid': False,
+        'message': 'Unsupported Content-Type'
+    }), 415
+
 def rate_limit(max_requests=10, window=3600):
     """
     请求频率限制装饰器
@@ -194,28 +258,99 @@ def log_security_event(event_type, details):
 # API 路由（安全版本）
 # ============================================================================
 
+class GzipRequestMiddleware:
+    """
+    WSGI 中间件：解压 Content-Encoding: gzip 的请求体（客户端超过阈值时压缩）
+    替换 wsgi.input 与 CONTENT_LENGTH，之后 get_json/get_data 读取的即为解压后的数据
+    """
+    
+    def __init__(self, wsgi_app, max_size=MAX_DECOMPRESSED_SIZE):
+        self.wsgi_app = wsgi_app
+        self.max_size = max_size
+    
+    def __call__(self, environ, start_response):
+        if environ.get('HTTP_CONTENT_ENCODING', '').lower() != 'gzip':
+            return self.wsgi_app(environ, start_response)
+        
+        try:
+            length = int(environ.get('CONTENT_LENGTH') or 0)
+        except ValueError:
+            length = 0
+        stream = environ['wsgi.input']
+        if length > 0:
+            compressed = stream.read(length)
+        elif environ.get('wsgi.input_terminated'):
+            compressed = stream.read()  # 分块传输
+        else:
+            compressed = b''
+        
+        try:
+            decompressor = zlib.decompressobj(16 + zlib.MAX_WBITS)
+            body = decompressor.decompress(compressed, self.max_size)
+            if decompressor.unconsumed_tail:
+                return self.error(start_response, '413 Request Entity Too Large',
+                                  'Request body too large')
+        except zlib.error:
+            return self.error(start_response, '400 Bad Request', 'Invalid gzip body')
+        
+        environ['wsgi.input'] = io.BytesIO(body)
+        environ['CONTENT_LENGTH'] = str(len(body))
+        environ.pop('HTTP_CONTENT_ENCODING', None)
+        environ.pop('HTTP_TRANSFER_ENCODING', None)
+        return self.wsgi_app(environ, start_response)
+    
+    @staticmethod
+    def error(start_response, status, message):
+        body = json.dumps({'success': False, 'message': message}).encode()
+        start_response(status, [('Content-Type', 'application/json'),
+                                ('Content-Length', str(len(body)))])
+        return [body]
+
+app.wsgi_app = GzipRequestMiddleware(app.wsgi_app)
+
+@app.after_request
+def compress_response(response):
+    """客户端接受 gzip 且响应体较大时压缩响应（批量验证、信息查询）"""
+    accept_encoding = request.headers.get('Accept-Encoding', '').lower()
+    if ('gzip' not in accept_encoding or response.direct_passthrough or
+            response.status_code < 200 or response.status_code >= 300 or
+            'Content-Encoding' in response.headers):
+        return response
+    
+    body = response.get_data()
+    if len(body) < COMPRESS_MIN_SIZE:
+        return response
+    
+    response.set_data(gzip.compress(body, compresslevel=6))
+    response.headers['Content-Encoding'] = 'gzip'
+    response.headers['Vary'] = 'Accept-Encoding'
+    return response
+
+@app.after_request
+def advertise_wire_formats(response):
+    """声明支持的请求体格式，客户端据此切换到二进制线格式"""
+    response.headers['Accept-Post'] = 'application/json, ' + BINARY_PACKET_TYPE
+    return response
+
 @app.route('/api/license/request', methods=['POST'])
 @rate_limit(max_requests=10, window=3600)  # 每小时最多 10 次请求
 def request_license():
     """处理许可证请求（安全版本）"""
     try:
-        data = request.get_json()
+        data = read_request_data('user_info')
+        if data is None:
+            return unsupported_media_type()
         
         # 1. 提取并验证安全数据包
-        secure_packet = data.get('secure_packet', '')
-        if not secure_packet:
+        # 2. 解析安全数据包（JSON 请求为 Base64 编码，二进制请求已解码）
+        packet_json = read_secure_packet(data)
+        if not packet_json:
             log_security_event('INVALID_REQUEST', 'Missing secure_packet')
             return jsonify({
                 'success': False,
                 'message': 'Invalid request format'
             }), 400
         
-        # 2. 解析安全数据包（如果是 Base64 编码）
-        try:
-            packet_json = base64.b64decode(secure_packet).decode('utf-8')
-        except:
-            packet_json = secure_packet
-        
         # 3. 验证数据包
         success, machine_code, error = verify_secure_packet(packet_json)
         if not success:
@@ -279,21 +414,36 @@ def request_license():
             'message': 'Server error'
         }), 500
 
+def evaluate_license_record(license_record):
+    """
+    检查许可证记录的状态与有效期
+    返回: (结果代码, 提示信息)
+    """
+    if license_record is None:
+        return 'not_found', 'License not found'
+    
+    if license_record['status'] != 'active':
+        return 'inactive', f"License is {license_record['status']}"
+    
+    if license_record['expires_at']:
+        expires_at = datetime.strptime(license_record['expires_at'], '%Y-%m-%d %H:%M:%S.%f')
+        if datetime.now() > expires_at:
+            return 'expired', 'License has expired'
+    
+    return 'success', 'License is valid'
+
 @app.route('/api/license/verify', methods=['POST'])
 @rate_limit(max_requests=100, window=3600)  # 验证请求可以更频繁
 def verify_license():
     """验证许可证（安全版本）"""
     try:
-        data = request.get_json()
+        data = read_request_data('license_key')
+        if data is None:
+            return unsupported_media_type()
         
         # 1. 验证安全数据包
-        secure_packet = data.get('secure_packet', '')
-        if secure_packet:
-            try:
-                packet_json = base64.b64decode(secure_packet).decode('utf-8')
-            except:
-                packet_json = secure_packet
-            
+        packet_json = read_secure_packet(data)
+        if packet_json:
             success, machine_code, error = verify_secure_packet(packet_json)
             if not success:
                 log_security_event('VERIFY_FAILED', f'Error: {error}')
@@ -324,79 +474,146 @@ def verify_license():
         
         client_ip = request.remote_addr
         
-        if license_record is None:
-            result = 'not_found'
+        # 3. 检查状态与有效期（与批量验证共用判定）
+        result, message = evaluate_license_record(license_record)
+        
+        if result == 'success':
             cursor.execute(
-                'INSERT INTO verify_logs (machine_code, result, ip_address) VALUES (?, ?, ?)',
-                (machine_code, result, client_ip)
+                'UPDATE licenses SET last_verified = CURRENT_TIMESTAMP WHERE machine_code = ?',
+                (machine_code,)
             )
-            conn.commit()
-            conn.close()
-            
-            log_security_event('VERIFY_NOT_FOUND', f'Machine: {machine_code[:16]}...')
-            
+        cursor.execute(
+            'INSERT INTO verify_logs (machine_code, result, ip_address) VALUES (?, ?, ?)',
+            (machine_code, result, client_ip)
+        )
+        conn.commit()
+        conn.close()
+        
+        if result != 'success':
+            if result == 'not_found':
+                log_security_event('VERIFY_NOT_FOUND', f'Machine: {machine_code[:16]}...')
             return jsonify({
                 'valid': False,
-                'message': 'License not found'
+                'message': message
             })
         
-        # 3. 检查状态
-        if license_record['status'] != 'active':
-            result = 'inactive'
-            cursor.execute(
-                'INSERT INTO verify_logs (machine_code, result, ip_address) VALUES (?, ?, ?)',
-                (machine_code, result, client_ip)
-            )
-            conn.commit()
-            conn.close()
-            
+        print(f"[LICENSE VERIFIED] Machine: {machine_code[:16]}... IP: {client_ip}")
+        
+        return jsonify({
+            'valid': True,
+            'message': 'License is valid',
+            'expires_at': license_record['expires_at']
+        })
+        
+    except Exception as e:
+        print(f"[ERROR] {str(e)}")
+        return jsonify({
+            'valid': False,
+            'message': 'Server error'
+        }), 500
+
+@app.route('/api/license/verify_batch', methods=['POST'])
+@rate_limit(max_requests=100, window=3600)
+def verify_license_batch():
+    """
+    批量验证许可证（一次请求验证多台机器）
+    数据包的 machine_code 字段为全部条目的摘要:
+    SHA256("机器码:许可证密钥\n" ...)，签名因此覆盖整个批次
+    """
+    try:
+        data = request.get_json(silent=True)
+        if data is None:
+            return unsupported_media_type()
+        
+        items = data.get('items', [])
+        if not isinstance(items, list) or not items or len(items) > MAX_BATCH_SIZE:
             return jsonify({
-                'valid': False,
-                'message': f"License is {license_record['status']}"
-            })
+                'success': False,
+                'message': f'items must contain 1-{MAX_BATCH_SIZE} entries'
+            }), 400
         
-        # 4. 检查过期
-        if license_record['expires_at']:
-            expires_at = datetime.strptime(license_record['expires_at'], '%Y-%m-%d %H:%M:%S.%f')
-            if datetime.now() > expires_at:
-                result = 'expired'
-                cursor.execute(
-                    'INSERT INTO verify_logs (machine_code, result, ip_address) VALUES (?, ?, ?)',
-                    (machine_code, result, client_ip)
-                )
-                conn.commit()
-                conn.close()
-                
-                return jsonify({
-                    'valid': False,
-                    'message': 'License has expired'
-                })
+        pairs = [(str(item.get('machine_code', '')).strip(),
+                  str(item.get('license_key', '')).strip()) for item in items]
         
-        # 5. 验证通过
-        result = 'success'
-        cursor.execute(
+        # 1. 验证安全数据包，并核对条目摘要
+        packet_json = read_secure_packet(data)
+        if not packet_json:
+            return jsonify({
+                'success': False,
+                'message': 'Invalid request format'
+            }), 400
+        
+        success, digest, error = verify_secure_packet(packet_json)
+        if success:
+            canonical = ''.join(f'{mc}:{key}\n' for mc, key in pairs)
+            expected = hashlib.sha256(canonical.encode()).hexdigest()
+            if not hmac.compare_digest(digest, expected):
+                success, error = False, 'Batch digest mismatch'
+        
+        if not success:
+            log_security_event('VERIFY_BATCH_FAILED', f'Error: {error}')
+            return jsonify({
+                'success': False,
+                'message': f'Security verification failed: {error}'
+            }), 403
+        
+        # 2. 一次查询取出全部记录（SQLite 单条语句最多 999 个参数）
+        conn = get_db_connection()
+        cursor = conn.cursor()
+        
+        records = {}
+        machine_codes = list({mc for mc, _ in pairs if mc})
+        for start in range(0, len(machine_codes), 900):
+            chunk = machine_codes[start:start + 900]
+            placeholders = ','.join('?' * len(chunk))
+            for row in cursor.execute(
+                f'SELECT * FROM licenses WHERE machine_code IN ({placeholders})',
+                chunk
+            ):
+                records[row['machine_code']] = row
+        
+        # 3. 逐条判定
+        client_ip = request.remote_addr
+        results = []
+        logs = []
+        verified = []
+        for machine_code, license_key in pairs:
+            record = records.get(machine_code)
+            if record is not None and not hmac.compare_digest(
+                    record['license_key'], license_key):
+                record = None
+            
+            result, message = evaluate_license_record(record)
+            entry = {'valid': result == 'success', 'message': message}
+            if result == 'success':
+                entry['expires_at'] = record['expires_at']
+                verified.append((machine_code,))
+            
+            results.append(entry)
+            logs.append((machine_code, result, client_ip))
+        
+        cursor.executemany(
             'UPDATE licenses SET last_verified = CURRENT_TIMESTAMP WHERE machine_code = ?',
-            (machine_code,)
+            verified
         )
-        cursor.execute(
+        cursor.executemany(
             'INSERT INTO verify_logs (machine_code, result, ip_address) VALUES (?, ?, ?)',
-            (machine_code, result, client_ip)
+            logs
         )
         conn.commit()
         conn.close()
         
-        print(f"[LICENSE VERIFIED] Machine: {machine_code[:16]}... IP: {client_ip}")
+        print(f"[LICENSE BATCH VERIFIED] {len(verified)}/{len(pairs)} valid IP: {client_ip}")
         
         return jsonify({
-            'valid': True,
-            'message': 'License is valid',
-            'expires_at': license_record['expires_at']
+            'success': True,
+            'results': results
         })
         
     except Exception as e:
         print(f"[ERROR] {str(e)}")
         return jsonify({
-            'valid': False,
+            'success': False,
             'message': 'Server error'
         }), 500
 
@@ -405,16 +622,13 @@ def verify_license():
 def get_license_info():
     """查询许可证信息（安全版本）"""
     try:
-        data = request.get_json()
+        data = read_request_data()
+        if data is None:
+            return unsupported_media_type()
         
         # 验证安全数据包
-        secure_packet = data.get('secure_packet', '')
-        if secure_packet:
-            try:
-                packet_json = base64.b64decode(secure_packet).decode('utf-8')
-            except:
-                packet_json = secure_packet
-            
+        packet_json = read_secure_packet(data)
+        if packet_json:
             success, machine_code, error = verify_secure_packet(packet_json)
             if not success:
                 return jsonify({
@@ -6,7 +6,10 @@
 import requests
 import json
 import hashlib
+import base64
 import hmac
+import secrets
+import struct
 import time
 
 # 配置
@@ -165,6 +168,98 @@ def test_license_info(machine_code):
         print(f"❌ 请求失败: {e}")
         return False
 
+def build_binary_packet(machine_code):
+    """构建二进制线格式数据包（机器码须为 64 位小写十六进制）"""
+    timestamp = int(time.time())
+    nonce = secrets.token_hex(8)
+    signature = generate_signature(machine_code, timestamp, nonce)
+    return struct.pack('>32sq16s32s', bytes.fromhex(machine_code), timestamp,
+                       nonce.encode('ascii'), bytes.fromhex(signature))
+
+def test_binary_wire_format():
+    """测试二进制线格式（application/x-license-packet）"""
+    print("\n" + "="*50)
+    print("测试 5: 二进制线格式")
+    print("="*50)
+    
+    machine_code = hashlib.sha256(b"TEST-MACHINE-CODE-123456").hexdigest()
+    headers = {"Content-Type": "application/x-license-packet"}
+    
+    try:
+        response = requests.post(
+            f"{SERVER_URL}/api/license/request",
+            data=build_binary_packet(machine_code) + b"binary@example.com",
+            headers=headers
+        )
+        print(f"Accept-Post: {response.headers.get('Accept-Post')}")
+        result = response.json()
+        if response.status_code != 200 or not result.get('success'):
+            print(f"❌ 二进制格式申请失败: {result}")
+            return False
+        
+        response = requests.post(
+            f"{SERVER_URL}/api/license/verify",
+            data=build_binary_packet(machine_code) +
+                 result['license_key'].encode('ascii'),
+            headers=headers
+        )
+        result = response.json()
+        print(f"响应: {json.dumps(result, indent=2, ensure_ascii=False)}")
+        
+        if response.status_code == 200 and result.get('valid'):
+            print("✅ 二进制格式验证成功")
+            return True
+        else:
+            print("❌ 二进制格式验证失败")
+            return False
+    except Exception as e:
+        print(f"❌ 请求失败: {e}")
+        return False
+
+def test_verify_batch(machine_code, license_key):
+    """测试批量验证（一个签名请求验证多个条目）"""
+    print("\n" + "="*50)
+    print("测试 6: 批量验证")
+    print("="*50)
+    
+    items = [
+        {"machine_code": machine_code, "license_key": license_key},
+        {"machine_code": machine_code, "license_key": "0" * 64},
+    ]
+    canonical = ''.join(f"{i['machine_code']}:{i['license_key']}\n" for i in items)
+    digest = hashlib.sha256(canonical.encode()).hexdigest()
+    
+    timestamp = int(time.time())
+    nonce = secrets.token_hex(8)
+    packet = {
+        "machine_code": digest,
+        "timestamp": timestamp,
+        "nonce": nonce,
+        "signature": generate_signature(digest, timestamp, nonce)
+    }
+    data = {
+        "secure_packet": base64.b64encode(json.dumps(packet).encode()).decode(),
+        "items": items,
+        "action": "verify_batch"
+    }
+    
+    try:
+        response = requests.post(f"{SERVER_URL}/api/license/verify_batch", json=data)
+        result = response.json()
+        print(f"响应: {json.dumps(result, indent=2, ensure_ascii=False)}")
+        
+        results = result.get('results', [])
+        if (response.status_code == 200 and len(results) == 2 and
+                results[0].get('valid') and not results[1].get('valid')):
+            print("✅ 批量验证成功")
+            return True
+        else:
+            print("❌ 批量验证失败")
+            return False
+    except Exception as e:
+        print(f"❌ 请求失败: {e}")
+        return False
+
 def main():
     """主测试流程"""
     print("\n" + "="*60)
@@ -200,6 +295,12 @@ def main():
     # 测试 4: 查询许可证信息
     test_license_info(machine_code)
     
+    # 测试 5: 二进制线格式
+    test_binary_wire_format()
+    
+    # 测试 6: 批量验证
+    test_verify_batch(machine_code, license_key)
+    
     # 总结
     print("\n" + "="*60)
     print("测试完成！")